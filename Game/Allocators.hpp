@@ -4,6 +4,7 @@
 #include "Memory.h"
 
 #include <cassert>
+#include <new>
 
 // usage: ALLOC( <allocator>, <type> )
 //    or: ALLOC( <allocator>, <type> )( <direct-init> )
@@ -100,6 +101,8 @@ class PolymorphicAllocator
 {
 public:
 
+    using Allocator::Allocator;
+
     Blk allocate( size_t n )
     {
         return Allocator::allocate( n );
@@ -118,6 +121,40 @@ public:
 
 
 
+// Refers to an allocator owned by someone else, e.g. an arena which
+// outlives every container allocating from it. Copies share the allocator.
+template< typename Allocator >
+class AllocatorRef
+{
+public:
+
+    AllocatorRef( Allocator& allocator )
+        : _pAllocator( &allocator )
+    {
+    }
+
+    Blk allocate( size_t n )
+    {
+        return _pAllocator->allocate( n );
+    }
+
+    void deallocate( Blk b )
+    {
+        _pAllocator->deallocate( b );
+    }
+
+    bool owns( void* p )
+    {
+        return _pAllocator->owns( p );
+    }
+
+private:
+
+    Allocator* _pAllocator;
+};
+
+
+
 // Provides a static instance of a default-initialized Allocator object.
 template< typename Allocator_, size_t Index = 0 >
 struct StaticAllocator
@@ -257,8 +294,8 @@ public:
     static constexpr size_t SIZE = Bytes;
     static constexpr size_t ALIGNMENT = Align;
 
-    byte* ptr = memory;  // Pointer to the top of the allocation stack.
-    byte memory[ SIZE ]; // Local store of allocatable memory.
+    byte* ptr = memory;                  // Pointer to the top of the allocation stack.
+    alignas( Align ) byte memory[ SIZE ]; // Local store of allocatable memory.
 
     Blk allocate( size_t size )
     {
@@ -292,42 +329,215 @@ private:
 };
 
 
+// Allocates blocks of up to Size bytes from Count blocks held in this
+// object, and fails larger requests. Freed blocks are linked in a list
+// through their first bytes and blocks which were never used are taken
+// in order, so allocate and deallocate are O(1).
+template< size_t Size, size_t Count >
+class SlabAllocator
+{
+public:
+
+    static constexpr size_t SIZE = Size;
+    static constexpr size_t COUNT = Count;
+
+    static_assert( SIZE >= sizeof( void* ) && SIZE % sizeof( void* ) == 0,
+                   "SlabAllocator: blocks must be able to hold a pointer" );
+
+    alignas( 16 ) byte memory[ SIZE * COUNT ];
+
+    SlabAllocator() = default;
+
+    SlabAllocator( const SlabAllocator& ) = delete;
+    SlabAllocator& operator =( const SlabAllocator& ) = delete;
+
+    Blk allocate( size_t size ) noexcept
+    {
+        if ( size > SIZE )
+            return { nullptr, 0 };
+
+        if ( _free != nullptr )
+        {
+            void* ptr = _free;
+            _free = _free->next;
+            return { ptr, size };
+        }
+
+        if ( _used == COUNT )
+            return { nullptr, 0 };
+
+        return { memory + SIZE * _used++, size };
+    }
+
+    void deallocate( Blk blk ) noexcept
+    {
+        if ( blk.ptr == nullptr )
+            return;
+
+        assert( owns( blk.ptr ) );
+        _free = new( blk.ptr ) _Node { _free };
+    }
+
+    constexpr bool owns( void* ptr )
+    {
+        return memory <= ptr && ptr < memory + SIZE * COUNT;
+    }
+
+private:
+
+    struct _Node
+    {
+        _Node* next;
+    };
+
+    _Node* _free = nullptr; // Most recently freed block.
+    size_t _used = 0;       // Blocks taken in order so far.
+};
+
+
+// Routes every request to the first (smallest) size class that fits it
+// and has a free block, and to malloc if none does. SizeClasses are
+// SlabAllocators in increasing order of size; the allocator is a chain of
+// FallbackAllocators, so a full class overflows into the next one.
+// Overflow is silent: nothing is counted or reported, a small block may
+// then take a larger class's slot (so that class fills sooner), and once
+// the largest class is full every request goes to malloc. Size the
+// classes for the peak number of live blocks.
+template< typename... SizeClasses >
+class SegregatedAllocator
+    : public Mallocator
+{
+};
+
+template< typename SizeClass, typename... Larger >
+class SegregatedAllocator< SizeClass, Larger... >
+    : public FallbackAllocator< SizeClass, SegregatedAllocator< Larger... > >
+{
+};
+
+
+// Memory for data which only lives for a frame. Allocations come from one
+// of two stacks, and flip() switches to the other stack and empties it,
+// so a block stays valid until the end of the frame after the one it was
+// allocated in. Deallocation is ignored for all but the most recent block.
+// Requests which don't fit are passed to malloc and counted.
+template< size_t Bytes, size_t Align = 16 >
+class FrameArena
+{
+public:
+
+    using Stack = StackAllocator< Bytes / 2, Align >;
+
+    size_t mallocs = 0; // Blocks passed to malloc since the last flip.
+
+    FrameArena() = default;
+
+    FrameArena( const FrameArena& ) = delete;
+    FrameArena& operator =( const FrameArena& ) = delete;
+
+    Blk allocate( size_t size )
+    {
+        Blk blk = _stacks[ _current ].allocate( size );
+        if ( blk.ptr == nullptr )
+        {
+            ++mallocs;
+            blk = Mallocator().allocate( size );
+        }
+        return blk;
+    }
+
+    void deallocate( Blk blk )
+    {
+        if ( blk.ptr == nullptr )
+            return;
+
+        for ( Stack& stack : _stacks )
+        {
+            if ( stack.owns( blk.ptr ) )
+            {
+                stack.deallocate( blk );
+                return;
+            }
+        }
+        Mallocator().deallocate( blk );
+    }
+
+    bool owns( void* ptr )
+    {
+        return _stacks[ 0 ].owns( ptr ) || _stacks[ 1 ].owns( ptr );
+    }
+
+    // Starts a new frame; the blocks of the frame before the last become
+    // invalid. Returns the mallocs of the frame which just ended.
+    size_t flip()
+    {
+        _current ^= 1;
+        _stacks[ _current ].ptr = _stacks[ _current ].memory;
+
+        size_t frameMallocs = mallocs;
+        mallocs = 0;
+        return frameMallocs;
+    }
+
+private:
+
+    Stack  _stacks[ 2 ];
+    size_t _current = 0;
+};
+
+
 // Allocates memory from this object to its users. Maps individual allocation
 // units of length Align to bits in a bitset. The overhead cost of this type
 // in bytes is (Bytes / Align / 8) or O(n/8).
-template< size_t Bytes, size_t Align = sizeof( int ) >
+// Free runs are found a word at a time with count_trailing_zeros. The
+// search starts where the last allocation ended (next-fit), so it doesn't
+// rescan the full front of the memory on every call. With Summary, a
+// second bitset marks the words which are full, and the search skips 64
+// of them (4096 units) at a time.
+template< size_t Bytes, size_t Align = sizeof( int ),
+          bool Summary = (Bytes / Align > 64 * 64) >
 class BitsetAllocator
 {
 public:
 
-    using Word = unsigned __int64;
+    using Word = std::uint64_t;
 
     static constexpr size_t SIZE = Bytes;
     static constexpr size_t ALIGNMENT = Align;
     static constexpr size_t BITS_PER_WORD = 8 * sizeof( Word );
+    static constexpr size_t UNITS = SIZE / ALIGNMENT;
+    static constexpr size_t WORDS = (UNITS + BITS_PER_WORD - 1) / BITS_PER_WORD;
 
     static_assert( SIZE % ALIGNMENT == 0, "" );
 
-    Word bitset[ SIZE / ALIGNMENT / BITS_PER_WORD + 1 ] = { 0 };
-    byte memory[ SIZE ];
+    Word bitset[ WORDS ] = { 0 };          // Bit per unit; set if it's allocated.
+    alignas( Align ) byte memory[ SIZE ];
+
+    BitsetAllocator() noexcept
+    {
+        // The bits past the last unit are kept set, so they're never free.
+        if ( UNITS % BITS_PER_WORD )
+            _setRange( UNITS, BITS_PER_WORD - UNITS % BITS_PER_WORD, true );
+    }
 
     Blk allocate( size_t size ) noexcept
     {
-        size_t rounded_size = _round_to_aligned( size );
-        size_t bitlen = rounded_size / ALIGNMENT;
+        size_t bitlen = std::max< size_t >( _round_to_aligned( size ) / ALIGNMENT, 1 );
 
-        for ( size_t pos = 0; pos < SIZE - rounded_size; )
-        {
-            if ( _checkRange( pos, bitlen, false, &pos ) )
-            {
-                _setRange( pos, bitlen, true );
-                #ifdef _DEBUG
-                std::memset( memory + pos, 0xbb, size );
-                #endif
-                return { memory + pos, size };
-            }
-        }
-        return { nullptr, size };
+        size_t pos = _search( _cursor, UNITS, bitlen );
+        if ( pos == UNITS )
+            pos = _search( 0, _cursor, bitlen );
+
+        if ( pos == UNITS )
+            return { nullptr, size };
+
+        _setRange( pos, bitlen, true );
+        _cursor = pos + bitlen < UNITS ? pos + bitlen : 0;
+
+        #ifdef _DEBUG
+        std::memset( memory + pos * ALIGNMENT, 0xbb, size );
+        #endif
+        return { memory + pos * ALIGNMENT, size };
     }
 
     void deallocate( Blk blk ) noexcept
@@ -339,9 +549,8 @@ public:
         #ifdef _DEBUG
         blk.set( 0xdd );
         #endif
-        size_t pos = (byte*) blk.ptr - memory;
-        size_t bitlen = _round_to_aligned( blk.size ) / ALIGNMENT;
-        //assert( _checkRange( pos, bitlen, true ) );
+        size_t pos = ((byte*) blk.ptr - memory) / ALIGNMENT;
+        size_t bitlen = std::max< size_t >( _round_to_aligned( blk.size ) / ALIGNMENT, 1 );
         _setRange( pos, bitlen, false );
     }
 
@@ -352,95 +561,103 @@ public:
 
 private:
 
-    // Sets a range in the bitset to bit.
-    void _setRange( size_t pos, size_t len, bool bit ) noexcept
-    {
-        Word* pWord0 = &bitset[ pos / BITS_PER_WORD ];
-        size_t idx0 = pos % BITS_PER_WORD;
+    static constexpr size_t SUMMARY_WORDS = Summary ? (WORDS + BITS_PER_WORD - 1) / BITS_PER_WORD : 1;
 
-        Word* pWord1 = &bitset[ (pos + len) / BITS_PER_WORD ];
-        size_t idx1 = BITS_PER_WORD - (pos + len) % BITS_PER_WORD;
+    Word   _full[ SUMMARY_WORDS ] = { 0 }; // Bit per word of bitset; set if it's all 1s.
+    size_t _cursor = 0;                    // Unit after the most recent allocation.
 
-        for ( Word* pWord = pWord0; pWord <= pWord1; ++pWord )
+    // Returns the first unit of a run of len free units which starts in
+    // [from, to), or UNITS if there isn't one. The run may end past to.
+    size_t _search( size_t from, size_t to, size_t len ) const noexcept
+    {
+        size_t pos = from;
+        while ( pos < to )
         {
-            Word mask = ~0;
+            pos = _next( pos, false, to );
+            if ( pos == to )
+                break;
 
-            if ( pWord == pWord0 )
-                mask = mask >> idx0 << idx0;
+            // Only look as far as the run needs to reach.
+            size_t end = _next( pos, true, std::min( pos + len, size_t( UNITS ) ) );
+            if ( end - pos == len )
+                return pos;
 
-            if ( pWord == pWord1 )
-                mask = mask << idx1 >> idx1;
-
-            if ( bit )
-                *pWord |= mask;
-            else
-                *pWord &= ~mask;
+            pos = end;
         }
+        return UNITS;
     }
 
-    // Returns true if all bits in the range in bitset are equal to bit.
-    // Otherwise, sets outpos to the index of the first failing bit and
-    // returns false.
-    bool _checkRange( size_t pos, size_t len, bool bit,
-                      size_t* outpos = nullptr ) const noexcept
+    // Returns the first unit in [pos, limit) whose bit equals bit, or
+    // limit if there isn't one.
+    size_t _next( size_t pos, bool bit, size_t limit ) const noexcept
     {
-        const Word* pWord0 = &bitset[ pos / BITS_PER_WORD ];
-        size_t idx0 = pos % BITS_PER_WORD;
-
-        const Word* pWord1 = &bitset[ (pos + len) / BITS_PER_WORD ];
-        size_t idx1 = BITS_PER_WORD - (pos + len) % BITS_PER_WORD;
-
-        for ( const Word* pWord = pWord0; pWord <= pWord1; ++pWord )
+        while ( pos < limit )
         {
-            Word mask = ~0;
-
-            if ( pWord == pWord0 )
-                mask = mask >> idx0 << idx0;
+            size_t w = pos / BITS_PER_WORD;
 
-            if ( pWord == pWord1 )
-                mask = mask << idx1 >> idx1;
-
-            if ( (*pWord & mask) != (bit ? mask : 0) )
+            if ( Summary && !bit && pos % BITS_PER_WORD == 0 )
             {
-                if ( outpos != nullptr )
+                size_t open = _nextOpenWord( w );
+                if ( open != w )
                 {
-                    size_t offset = _skip( *pWord, mask, bit ) * ALIGNMENT;
-                    size_t chunk = (pWord - bitset) * BITS_PER_WORD;
-                    *outpos = _round_to_aligned( chunk + offset );
+                    pos = open * BITS_PER_WORD;
+                    continue;
                 }
-                return false;
             }
+
+            Word word = bit ? bitset[ w ] : ~bitset[ w ];
+            word &= ~Word( 0 ) << (pos % BITS_PER_WORD);
+
+            if ( word != 0 )
+                return std::min( w * BITS_PER_WORD + count_trailing_zeros( word ), limit );
+
+            pos = (w + 1) * BITS_PER_WORD;
         }
-        return true;
+        return limit;
     }
 
-    static size_t _skip( Word word, Word mask, bool bit )
+    // Returns the first word from w on which isn't full, or WORDS.
+    size_t _nextOpenWord( size_t w ) const noexcept
     {
-        size_t offset;
-        if ( bit ) {
-            offset =  _first_0( word & mask );    // Skip 1s
-            offset += _first_1( word >> offset ); // Skip 0s
-        } else {
-            offset =  _first_1( word & mask );    // Skip 0s
-            offset += _first_0( word >> offset ); // Skip 1s
+        while ( w < WORDS )
+        {
+            Word open = ~_full[ w / BITS_PER_WORD ] & (~Word( 0 ) << (w % BITS_PER_WORD));
+            if ( open != 0 )
+                return std::min( w / BITS_PER_WORD * BITS_PER_WORD + count_trailing_zeros( open ), size_t( WORDS ) );
+
+            w = (w / BITS_PER_WORD + 1) * BITS_PER_WORD;
         }
-        return std::min( offset, BITS_PER_WORD );
+        return WORDS;
     }
 
-    static size_t _first_1( Word word )
+    // Sets a range in the bitset to bit.
+    void _setRange( size_t pos, size_t len, bool bit ) noexcept
     {
-        size_t pos = 0;
-        while ( !(word & 1) && ++pos < BITS_PER_WORD )
-            word >>= 1;
-        return pos;
-    }
+        while ( len > 0 )
+        {
+            size_t w = pos / BITS_PER_WORD;
+            size_t idx = pos % BITS_PER_WORD;
+            size_t n = std::min( len, BITS_PER_WORD - idx );
 
-    static size_t _first_0( Word word )
-    {
-        size_t pos = 0;
-        while ( (word & 1) && ++pos < BITS_PER_WORD )
-            word >>= 1;
-        return pos;
+            Word mask = n == BITS_PER_WORD ? ~Word( 0 ) : ((Word( 1 ) << n) - 1) << idx;
+
+            if ( bit )
+                bitset[ w ] |= mask;
+            else
+                bitset[ w ] &= ~mask;
+
+            if ( Summary )
+            {
+                Word full = Word( 1 ) << (w % BITS_PER_WORD);
+                if ( bitset[ w ] == ~Word( 0 ) )
+                    _full[ w / BITS_PER_WORD ] |= full;
+                else
+                    _full[ w / BITS_PER_WORD ] &= ~full;
+            }
+
+            pos += n;
+            len -= n;
+        }
     }
 
     static constexpr size_t _round_to_aligned( size_t size )
@@ -3,6 +3,8 @@
 
 #include "Allocators.hpp"
 
+#include <new>
+
 namespace context_allocator
 {
     IAllocator& get();
@@ -11,6 +13,57 @@ namespace context_allocator
     void pop();
 }
 
+// Standard library allocator which allocates from the allocator on top of
+// the context stack at the time it's made. Containers keep that allocator
+// when the stack changes, so a container made while a frame arena is on
+// top must not outlive the arena's frames.
+template< typename T >
+class ContextStlAllocator
+{
+public:
+
+    using value_type = T;
+
+    IAllocator* pAllocator;
+
+    ContextStlAllocator()
+        : pAllocator( &context_allocator::get() )
+    {
+    }
+
+    template< typename U >
+    ContextStlAllocator( const ContextStlAllocator< U >& other )
+        : pAllocator( other.pAllocator )
+    {
+    }
+
+    T* allocate( size_t n )
+    {
+        Blk blk = pAllocator->allocate( n * sizeof( T ) );
+        if ( blk.ptr == nullptr )
+            throw std::bad_alloc();
+
+        return (T*) blk.ptr;
+    }
+
+    void deallocate( T* ptr, size_t n )
+    {
+        pAllocator->deallocate( { ptr, n * sizeof( T ) } );
+    }
+};
+
+template< typename T, typename U >
+bool operator ==( const ContextStlAllocator< T >& lhs, const ContextStlAllocator< U >& rhs )
+{
+    return lhs.pAllocator == rhs.pAllocator;
+}
+
+template< typename T, typename U >
+bool operator !=( const ContextStlAllocator< T >& lhs, const ContextStlAllocator< U >& rhs )
+{
+    return !(lhs == rhs);
+}
+
 #define context_alloc( TYPE ) ALLOC( context_allocator::get(), TYPE )
 #define context_alloc_n( TYPE, LENGTH ) ALLOC_N( context_allocator::get(), TYPE, LENGTH )
 #define context_dealloc( BLOCK ) DEALLOC( context_allocator::get(), BLOCK )
@@ -100,54 +100,50 @@ namespace odin
 		template< typename T >
 		void make_player(T* pScene, EntityId eid, Vec2 pos, uint16_t playerNum)
 		{
-			pScene->entities[eid];
-			pScene->entities[{ "playes", playerNum }];
+			EntityId armid{ "playes", playerNum };
 
-			decltype(auto) ntt = pScene->entities[eid];
-			ntt.position = pos;
-			ntt.setBase(typename T::EntityPlayerType{ playerNum, pScene });
+			pScene->transform(eid).position = pos;
+			pScene->entities[eid].setBase(typename T::EntityPlayerType{ playerNum, pScene });
 
-			ntt.pDrawable = pScene->newGraphics(GraphicalComponent::makeRect(playerDim.x, playerDim.y));
+			auto& gfx = pScene->attach(eid, GraphicalComponent::makeRect(playerDim.x, playerDim.y));
 
 			//assign different color spritesheet for each player
 			switch (playerNum) {
 			case 0:
-				ntt.pDrawable->texture = PLAYER1_TEXTURE;
+				gfx.texture = PLAYER1_TEXTURE;
 				break;
 			case 1:
-				ntt.pDrawable->texture = PLAYER2_TEXTURE;
+				gfx.texture = PLAYER2_TEXTURE;
 				break;
 			case 2:
-				ntt.pDrawable->texture = PLAYER3_TEXTURE;
+				gfx.texture = PLAYER3_TEXTURE;
 				break;
 			case 3:
-				ntt.pDrawable->texture = PLAYER4_TEXTURE;
+				gfx.texture = PLAYER4_TEXTURE;
 				break;
 			}
 
-			decltype(auto) nttarm = pScene->entities[{ "playes", playerNum }];
-
 			//add arm
-			nttarm.pDrawable = pScene->newGraphics(GraphicalComponent::makeRect(playerDim.x, playerDim.y));
-			nttarm.pDrawable->texture = ARM_TEXTURE;
-			nttarm.pDrawable->visible = false;
+			auto& armGfx = pScene->attach(armid, GraphicalComponent::makeRect(playerDim.x, playerDim.y));
+			armGfx.texture = ARM_TEXTURE;
+			armGfx.visible = false;
 			//idle 10 frame, run 10 frame, jump 3 frame, shoot 3 frame (one armed, one armless)	
 //get_components< AnimatorComponent >( pScene ).add( eid, { 10, 10, 3, 3, 10, 10, 3, 3 } );
 
-			ntt.pAnimator = pScene->newAnimator({ 10, 10, 3, 3, 10, 10, 3, 3, 2, 10 });
+			pScene->attach(eid, AnimatorComponent({ 10, 10, 3, 3, 10, 10, 3, 3, 2, 10 }));
 
 			//Set up arm
 																//5 x shoot animation at 4 frames per anim
-			nttarm.pAnimator = pScene->newAnimator({ 4, 4, 4, 4, 4 });
-			nttarm.pAnimator->play = false;
-			nttarm.pAnimator->loop = false;
+			auto& armAnim = pScene->attach(armid, AnimatorComponent({ 4, 4, 4, 4, 4 }));
+			armAnim.play = false;
+			armAnim.loop = false;
 
 			b2BodyDef playerDef;
 			playerDef.position = pos;
 			playerDef.fixedRotation = true;
 			playerDef.type = b2_dynamicBody;
 			playerDef.gravityScale = 2;
-			playerDef.userData = ntt.base();
+			playerDef.userData = odin::body_user_data(pScene->entities[eid].handle);
 
 			// get player rec
 			auto pRec = PhysicalComponent::makeRect(playerDim.getPhysicsDim().x / 2, playerDim.getPhysicsDim().y, pScene->b2world, playerDef, 1.0, PLAYER, PLATFORM | PLAYER | BULLET);
@@ -166,7 +162,7 @@ namespace odin
 			//footSensorFixture->SetUserData((void*)3);
 			
 			// assign player phys to entity
-			ntt.pBody = pRec.pBody;
+			pScene->attach(eid, pRec.pBody);
 			pRec.pBody = nullptr;
 
 			//a,rm
@@ -176,18 +172,14 @@ namespace odin
 
 			//player arm physics component
 			auto paFsx = PhysicalComponent::makeRect(playerDim.getPhysicsDim().x, playerDim.getPhysicsDim().y, pScene->b2world, armDef, 1.0, PLAYER_ARM, 0);
-			nttarm.pBody = paFsx.pBody;
+			pScene->attach(armid, paFsx.pBody);
 			paFsx.pBody = nullptr;
 		}
 
 		template< typename T >
 		void make_horse(T* pScene, EntityId eid, Vec2 pos)
 		{
-			decltype(auto) ntt = pScene->entities[eid];
-
-
-			ntt.pDrawable = pScene->newGraphics(GraphicalComponent::makeRect(horse.x, horse.y));
-			ntt.pDrawable->texture = HORSE_TEXTURE;
+			pScene->attach(eid, GraphicalComponent::makeRect(horse.x, horse.y)).texture = HORSE_TEXTURE;
 
 			b2BodyDef horseDef;
 			horseDef.position = pos;
@@ -196,7 +188,7 @@ namespace odin
 			horseDef.gravityScale = 2;
 
 			auto hFsx = PhysicalComponent::makeRect(horse.getPhysicsDim().x, horse.getPhysicsDim().y, pScene->b2world, horseDef, 1.0, HORSE, PLATFORM);
-			ntt.pBody = hFsx.pBody;
+			pScene->attach(eid, hFsx.pBody);
 			hFsx.pBody = nullptr;
 		}
 
@@ -223,19 +215,22 @@ namespace odin
 			EntityId eid;
 			uint16_t physID = 0;
 			uint16 i;
+
+			// Name every tile, plus the physics entity after them, in one go.
+			std::vector<EntityId> eids;
+			eids.reserve(length + 1);
+			for (i = 0; i <= length; i++)
+				eids.push_back({ id, i });
+			pScene->spawn(eids.data(), eids.size());
+
 			for (i = 0; i < length; i++)
 			{
 				eid = { id, i };
-				decltype(auto) ntt = pScene->entities[eid];
-
-
 				pos.x += platform.x / 2;
 
-				ntt.position = pos;
-				ntt.pDrawable = pScene->newGraphics(
-					GraphicalComponent::makeRect(platform.x, platform.y, { 1,1,1 }));
-
-				ntt.pDrawable->texture = text;
+				pScene->transform(eid).position = pos;
+				pScene->attach(eid,
+					GraphicalComponent::makeRect(platform.x, platform.y, { 1,1,1 })).texture = text;
 				//makeRect(scene, { id, i }, { 1, 1 }, pos, 0, { 1,1,1 }, GROUND1);
 
 				pos.x += platform.x / 2;
@@ -244,8 +239,7 @@ namespace odin
 
 			// define another entity for the floors physics only
 			eid = { id, physID };
-			decltype(auto) ntt = pScene->entities[eid];
-			ntt.position = { pos.x + (platform.x*length),pos.y };
+			pScene->transform(eid).position = { pos.x + (platform.x*length),pos.y };
 
 			b2BodyDef bodyDef;
 			bodyDef.position = { offset.x / physicsScale + (platform.getPhysicsDim().x*length) / 2 ,offset.y / physicsScale - 0.1f};
@@ -253,7 +247,7 @@ namespace odin
 			bodyDef.type = b2_staticBody;
 
 			auto pb = PhysicalComponent::makeRect(platform.getPhysicsDim().x*length - 1, platform.getPhysicsDim().y + 0.1, pScene->b2world, bodyDef, 1.0, PLATFORM,  PLAYER | BULLET | DEAD_ENTITY);
-			ntt.pBody = pb.pBody;
+			pScene->attach(eid, pb.pBody);
 			pb.pBody = nullptr;
 		}
 	}
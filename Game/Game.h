@@ -33,6 +33,9 @@ public:
 
 	bool running = false;
 
+    // Job system activity during the last frame.
+    odin::JobStats jobStats = {};
+
     static constexpr double TGT_FRAME_TIME_S = 1 / 60.0;
     static constexpr unsigned TGT_FRAME_TIME_MS = unsigned( TGT_FRAME_TIME_S * 1000 );
 
@@ -76,6 +79,8 @@ public:
 
         audioEngine.update();
 
+        jobStats = odin::job_system().endFrame();
+
         glBindFramebuffer( GL_FRAMEBUFFER, 0 );
         glViewport( 0, 0, _width, _height );
         glClear( GL_COLOR_BUFFER_BIT );
@@ -103,7 +108,8 @@ public:
         if ( frameTime_ms <= TGT_FRAME_TIME_MS )
             SDL_Delay( TGT_FRAME_TIME_MS - frameTime_ms );
         else
-            printf( "Frame %ims slow\n", frameTime_ms - TGT_FRAME_TIME_MS );
+            printf( "Frame %ims slow (%zu jobs, workers %.0f%% busy)\n",
+                    frameTime_ms - TGT_FRAME_TIME_MS, jobStats.jobsRun, jobStats.utilisation * 100 );
     }
  
 };
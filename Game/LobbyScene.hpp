@@ -51,13 +51,9 @@ public:
 
     static constexpr size_t COMP_MAX = 20;
 
-    template< typename T >
-    using Components = TypedAllocator< T, COMP_MAX >;
-
+    odin::Registry       registry;
     EntityMap< Entity2 > entities;
 
-    Components< GraphicalComponent > graphics;
-
 
     std::string         audioBankName;
     AudioEngine*        pAudioEngine;
@@ -69,6 +65,8 @@ public:
     GLint uMatrix, uColor, uTexture, uFacingDirection,
         uCurrentFrame, uCurrentAnim, uMaxFrame, uMaxAnim, uSilhoutte, uInteractive;
 
+    odin::SpriteBatch spriteBatch;
+
     static constexpr int MAX_PLAYERS = odin::ControllerManager::MAX_PLAYERS;
 
     bool playerConnected[ MAX_PLAYERS ];
@@ -90,19 +88,20 @@ public:
         , uMaxAnim( glGetUniformLocation( program, "uTotalAnim" ) )
         , uSilhoutte( glGetUniformLocation( program, "uSilhoutte" ) )
         , uInteractive( glGetUniformLocation( program, "uInteractive" ) )
+        , spriteBatch( load_shaders( "Shaders/vertexInstanced.glsl", "Shaders/fragmentInstanced.glsl" ), COMP_MAX )
     {
         for ( int i = 0; i < MAX_PLAYERS; ++i )
             playerSlot[ i ] = i;
     }
 
-    GraphicalComponent* newGraphics( GraphicalComponent gfx )
-    {
-        return ALLOC( graphics, GraphicalComponent )(std::move( gfx ));
-    }
-
-    void deleteComponent( GraphicalComponent* gfx )
+    // Creates a named entity with a transform and a drawable.
+    GraphicalComponent& newSprite( EntityId eid, glm::vec2 pos, GraphicalComponent gfx )
     {
-        DEALLOC( graphics, gfx );
+        Entity2& ntt = entities[ eid ];
+        if ( !registry.valid( ntt.handle ) )
+            ntt.handle = registry.create();
+        registry.emplace< Transform >( ntt.handle, pos );
+        return registry.emplace< GraphicalComponent >( ntt.handle, std::move( gfx ) );
     }
 
     void init( unsigned ticks ) override
@@ -117,46 +116,22 @@ public:
                                     FMOD_STUDIO_LOAD_BANK_NORMAL );
         }
 
-        auto& p0 = entities[ { "player", 0 } ];
-        p0.position = { -150, 0 };
-        p0.pDrawable = newGraphics( GraphicalComponent::makeRect( 94, 168 ) );
-        p0.pDrawable->texture = PLAYER_0_CARD;
-
-        auto& p1 = entities[ { "player", 1 } ];
-        p1.position = { -50, 0 };
-        p1.pDrawable = newGraphics( GraphicalComponent::makeRect( 94, 168 ) );
-        p1.pDrawable->texture = PLAYER_1_CARD;
-
-        auto& p2 = entities[ { "player", 2 } ];
-        p2.position = { 50, 0 };
-        p2.pDrawable = newGraphics( GraphicalComponent::makeRect( 94, 168 ) );
-        p2.pDrawable->texture = PLAYER_2_CARD;
-
-        auto& p3 = entities[ { "player", 3 } ];
-        p3.position = { 150, 0 };
-        p3.pDrawable = newGraphics( GraphicalComponent::makeRect( 94, 168 ) );
-        p3.pDrawable->texture = PLAYER_3_CARD;
-
-
-        auto& c0 = entities[ { "gpad", 0 } ];
-        c0.position = { -150, -100 };
-        c0.pDrawable = newGraphics( GraphicalComponent::makeRect( 32, 32 ) );
-        c0.pDrawable->texture = 1;
-
-        auto& c1 = entities[ { "gpad", 1 } ];
-        c1.position = { -50, -100 };
-        c1.pDrawable = newGraphics( GraphicalComponent::makeRect( 32, 32 ) );
-        c1.pDrawable->texture = 2;
-
-        auto& c2 = entities[ { "gpad", 2 } ];
-        c2.position = { 50, -100 };
-        c2.pDrawable = newGraphics( GraphicalComponent::makeRect( 32, 32 ) );
-        c2.pDrawable->texture = 3;
-
-        auto& c3 = entities[ { "gpad", 3 } ];
-        c3.position = { 150, -100 };
-        c3.pDrawable = newGraphics( GraphicalComponent::makeRect( 32, 32 ) );
-        c3.pDrawable->texture = 4;
+        newSprite( { "player", 0 }, { -150, 0 }, GraphicalComponent::makeRect( 94, 168 ) ).texture = PLAYER_0_CARD;
+
+        newSprite( { "player", 1 }, { -50, 0 }, GraphicalComponent::makeRect( 94, 168 ) ).texture = PLAYER_1_CARD;
+
+        newSprite( { "player", 2 }, { 50, 0 }, GraphicalComponent::makeRect( 94, 168 ) ).texture = PLAYER_2_CARD;
+
+        newSprite( { "player", 3 }, { 150, 0 }, GraphicalComponent::makeRect( 94, 168 ) ).texture = PLAYER_3_CARD;
+
+
+        newSprite( { "gpad", 0 }, { -150, -100 }, GraphicalComponent::makeRect( 32, 32 ) ).texture = 1;
+
+        newSprite( { "gpad", 1 }, { -50, -100 }, GraphicalComponent::makeRect( 32, 32 ) ).texture = 2;
+
+        newSprite( { "gpad", 2 }, { 50, -100 }, GraphicalComponent::makeRect( 32, 32 ) ).texture = 3;
+
+        newSprite( { "gpad", 3 }, { 150, -100 }, GraphicalComponent::makeRect( 32, 32 ) ).texture = 4;
     }
 
     void exit( unsigned ticks ) override
@@ -287,8 +262,8 @@ public:
             float alpha = playerConnected[ i ] ? playerReady[ i ] ? 1.0 : 0.5 : 0.2;
 
             uint16_t j = playerSlot[ i ];
-            entities[ { "player", j } ].pDrawable->color.a = alpha;
-            entities[ { "gpad", j } ].pDrawable->color.a = alpha;
+            registry.get< GraphicalComponent >( entities[ { "player", j } ].handle ).color.a = alpha;
+            registry.get< GraphicalComponent >( entities[ { "gpad", j } ].handle ).color.a = alpha;
         }
 
         int validPlayers = 0;
@@ -325,34 +300,20 @@ public:
         float aspect = width / (float)height;
         mat4 cameraMatrix = scale({}, vec3(zoom, zoom * aspect, 1));
 
-        glUseProgram( program );
+        spriteBatch.begin( cameraMatrix );
 
         for ( auto x : entities )
         {
-            Entity2& ntt = x.value;
+            odin::Handle e = x.value.handle;
 
-            if ( auto drawable = ntt.pDrawable )
+            if ( auto drawable = registry.find< GraphicalComponent >( e ) )
             {
-                if ( !drawable->visible )
-                    continue;
-
-                mat4 mtx = translate( cameraMatrix, vec3( ntt.position, 0 ) );
-                mtx = rotate( mtx, ntt.rotation, vec3( 0, 0, 1 ) );
-
-                glUniform( uMatrix, mtx );
-                glUniform( uColor, drawable->color );
-                glUniform( uTexture, drawable->texture );
-                glUniform( uFacingDirection, drawable->direction );
-
-                glUniform( uCurrentAnim, 0.f );
-                glUniform( uCurrentFrame, 0.f );
-                glUniform( uMaxFrame, 1.f );
-                glUniform( uMaxAnim, 1.f );
-
-                glBindVertexArray( drawable->vertexArray );
-                glDrawArrays( GL_TRIANGLES, 0, drawable->count );
+                Transform& tf = registry.get< Transform >( e );
+                spriteBatch.add( *drawable, nullptr, tf.position, tf.rotation );
             }
         }
+
+        spriteBatch.end();
     }
 
 };
@@ -2,11 +2,16 @@
 #pragma once
 
 #include <algorithm>
+#include <cstdint>
 #include <cstring>
 #include <malloc.h>
 #include <vector>
 
-using byte = unsigned __int8; // 8-bit bitfield.
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+using byte = std::uint8_t; // 8-bit bitfield.
 
 // Represents a unit of allocated memory.
 struct Blk
@@ -93,3 +98,29 @@ struct Array
         std::fill( array, array + count, val );
     }
 };
+
+// Returns the index of the lowest set bit of word, which must not be 0.
+inline size_t count_trailing_zeros( std::uint64_t word )
+{
+#if defined( _MSC_VER ) && defined( _M_X64 )
+    unsigned long index;
+    _BitScanForward64( &index, word );
+    return index;
+#elif defined( _MSC_VER )
+    unsigned long index;
+    if ( _BitScanForward( &index, (unsigned long) word ) )
+        return index;
+    _BitScanForward( &index, (unsigned long) (word >> 32) );
+    return index + 32;
+#elif defined( __GNUC__ )
+    return __builtin_ctzll( word );
+#else
+    size_t index = 0;
+    while ( !(word & 1) )
+    {
+        word >>= 1;
+        ++index;
+    }
+    return index;
+#endif
+}
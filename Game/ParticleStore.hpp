@@ -0,0 +1,132 @@
+// Andrew Meckling
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <vector>
+
+#if defined( __SSE__ ) || defined( _M_X64 ) || (defined( _M_IX86_FP ) && _M_IX86_FP >= 1)
+#define OHT_PARTICLE_SSE 1
+#include <xmmintrin.h>
+#endif
+
+// Structure-of-arrays storage for particles. Every attribute lives in its
+// own contiguous float array so the update can process four particles per
+// instruction. Expired particles are removed by moving the last particle
+// into their slot, so the order of particles is not stable.
+class ParticleStore
+{
+public:
+
+    std::vector< float > lifetime;
+    std::vector< float > r, g, b, a;
+    std::vector< float > px, py;
+    std::vector< float > vx, vy;
+
+    size_t size() const
+    {
+        return lifetime.size();
+    }
+
+    bool empty() const
+    {
+        return lifetime.empty();
+    }
+
+    void reserve( size_t n )
+    {
+        for ( auto* arr : _arrays() )
+            arr->reserve( n );
+    }
+
+    void clear()
+    {
+        for ( auto* arr : _arrays() )
+            arr->clear();
+    }
+
+    void push( float life, glm::vec4 color, glm::vec2 pos, glm::vec2 vel )
+    {
+        lifetime.push_back( life );
+        r.push_back( color.r );
+        g.push_back( color.g );
+        b.push_back( color.b );
+        a.push_back( color.a );
+        px.push_back( pos.x );
+        py.push_back( pos.y );
+        vx.push_back( vel.x );
+        vy.push_back( vel.y );
+    }
+
+    // Applies gravity, integrates positions, fades alpha by fadeRate
+    // per second and decrements lifetimes.
+    void integrate( float timeStep, float gravity, float fadeRate )
+    {
+        const size_t n = size();
+        const float dvy = gravity * timeStep;
+        const float da = fadeRate * timeStep;
+        size_t i = 0;
+
+        #ifdef OHT_PARTICLE_SSE
+        const __m128 vStep = _mm_set1_ps( timeStep );
+        const __m128 vDvy = _mm_set1_ps( dvy );
+        const __m128 vDa = _mm_set1_ps( da );
+
+        for ( ; i + 4 <= n; i += 4 )
+        {
+            __m128 velY = _mm_add_ps( _mm_loadu_ps( &vy[ i ] ), vDvy );
+            __m128 velX = _mm_loadu_ps( &vx[ i ] );
+            _mm_storeu_ps( &vy[ i ], velY );
+
+            __m128 posX = _mm_add_ps( _mm_loadu_ps( &px[ i ] ), _mm_mul_ps( velX, vStep ) );
+            __m128 posY = _mm_add_ps( _mm_loadu_ps( &py[ i ] ), _mm_mul_ps( velY, vStep ) );
+            _mm_storeu_ps( &px[ i ], posX );
+            _mm_storeu_ps( &py[ i ], posY );
+
+            _mm_storeu_ps( &a[ i ], _mm_sub_ps( _mm_loadu_ps( &a[ i ] ), vDa ) );
+            _mm_storeu_ps( &lifetime[ i ], _mm_sub_ps( _mm_loadu_ps( &lifetime[ i ] ), vStep ) );
+        }
+        #endif
+
+        for ( ; i < n; ++i )
+        {
+            vy[ i ] += dvy;
+            px[ i ] += vx[ i ] * timeStep;
+            py[ i ] += vy[ i ] * timeStep;
+            a[ i ] -= da;
+            lifetime[ i ] -= timeStep;
+        }
+    }
+
+    // Removes every expired particle by swapping the last live particle
+    // into its slot. Runs in a single pass with no shifting.
+    void compact()
+    {
+        size_t n = size();
+        size_t i = 0;
+
+        while ( i < n )
+        {
+            if ( lifetime[ i ] > 0 )
+            {
+                ++i;
+                continue;
+            }
+
+            --n;
+            for ( auto* arr : _arrays() )
+                (*arr)[ i ] = (*arr)[ n ];
+        }
+
+        for ( auto* arr : _arrays() )
+            arr->resize( n );
+    }
+
+private:
+
+    std::array< std::vector< float >*, 9 > _arrays()
+    {
+        return { { &lifetime, &r, &g, &b, &a, &px, &py, &vx, &vy } };
+    }
+};
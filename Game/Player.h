@@ -4,6 +4,7 @@
 #include <Odin\GraphicalComponent.hpp>
 #include <Odin\AnimatorComponent.hpp>
 #include <Odin\PhysicalComponent.hpp>
+#include <Odin\Registry.hpp>
 #include <glm\glm.hpp>
 #include "EntityFactory.h"
 
@@ -33,15 +34,15 @@ public:
 
 	const float FALL_THRESHOLD = 0.1f;
 	//arm
-	GraphicalComponent* arm_gfx;
-	AnimatorComponent* arm_anim;
+	odin::ComponentRef< GraphicalComponent > arm_gfx;
+	odin::ComponentRef< AnimatorComponent > arm_anim;
     b2Body* arm_psx;
 	Vec2 armOffsets[5];
 	int delay = 0; // Arm lowering delay
 
 	//player
-	GraphicalComponent* gfx;
-	AnimatorComponent* anim;
+	odin::ComponentRef< GraphicalComponent > gfx;
+	odin::ComponentRef< AnimatorComponent > anim;
 	b2Body* psx;
 
 	PlayerState currentState;
@@ -82,11 +83,11 @@ public:
 
 	bool active = false;
 
-	void init(GraphicalComponent *gfx,
-			  AnimatorComponent *anim,
+	void init(odin::ComponentRef< GraphicalComponent > gfx,
+			  odin::ComponentRef< AnimatorComponent > anim,
                b2Body *psx,
-			  GraphicalComponent *arm_gfx, 
-			  AnimatorComponent *arm_anim,
+			  odin::ComponentRef< GraphicalComponent > arm_gfx, 
+			  odin::ComponentRef< AnimatorComponent > arm_anim,
                b2Body *arm_psx) {
 		if (active)
 			return;
@@ -0,0 +1,299 @@
+// Andrew Meckling
+#pragma once
+
+#include "Allocators.hpp"
+
+#include <atomic>
+#include <cstdint>
+
+// Returns a small number for the calling thread, unique among the threads
+// which have called it. Numbers aren't reused when threads exit.
+inline size_t pool_thread_index()
+{
+    static std::atomic< size_t > next { 0 };
+    thread_local size_t index = next.fetch_add( 1, std::memory_order_relaxed );
+    return index;
+}
+
+// Allocates blocks of up to Size bytes from Count blocks held in this
+// object. Safe to use from any number of threads at once.
+// Each thread keeps a magazine of free blocks which it allocates from and
+// frees to without synchronizing. Magazines are refilled from, and spill
+// half of themselves to, a lock-free depot shared by every thread. A block
+// freed by a thread other than the one which allocated it is pushed onto
+// the allocating thread's remote-free list, which that thread takes back
+// in one exchange when its magazine runs dry.
+// The first MAX_THREADS threads get magazines; later threads go straight
+// to the depot. A thread which is done with the pool, e.g. before it
+// exits, should call release() to give back its magazine, or those blocks
+// stay out of reach. Blocks freed to a thread which has stopped
+// allocating wait on its remote-free list; once the depot and the unused
+// blocks run out, allocate() moves every remote-free list to the depot.
+template< size_t Size, size_t Count >
+class PoolAllocator
+{
+public:
+
+    static constexpr size_t SIZE = round_to_alignment( Size, sizeof( void* ) );
+    static constexpr size_t COUNT = Count;
+    static constexpr size_t MAGAZINE = 64;
+    static constexpr size_t MAX_THREADS = 64;
+
+    static_assert( COUNT < UINT32_MAX, "PoolAllocator: too many blocks" );
+
+    alignas( 64 ) byte memory[ SIZE * COUNT ];
+
+    PoolAllocator()
+    {
+        for ( std::uint16_t& owner : _owners )
+            owner = NO_OWNER;
+    }
+
+    PoolAllocator( const PoolAllocator& ) = delete;
+    PoolAllocator& operator =( const PoolAllocator& ) = delete;
+
+    Blk allocate( size_t size ) noexcept
+    {
+        if ( size > SIZE )
+            return { nullptr, 0 };
+
+        size_t thread = pool_thread_index();
+        std::uint32_t i = thread < MAX_THREADS ? _allocateCached( _caches[ thread ] )
+                                               : _allocateShared();
+        if ( i == NONE )
+            return { nullptr, 0 };
+
+        _owners[ i ] = thread < MAX_THREADS ? std::uint16_t( thread ) : NO_OWNER;
+        return { _block( i ), size };
+    }
+
+    void deallocate( Blk blk ) noexcept
+    {
+        if ( blk.ptr == nullptr )
+            return;
+
+        assert( owns( blk.ptr ) );
+        std::uint32_t i = std::uint32_t( ((byte*) blk.ptr - memory) / SIZE );
+        std::uint16_t owner = _owners[ i ];
+        size_t thread = pool_thread_index();
+
+        if ( owner == thread )
+            _free( _caches[ thread ], i );
+        else if ( owner != NO_OWNER )
+            _pushRemote( _caches[ owner ], i );
+        else if ( thread < MAX_THREADS )
+            _free( _caches[ thread ], i );
+        else
+            _pushDepot( i, i );
+    }
+
+    // Gives the calling thread's magazine, and the blocks other threads
+    // have freed to it, back to the depot.
+    void release() noexcept
+    {
+        size_t thread = pool_thread_index();
+        if ( thread >= MAX_THREADS )
+            return;
+
+        _Cache& cache = _caches[ thread ];
+        _reclaim( cache );
+
+        if ( cache.count > 0 )
+        {
+            _spill( cache, cache.count );
+            cache.count = 0;
+        }
+    }
+
+    constexpr bool owns( void* ptr )
+    {
+        return memory <= ptr && ptr < memory + SIZE * COUNT;
+    }
+
+private:
+
+    static constexpr std::uint32_t NONE = UINT32_MAX;
+    static constexpr std::uint16_t NO_OWNER = UINT16_MAX;
+
+    struct alignas( 64 ) _Cache
+    {
+        std::atomic< std::uint32_t > remote { NONE }; // Blocks freed by other threads.
+
+        alignas( 64 ) std::uint32_t blocks[ MAGAZINE ];
+        size_t count = 0;
+    };
+
+    // Head of the depot's list, tagged with a count of the pops so a pop
+    // can't succeed on a head which was popped and pushed back meanwhile.
+    std::atomic< std::uint64_t > _depot { _tagged( NONE, 0 ) };
+    std::atomic< size_t >        _used { 0 }; // Blocks never handed out yet are [_used, COUNT).
+
+    std::uint16_t                _owners[ COUNT ]; // Thread which allocated each block.
+    std::atomic< std::uint32_t > _links[ COUNT ];  // Next block of each free block's list.
+    _Cache                       _caches[ MAX_THREADS ];
+
+    byte* _block( std::uint32_t i )
+    {
+        return memory + SIZE * i;
+    }
+
+    // The links are kept out of the blocks: a pop from the depot can
+    // read the link of a block which another thread has just popped and
+    // is writing to.
+    std::uint32_t _next( std::uint32_t i ) const
+    {
+        return _links[ i ].load( std::memory_order_relaxed );
+    }
+
+    void _link( std::uint32_t i, std::uint32_t next )
+    {
+        _links[ i ].store( next, std::memory_order_relaxed );
+    }
+
+    std::uint32_t _allocateCached( _Cache& cache )
+    {
+        if ( cache.count == 0 )
+            _refill( cache );
+
+        return cache.count > 0 ? cache.blocks[ --cache.count ] : NONE;
+    }
+
+    void _refill( _Cache& cache )
+    {
+        // Take back every block other threads have freed; they were ours.
+        std::uint32_t i = cache.remote.exchange( NONE, std::memory_order_acquire );
+        while ( i != NONE )
+        {
+            std::uint32_t next = _next( i );
+            _free( cache, i );
+            i = next;
+        }
+
+        while ( cache.count < MAGAZINE / 2 )
+        {
+            std::uint32_t j = _allocateShared();
+            if ( j == NONE )
+                break;
+
+            cache.blocks[ cache.count++ ] = j;
+        }
+    }
+
+    std::uint32_t _allocateShared()
+    {
+        std::uint32_t i = _popDepot();
+        if ( i != NONE )
+            return i;
+
+        if ( _used.load( std::memory_order_relaxed ) < COUNT )
+        {
+            size_t fresh = _used.fetch_add( 1, std::memory_order_relaxed );
+            if ( fresh < COUNT )
+                return std::uint32_t( fresh );
+        }
+
+        // Last resort: blocks freed to threads which may have stopped
+        // allocating. Only reached when the pool is all but empty.
+        bool reclaimed = false;
+        for ( _Cache& cache : _caches )
+            reclaimed |= _reclaim( cache );
+
+        return reclaimed ? _popDepot() : NONE;
+    }
+
+    // Moves a thread's remote-free list onto the depot. Any thread may
+    // take the list; it's only ever taken whole. Returns false if it was
+    // empty.
+    bool _reclaim( _Cache& cache )
+    {
+        if ( cache.remote.load( std::memory_order_relaxed ) == NONE )
+            return false;
+
+        std::uint32_t first = cache.remote.exchange( NONE, std::memory_order_acquire );
+        if ( first == NONE )
+            return false;
+
+        std::uint32_t last = first;
+        while ( _next( last ) != NONE )
+            last = _next( last );
+
+        _pushDepot( first, last );
+        return true;
+    }
+
+    // Pushes the n oldest blocks of the magazine onto the depot as one
+    // chain. The caller removes them from the magazine.
+    void _spill( _Cache& cache, size_t n )
+    {
+        for ( size_t k = 0; k + 1 < n; ++k )
+            _link( cache.blocks[ k ], cache.blocks[ k + 1 ] );
+
+        _pushDepot( cache.blocks[ 0 ], cache.blocks[ n - 1 ] );
+    }
+
+    void _free( _Cache& cache, std::uint32_t i )
+    {
+        if ( cache.count == MAGAZINE )
+        {
+            // Spill the older half of the magazine.
+            _spill( cache, MAGAZINE / 2 );
+
+            std::copy( cache.blocks + MAGAZINE / 2, cache.blocks + MAGAZINE, cache.blocks );
+            cache.count = MAGAZINE / 2;
+        }
+
+        cache.blocks[ cache.count++ ] = i;
+    }
+
+    void _pushRemote( _Cache& cache, std::uint32_t i )
+    {
+        std::uint32_t head = cache.remote.load( std::memory_order_relaxed );
+        do
+            _link( i, head );
+        while ( !cache.remote.compare_exchange_weak( head, i, std::memory_order_release,
+                                                              std::memory_order_relaxed ) );
+    }
+
+    // Pushes a chain of blocks, linked from first to last, onto the depot.
+    void _pushDepot( std::uint32_t first, std::uint32_t last )
+    {
+        std::uint64_t head = _depot.load( std::memory_order_relaxed );
+        do
+            _link( last, _index( head ) );
+        while ( !_depot.compare_exchange_weak( head, _tagged( first, _tag( head ) ),
+                                               std::memory_order_release,
+                                               std::memory_order_relaxed ) );
+    }
+
+    std::uint32_t _popDepot()
+    {
+        std::uint64_t head = _depot.load( std::memory_order_acquire );
+        while ( _index( head ) != NONE )
+        {
+            // The head may be popped and pushed back by another thread
+            // while its link is read, but then the tag has changed and
+            // the exchange fails.
+            std::uint32_t next = _next( _index( head ) );
+            if ( _depot.compare_exchange_weak( head, _tagged( next, _tag( head ) + 1 ),
+                                               std::memory_order_acquire,
+                                               std::memory_order_acquire ) )
+                return _index( head );
+        }
+        return NONE;
+    }
+
+    static constexpr std::uint64_t _tagged( std::uint32_t index, std::uint32_t tag )
+    {
+        return std::uint64_t( tag ) << 32 | index;
+    }
+
+    static constexpr std::uint32_t _index( std::uint64_t tagged )
+    {
+        return std::uint32_t( tagged );
+    }
+
+    static constexpr std::uint32_t _tag( std::uint64_t tagged )
+    {
+        return std::uint32_t( tagged >> 32 );
+    }
+};
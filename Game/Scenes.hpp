@@ -7,16 +7,24 @@
 #include <Odin/ThreadedAudio.h>
 #include <Odin/TextureManager.hpp>
 #include <Odin/Camera.h>
+#include <Odin/SpriteBatch.hpp>
+#include <Odin/JobSystem.hpp>
+#include <Odin/PhysicsExecutor.hpp>
+#include <Odin/Registry.hpp>
+#include <Odin/Archetype.hpp>
+#include <Odin/EntityCommandBuffer.hpp>
 
 
 #include "Constants.h"
 #include "EntityFactory.h"
 #include "Player.h"
 
+#include <algorithm>
 #include <tuple>
 #include <array>
 #include <bitset>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 //for clocking assembly
@@ -35,6 +43,7 @@
 
 using odin::Entity;
 using odin::EntityId;
+using namespace odin::literals;
 using odin::GraphicalComponent;
 using odin::PhysicalComponent;
 using odin::AnimatorComponent;
@@ -70,6 +79,8 @@ class EntityBase
 public:
     const char* name = "<no name>";
 
+    virtual ~EntityBase() = default;
+
     virtual void onDestroy( Entity2& ) {}
 
     virtual void onEvent( int ) {}
@@ -140,14 +151,35 @@ public:
     }
 };
 
+// The world steps on the job system, so callbacks can arrive
+// from several workers at once.
 class MyContactListener : public b2ContactListener
 {
 public:
 
-    std::vector< EntityBase* > deadEntities;
+    // Entities whose bullets hit something this frame, each listed once.
+    std::vector< odin::Handle > deadEntities;
+    std::mutex                  deadEntitiesMutex;
+
+    explicit MyContactListener( const odin::Registry& registry )
+        : _registry( registry )
+    {
+    }
+
+    // Forgets this frame's dead entities. Only the words of the bitset
+    // which have a bit set are cleared.
+    void clear()
+    {
+        for ( odin::Handle h : deadEntities )
+            _listed[ h.index / 64 ] = 0;
+
+        deadEntities.clear();
+    }
 
     void BeginContact(b2Contact* contact) {
 		
+        std::lock_guard< std::mutex > lock( deadEntitiesMutex );
+
         auto bodyA = contact->GetFixtureA()->GetBody();
         auto bodyB = contact->GetFixtureB()->GetBody();
 
@@ -173,7 +205,7 @@ public:
 				if (Player::deadPlayers >= 3) //if last player
 					eb->player->focus = true;
 			}*/
-			deadEntities.push_back((EntityBase*)bodyA->GetUserData());
+			_kill( bodyA );
 		}
 
 		if (bodyB->IsBullet())
@@ -195,62 +227,111 @@ public:
 				if (Player::deadPlayers >= 3) //if last player
 					eb->player->focus = true;
 			}*/
-			deadEntities.push_back((EntityBase*)bodyB->GetUserData());
+			_kill( bodyB );
 		}
 	}
 
     void EndContact(b2Contact* contact) {
 
     }
+
+private:
+
+    const odin::Registry&        _registry;
+    std::vector< std::uint64_t > _listed; // Bit per entity index; set if it's in deadEntities.
+
+    // A bullet often touches several fixtures in one step; the bitset
+    // lists its entity only once. Bodies of destroyed entities are
+    // skipped.
+    void _kill( b2Body* body )
+    {
+        odin::Handle h = odin::body_entity( body, _registry );
+        if ( !_registry.valid( h ) )
+            return;
+
+        odin::EntityIndex e = h.index;
+        std::uint64_t bit = std::uint64_t( 1 ) << (e % 64);
+
+        if ( e / 64 >= _listed.size() )
+            _listed.resize( e / 64 + 1 );
+
+        if ( _listed[ e / 64 ] & bit )
+            return;
+
+        _listed[ e / 64 ] |= bit;
+        deadEntities.push_back( h );
+    }
+};
+
+// Where an entity is drawn. Entities with a body have it copied from
+// the body every frame.
+struct Transform
+{
+    glm::vec2 position = { 0, 0 };
+    float     rotation = 0;
+
+    Transform() = default;
+
+    Transform( glm::vec2 pos, float rot = 0 )
+        : position( pos )
+        , rotation( rot )
+    {
+    }
 };
 
+// Named entry of a scene's entity index. The components of the entity
+// live in the scene's registry, under the entity's handle.
 struct Entity2
 {
     friend class LevelScene;
-    
-    using BasePointer = std::unique_ptr< EntityBase >;
 
-    glm::vec2 position = { 0, 0 };
-    float     rotation = 0;
-	unsigned  flags = 0;
+    // Destroys a base and gives its memory back to the allocator it came
+    // from, or deletes it if it came from new.
+    struct BaseDeleter
+    {
+        IAllocator* allocator = nullptr;
+        size_t      size = 0;
 
-	b2Body*             pBody = nullptr;
-    GraphicalComponent* pDrawable = nullptr;
-    AnimatorComponent*  pAnimator = nullptr;
+        void operator ()( EntityBase* base ) const
+        {
+            if ( allocator == nullptr )
+            {
+                delete base;
+                return;
+            }
+
+            base->~EntityBase();
+            allocator->deallocate( { base, size } );
+        }
+    };
+
+    using BasePointer = std::unique_ptr< EntityBase, BaseDeleter >;
+
+    odin::Handle handle;
+	unsigned     flags = 0;
 
     Entity2() = default;
 
-    Entity2( Vec2 pos, float rot, unsigned fl = 0 )
-        : position( pos )
-        , rotation( rot )
+    explicit Entity2( odin::Handle h, unsigned fl = 0 )
+        : handle( h )
         , flags( fl )
     {
     }
 
     Entity2( Entity2&& move )
-        : position( move.position )
-        , rotation( move.rotation )
+        : handle( move.handle )
         , flags( move.flags )
-        , pBody( move.pBody )
-        , pDrawable( move.pDrawable )
-        , pAnimator( move.pAnimator )
         , _base( std::move( move._base ) )
     {
-		move.pBody = nullptr;
-        move.pDrawable = nullptr;
-        move.pAnimator = nullptr;
+        move.handle = {};
     }
 
     ~Entity2() = default;
 
     Entity2& operator =( Entity2&& move )
     {
-        position = move.position;
-        rotation = move.rotation;
         flags = move.flags;
-        std::swap( pBody, move.pBody );
-        std::swap( pDrawable, move.pDrawable);
-        std::swap( pAnimator, move.pAnimator );
+        std::swap( handle, move.handle );
         std::swap( _base, move._base );
         return *this;
     }
@@ -268,15 +349,25 @@ struct Entity2
     template< typename EntityClass >
     void setBase( EntityClass self )
     {
-        _base = std::make_unique< EntityClass >( std::move( self ) );
+        _base = BasePointer( new EntityClass( std::move( self ) ) );
+    }
+
+    // Places the base in memory from the allocator, which must outlive it.
+    template< typename EntityClass >
+    void setBase( IAllocator& allocator, EntityClass self )
+    {
+        Blk blk = allocator.allocate( sizeof( EntityClass ) );
+        if ( blk.ptr == nullptr )
+            throw "out of memory";
+
+        _base = BasePointer( new( blk.ptr ) EntityClass( std::move( self ) ),
+                             BaseDeleter { &allocator, sizeof( EntityClass ) } );
     }
 
     void reset()
     {
         _base = nullptr;
-        pBody = nullptr;
-        pDrawable = nullptr;
-        pAnimator = nullptr;
+        handle = {};
     }
 
     void kill()
@@ -300,6 +391,17 @@ private:
     BasePointer _base = nullptr;
 };
 
+// Entity2 only holds plain data and a unique_ptr, so the entity index
+// moves its entries with memcpy when it grows or shifts.
+namespace odin
+{
+    template<>
+    struct is_trivially_relocatable< Entity2 >
+        : std::true_type
+    {
+    };
+}
+
 
 
 
@@ -310,49 +412,187 @@ public:
 
     using EntityPlayerType = EntityPlayer;
 
+    // Memory which lives as long as the scene. Scene-wide containers
+    // allocate from it first and fall back to malloc when it runs out.
+    using SceneArena = FallbackAllocator< StackAllocator< 64 * 1024, 16 >, Mallocator >;
+
+    // Entities are looked up by name many times a frame but only added
+    // and removed a few times, so the names get an Eytzinger index.
     template< typename ValueType >
-    using EntityMap = odin::BinarySearchMap< EntityId, ValueType >;
+    using EntityMap = odin::BinarySearchMap< EntityId, ValueType, odin::EytzingerLayout,
+                                             AllocatorRef< SceneArena > >;
+
+    // Bullet trails are created and faded out in bulk and all have the
+    // same components, so they're stored as rows of an archetype and
+    // ticked and drawn chunk by chunk.
+    using TrailArchetype = odin::Archetype< Transform, GraphicalComponent, AnimatorComponent >;
 
     static constexpr size_t COMP_MAX = 500;
 
-    template< typename T >
-    using Components = TypedAllocator< T, COMP_MAX >;
+    // Memory for containers which only live for a frame. It's on top of
+    // the context allocator stack while the scene is, and flips at the
+    // start of every update.
+    using FrameMemory = FrameArena< 256 * 1024 >;
+
+    // Memory for bullet bases (32 bytes), which live as long as their
+    // entity; placed with Entity2::setBase( allocator, base ). It's the
+    // only user, so there's one size class. The scene's other small
+    // allocations (components in the registry's vectors, particles,
+    // strings) use their containers' own allocators, and the frame arena
+    // is on top of the context stack, so more classes would sit unused.
+    // Bases past 1024 live bullets go to malloc. Declared before anything
+    // holding entities, since they free into it.
+    using LocalAllocator = SegregatedAllocator<
+        SlabAllocator< 32, 1024 >
+    >;
+
+    SceneArena                             arena;
+    FrameMemory                            frameArena;
+    PolymorphicAllocator< LocalAllocator > _localAllocator;
+    odin::Registry                         registry;
+    EntityMap< Entity2 >                   entities; // Names of the entities that are looked up by name.
+
+    // Returns the named entity. If it doesn't exist yet it's created
+    // with a name and a transform.
+    Entity2& spawn( EntityId eid, Transform tf = {} )
+    {
+        Entity2& ntt = entities[ eid ];
+        if ( !registry.valid( ntt.handle ) )
+            ntt.handle = create( eid, tf );
 
-    EntityMap< Entity2 > entities;
+        return ntt;
+    }
 
-    Components< GraphicalComponent > graphics;
-    Components< AnimatorComponent >  animations;
+    // Creates an entity which isn't in the entity index; it's only
+    // reachable through the returned handle. The name is kept as a
+    // component since sprites are layered by name.
+    odin::Handle create( EntityId name, Transform tf = {} )
+    {
+        odin::Handle h = registry.create();
+        registry.emplace< EntityId >( h, name );
+        registry.emplace< Transform >( h, tf );
+        return h;
+    }
 
-    GraphicalComponent* newGraphics( GraphicalComponent gfx )
+    // Spawns several named entities at once. The names are merged into
+    // the entity index in one pass instead of one insertion each; names
+    // which already exist are left alone.
+    void spawn( const EntityId* eids, size_t count, Transform tf = {} )
     {
-        return ALLOC( graphics, GraphicalComponent )( std::move( gfx ) );
+        std::vector< odin::MapEntry< EntityId, Entity2 > > batch;
+        batch.reserve( count );
+
+        for ( size_t i = 0; i < count; ++i )
+            batch.push_back( { eids[ i ], Entity2() } );
+
+        std::sort( batch.begin(), batch.end(),
+            []( const odin::MapEntry< EntityId, Entity2 >& a,
+                const odin::MapEntry< EntityId, Entity2 >& b ) {
+                return a.key < b.key;
+            } );
+
+        batch.erase( std::unique( batch.begin(), batch.end(),
+            []( const odin::MapEntry< EntityId, Entity2 >& a,
+                const odin::MapEntry< EntityId, Entity2 >& b ) {
+                return a.key == b.key;
+            } ), batch.end() );
+
+        _spawnSorted( batch, tf );
     }
 
-    AnimatorComponent* newAnimator( AnimatorComponent anim )
+    // Merges entries sorted on their names into the entity index, giving
+    // each a new entity unless it already has one. The first entry of a
+    // name is kept unless the name exists; the entities of the entries
+    // which aren't kept are destroyed.
+    template< typename Batch >
+    void _spawnSorted( Batch& batch, Transform tf = {} )
     {
-        return ALLOC( animations, AnimatorComponent )( std::move( anim ) );
+        bool first = true;
+        EntityId previous;
+        batch.erase( std::remove_if( batch.begin(), batch.end(),
+            [this, &first, &previous]( const odin::MapEntry< EntityId, Entity2 >& entry ) {
+                bool repeated = !first && previous == entry.key;
+                first = false;
+                previous = entry.key;
+
+                if ( !repeated && !entities.search( entry.key ) )
+                    return false;
+
+                _destroy( entry.value.handle );
+                return true;
+            } ), batch.end() );
+
+        for ( auto& entry : batch )
+        {
+            if ( !registry.valid( entry.value.handle ) )
+                entry.value.handle = create( entry.key, tf );
+        }
+
+        entities.insert_range( batch.begin(), batch.end() );
     }
 
-    b2Body* newBody( const b2BodyDef& bodyDef )
+    // Applies the commands recorded by every thread since the last call.
+    // Destroyed names are erased from the entity index and new names are
+    // merged into it, one pass each. The merged batch is only needed for
+    // the call, so it's allocated from the context (the frame arena).
+    void applyCommands()
     {
-        return b2world.CreateBody( &bodyDef );
+        auto batch = commands.merge( ContextStlAllocator< Entity2 >() );
+        if ( batch.empty() )
+            return;
+
+        for ( odin::Handle h : batch.destroyedHandles() )
+            _destroy( h );
+
+        const auto& dead = batch.destroyedNames();
+        for ( EntityId eid : dead )
+            _destroy( eid );
+
+        entities.erase( dead.begin(), dead.end() );
+
+        _spawnSorted( batch.created() );
+
+        for ( auto& add : batch.added() )
+            if ( Entity2* ntt = entities.search( add->name ) )
+                add->apply( registry, ntt->handle.index );
     }
 
-    void deleteComponent( GraphicalComponent* gfx )
+    // Adds a component to the named entity, spawning it if necessary.
+    // The returned reference is invalidated by the next component of
+    // the same type that is added or removed.
+    template< typename T >
+    T& attach( EntityId eid, T component )
     {
-        if ( gfx ) gfx->~GraphicalComponent();
-        DEALLOC( graphics, gfx );
+        return registry.emplace< T >( spawn( eid ).handle, std::move( component ) );
     }
 
-    void deleteComponent( AnimatorComponent* anim )
+    // Returns a component of the named entity, or nullptr if either
+    // doesn't exist.
+    template< typename T >
+    T* component( EntityId eid )
     {
-        if ( anim ) anim->~AnimatorComponent();
-        DEALLOC( animations, anim );
+        auto itr = entities.search( eid );
+        return itr ? registry.find< T >( itr->handle ) : nullptr;
     }
 
-    void deleteComponent( b2Body* body )
+    Transform& transform( EntityId eid )
     {
-        if ( body ) b2world.DestroyBody( body );
+        return registry.get< Transform >( spawn( eid ).handle );
+    }
+
+    GraphicalComponent* drawable( EntityId eid )
+    {
+        return component< GraphicalComponent >( eid );
+    }
+
+    AnimatorComponent* animator( EntityId eid )
+    {
+        return component< AnimatorComponent >( eid );
+    }
+
+    b2Body* newBody( const b2BodyDef& bodyDef )
+    {
+        return b2world.CreateBody( &bodyDef );
     }
 
 
@@ -361,8 +601,14 @@ public:
     //EntityMap< GraphicalComponent > gfxComponents;
     //EntityMap< AnimatorComponent >  animComponents;
 
-    b2ThreadPool                    b2thd;
-    b2World                         b2world = { { 0.f, -9.81f } };
+    odin::JobSystem&                jobs = odin::job_system();
+
+    // Structural changes requested during a pass (or from jobs) are
+    // recorded here and made by applyCommands().
+    using Commands = odin::ThreadCommandBuffers< EntityId, Entity2 >;
+    Commands                        commands { jobs };
+
+    b2World                         b2world = { { 0.f, -9.81f }, &odin::physics_executor() };
     //EntityMap< PhysicalComponent >  fsxComponents;
 
     //OHT_DEFINE_COMPONENTS( entities, gfxComponents, animComponents, fsxComponents );
@@ -383,24 +629,23 @@ public:
     GLint uMatrix, uColor, uTexture, uFacingDirection,
         uCurrentFrame, uCurrentAnim, uMaxFrame, uMaxAnim, uSilhoutte, uInteractive;
 
+    odin::SpriteBatch spriteBatch;
+
     //for simulating energy - alpha presentation
     float energyLevel = 0;
     unsigned short _bulletCount = 0;
 
+    // Frame arena overflows since the last report.
+    size_t   _overflowMallocs = 0;
+    unsigned _overflowFrames = 0;
+    unsigned _overflowReportTicks = 0;
+
 	// Range of the bullets, set to diagonal screen distance by default
 	float bulletRange;
 
-    MyContactListener _contactListener;
+    MyContactListener _contactListener { registry };
 
-    /*PolymorphicAllocator<
-        ThresholdAllocator< 4,
-            BitsetAllocator< 1024 * 2, 4 >,
-            ThresholdAllocator< 128,
-                BitsetAllocator< 1024 * 1024, 8 >,
-                Mallocator
-            >
-        >
-    > _localAllocator;*/
+    PolymorphicAllocator< AllocatorRef< FrameMemory > > _frameContext { frameArena };
 
 	int			numberPlayers;
 	Player      players[MAX_PLAYERS];
@@ -420,6 +665,7 @@ public:
 
 	LevelScene(int width, int height, std::string audioBank = "", int numberPlayers = MAX_PLAYERS)
 		: Scene(width, height)
+		, entities(COMP_MAX, arena)
 		, audioBankName(audioBank)
 		, numberPlayers(numberPlayers)
 
@@ -434,6 +680,7 @@ public:
 		, uMaxAnim(glGetUniformLocation(program, "uTotalAnim"))
 		, uSilhoutte(glGetUniformLocation(program, "uSilhoutte"))
 		, uInteractive(glGetUniformLocation(program, "uInteractive"))
+		, spriteBatch(load_shaders("Shaders/vertexInstanced.glsl", "Shaders/fragmentInstanced.glsl"), COMP_MAX)
     {
 		Player::totalPlayers = numberPlayers;
     }
@@ -465,21 +712,17 @@ public:
 
 		//ready text creation
 		EntityId readyid("wready", 0);
-		decltype(auto) ready = entities[readyid];
-		ready.position = Vec2(0, 0);
-		ready.pDrawable = newGraphics(GraphicalComponent::makeRect(256, 64, { 255.f, 255.f, 255.f }, 1.0f));
-		ready.pDrawable->interactive = false;
-		ready.pDrawable->texture = READY_TEXTURE;
-		ready.pAnimator = newAnimator(AnimatorComponent({ 16, 16 }));
-		ready.pAnimator->loop = false;
+		spawn(readyid, Transform(Vec2(0, 0)));
+		GraphicalComponent& readyGfx = attach(readyid, GraphicalComponent::makeRect(256, 64, { 255.f, 255.f, 255.f }, 1.0f));
+		readyGfx.interactive = false;
+		readyGfx.texture = READY_TEXTURE;
+		attach(readyid, AnimatorComponent({ 16, 16 })).loop = false;
 
 		//win screen creation (starts with alpha = 0)
 		EntityId wineid("wintex", 0);
-		decltype(auto) wintex = entities[wineid];
-		wintex.position = Vec2(0, 0);
-		wintex.pDrawable = newGraphics(GraphicalComponent::makeRect(64, 64, { 255.f, 255.f, 255.f }, 0.0f));
-		wintex.pDrawable->texture = WIN_TEXTURE;
-		wintex.pAnimator = newAnimator(AnimatorComponent({ 1, 1 }));
+		spawn(wineid, Transform(Vec2(0, 0)));
+		attach(wineid, GraphicalComponent::makeRect(64, 64, { 255.f, 255.f, 255.f }, 0.0f)).texture = WIN_TEXTURE;
+		attach(wineid, AnimatorComponent({ 1, 1 }));
 
 		pointsOffset[0] = glm::vec2(-230, 135);
 		pointsOffset[1] = glm::vec2(230, 135);
@@ -488,48 +731,44 @@ public:
 
 		for (int i = 0; i < numberPlayers; ++i) {
 			EntityId pointA("pointA", i);
-			decltype(auto) pointAInd = entities[pointA];
-			pointAInd.pDrawable = newGraphics(GraphicalComponent::makeRect(10, 8, { 1, 1, 1 }, 1.0f));
-			pointAInd.pDrawable->texture = SKULL_COIN;
-			pointAInd.pAnimator = newAnimator(AnimatorComponent({ 9, 9 }));
-			pointAInd.pAnimator->switchAnimState(1);
-			pointAInd.pAnimator->frameDelay = 16;
-			pointAInd.pDrawable->visible = true;
+			GraphicalComponent& pointAGfx = attach(pointA, GraphicalComponent::makeRect(10, 8, { 1, 1, 1 }, 1.0f));
+			pointAGfx.texture = SKULL_COIN;
+			pointAGfx.visible = true;
+			AnimatorComponent& pointAAnim = attach(pointA, AnimatorComponent({ 9, 9 }));
+			pointAAnim.switchAnimState(1);
+			pointAAnim.frameDelay = 16;
 
 			EntityId pointB("pointB", i);
-			decltype(auto) pointBInd = entities[pointB];
-			pointBInd.pDrawable = newGraphics(GraphicalComponent::makeRect(10, 8, { 1, 1, 1 }, 1.0f));
-			pointBInd.pDrawable->texture = SKULL_COIN;
-			pointBInd.pAnimator = newAnimator(AnimatorComponent({ 9, 9 }));
-			pointBInd.pAnimator->switchAnimState(1);
-			pointBInd.pAnimator->frameDelay = 16;
-			pointBInd.pDrawable->visible = true;
+			GraphicalComponent& pointBGfx = attach(pointB, GraphicalComponent::makeRect(10, 8, { 1, 1, 1 }, 1.0f));
+			pointBGfx.texture = SKULL_COIN;
+			pointBGfx.visible = true;
+			AnimatorComponent& pointBAnim = attach(pointB, AnimatorComponent({ 9, 9 }));
+			pointBAnim.switchAnimState(1);
+			pointBAnim.frameDelay = 16;
 
 			EntityId pointC("pointC", i);
-			decltype(auto) pointCInd = entities[pointC];
-			pointCInd.pDrawable = newGraphics(GraphicalComponent::makeRect(10, 8, { 1, 1, 1 }, 1.0f));
-			pointCInd.pDrawable->texture = SKULL_COIN;
-			pointCInd.pAnimator = newAnimator(AnimatorComponent({ 9, 9 }));
-			pointCInd.pAnimator->switchAnimState(1);
-			pointCInd.pAnimator->frameDelay = 16;
-			pointCInd.pDrawable->visible = true;
+			GraphicalComponent& pointCGfx = attach(pointC, GraphicalComponent::makeRect(10, 8, { 1, 1, 1 }, 1.0f));
+			pointCGfx.texture = SKULL_COIN;
+			pointCGfx.visible = true;
+			AnimatorComponent& pointCAnim = attach(pointC, AnimatorComponent({ 9, 9 }));
+			pointCAnim.switchAnimState(1);
+			pointCAnim.frameDelay = 16;
 
 			EntityId ammo("ammo", i);
-			decltype(auto) ammoInd = entities[ammo];
-			ammoInd.pDrawable = newGraphics(GraphicalComponent::makeRect(26, 8, { 1, 1, 1 }, 1.0f));
-			ammoInd.pDrawable->texture = AMMO_COUNTER;
-			ammoInd.pAnimator = newAnimator(AnimatorComponent({ 1, 1, 1, 1, 1, 1, 1 }));
-			ammoInd.pDrawable->visible = false;
+			GraphicalComponent& ammoGfx = attach(ammo, GraphicalComponent::makeRect(26, 8, { 1, 1, 1 }, 1.0f));
+			ammoGfx.texture = AMMO_COUNTER;
+			ammoGfx.visible = false;
+			attach(ammo, AnimatorComponent({ 1, 1, 1, 1, 1, 1, 1 }));
 		}
 
 		listeners.push_back([this](const InputManager& inmn) {
 			if (inmn.wasKeyPressed(SDLK_g)) {
-				entities["wintex"].position.x -= 10;
+				transform("wintex"_eid).position.x -= 10;
     }
 		});
 		listeners.push_back([this](const InputManager& inmn) {
 			if (inmn.wasKeyPressed(SDLK_h)) {
-				entities["wintex"].position.x += 10;
+				transform("wintex"_eid).position.x += 10;
 			}
 		});
 		listeners.push_back([this](const InputManager& inmn) {
@@ -544,13 +783,13 @@ public:
     {
 		startingGameStartTicks = ticks;
 		Scene::resume(ticks);
-        //context_allocator::push( _localAllocator );
+        context_allocator::push( _frameContext );
     }
 
 	void pause(unsigned ticks)
     {
 		Scene::pause(ticks);
-        //context_allocator::pop();
+        context_allocator::pop();
     }
 
 	void exit(unsigned ticks)
@@ -571,19 +810,70 @@ public:
         }*/
     }
 
-	void _destroy(Entity2& ntt)
+    // Kills the named entity and destroys its body and components.
+    // The name is left in the entity index; callers remove the names of
+    // every destroyed entity at once with entities.erase().
+	void _destroy(EntityId eid)
+    {
+        Entity2* ntt = entities.search( eid );
+        if ( !ntt )
+            return;
+
+        ntt->kill();
+        _destroy( ntt->handle );
+    }
+
+    // Records the destruction of a live entity. Entities in the entity
+    // index are destroyed by name, the rest only have their handle.
+    void _destroyLater( Commands::Buffer& buffer, odin::EntityIndex e )
+    {
+        if ( _named( e ) )
+            buffer.destroy( registry.get< EntityId >( e ) );
+        else
+            buffer.destroy( registry.handle( e ) );
+    }
+
+    // Returns the entity index entry of a live entity, or nullptr if the
+    // entity isn't in the index.
+    Entity2* _named( odin::EntityIndex e )
+    {
+        EntityId* name = registry.find< EntityId >( e );
+        Entity2* ntt = name ? entities.search( *name ) : nullptr;
+        return ntt && ntt->handle.index == e ? ntt : nullptr;
+    }
+
+    // Destroys the entity's body and components. Stale handles are ignored.
+    void _destroy( odin::Handle h )
     {
-        ntt.kill();
-        deleteComponent( ntt.pBody );
-        deleteComponent( ntt.pDrawable );
-        deleteComponent( ntt.pAnimator );
-        ntt.reset();
+        if ( b2Body** body = registry.find< b2Body* >( h ) )
+            b2world.DestroyBody( *body );
+
+        registry.destroy( h );
     }
 
 	void update(unsigned ticks)
 	{
 		Scene::update(ticks);
 
+        // Frame containers should fit in the arena once the level is
+        // running. Frames where some of them didn't are added up and
+        // reported at most once a second, so a level which overflows
+        // every frame doesn't print every frame.
+        if ( size_t mallocs = frameArena.flip() )
+        {
+            _overflowMallocs += mallocs;
+            ++_overflowFrames;
+        }
+
+        if ( _overflowFrames > 0 && ticks - _overflowReportTicks >= 1000 )
+        {
+            printf( "Frame arena overflowed: %zu mallocs in %u frames\n",
+                    _overflowMallocs, _overflowFrames );
+            _overflowMallocs = 0;
+            _overflowFrames = 0;
+            _overflowReportTicks = ticks;
+        }
+
 		//play any sound events players have triggered
 		for (Player& p : players) {
 			p.update();
@@ -593,11 +883,11 @@ public:
 			}
 		}
 		for (uint16_t i = 0; i < numberPlayers; ++i) {
-			glm::vec2 position = entities[{"player", i}].position;
-			entities[{"pointA", i}].position = pointsOffset[i];
-			entities[{"pointB", i}].position = glm::vec2( pointsOffset[i].x, pointsOffset[i].y-8);
-			entities[{"pointC", i}].position = glm::vec2(pointsOffset[i].x, pointsOffset[i].y-16);
-			entities[{"ammo", i}].position = glm::vec2(position.x, position.y + 20);
+			glm::vec2 position = transform({"player", i}).position;
+			transform({"pointA", i}).position = pointsOffset[i];
+			transform({"pointB", i}).position = glm::vec2( pointsOffset[i].x, pointsOffset[i].y-8);
+			transform({"pointC", i}).position = glm::vec2(pointsOffset[i].x, pointsOffset[i].y-16);
+			transform({"ammo", i}).position = glm::vec2(position.x, position.y + 20);
 		}
 
 
@@ -635,8 +925,8 @@ public:
 
 				delayAmount = 0;
 
-				entities["wintex"].pDrawable->color.a = 1.0f;
-				entities["wintex"].pAnimator->switchAnimState(0);
+				drawable("wintex"_eid)->color.a = 1.0f;
+				animator("wintex"_eid)->switchAnimState(0);
 
 				scale = camera.getScale();
 				if (scale < maxscale) {
@@ -662,55 +952,47 @@ public:
 			}
 
 			if (ticks - gameOverStartTicks > 2000)
-				entities["wintex"].pAnimator->switchAnimState(1);
+				animator("wintex"_eid)->switchAnimState(1);
 
 			camera.setPosition(cameraPos, true);
 			camera.setScale(scale);
 
-			entities["wintex"].position = glm::vec2(cameraPos.x / scale, cameraPos.y / scale);
+			transform("wintex"_eid).position = glm::vec2(cameraPos.x / scale, cameraPos.y / scale);
 
 			SDL_Delay(delayAmount);
 		}
 
 		//setting player position so players appear in corners on first draw
-		for (auto x : entities)
-		{
-			Entity2& ntt = x.value;
-			if (auto body = ntt.pBody)
-			{
-				Vec2 pos = body->GetPosition();
-				ntt.position = glm::round(glm::vec2(pos) * 10.0f);
-				ntt.rotation = body->GetAngle();
-			}
-		}
+		syncTransforms();
 
 
 		//if starting game, don't go any further: we want to halt gameplay
 		//READY DRAW section 
 		if (startingGame) {
-			AnimatorComponent *ac = entities["wready"].pAnimator;
+			AnimatorComponent *ac = animator("wready"_eid);
 			ac->incrementFrame();
 
 			if (ac->currentFrame % 3 == 1)
-				entities[EntityId(0)].pAnimator->incrementFrame(); //next background frame
+				animator(EntityId(0))->incrementFrame(); //next background frame
 
 			if (ac->animState == 0 && ac->currentFrame >= ac->maxFrames - 1) { //if READY displayed and animation finished
 				ac->switchAnimState(1); //change to DRAW animation state
 			}
 			else if (ac->animState == 1) {
 				if (ac->currentFrame >= 6)
-					entities[EntityId(0)].pAnimator->incrementFrame(); //next background frame
+					animator(EntityId(0))->incrementFrame(); //next background frame
 
 				if (ac->currentFrame == 6) {//DRAW has appeared
 					pAudioEngine->playEvent("event:/Desperado/Draw");
 				}
 				else if (ac->currentFrame >= ac->maxFrames - 1) {
 					startingGame = false;
-					entities["wready"].pDrawable->visible = false;
+					drawable("wready"_eid)->visible = false;
 				}
 			}
 
-			silhouette = (float)(entities[EntityId(0)].pAnimator->currentFrame) / (entities[EntityId(0)].pAnimator->maxFrames - 1);
+			AnimatorComponent *bg = animator(EntityId(0));
+			silhouette = (float)(bg->currentFrame) / (bg->maxFrames - 1);
 			glUniform(uSilhoutte, 1.0f);
 
 			return;
@@ -721,59 +1003,58 @@ public:
 		for (auto& lstn : listeners)
 			lstn(*pInputManager);
 
+        // Bullets fired by the listeners are spawned before the step.
+        applyCommands();
+
         float timeStep = Scene::ticksDiff / 1000.f;
 		b2world.Step(timeStep, 8, 3);
 
 
-        std::vector< EntityId > deadEntities;
-		deadEntities.reserve(_contactListener.deadEntities.size());
+        // Trails fired while polling input are added here, between passes.
+        TrailArchetype& trails = registry.archetype< Transform, GraphicalComponent, AnimatorComponent >();
+        trails.flush();
 
-		for (auto x : entities)
-        {
-            Entity2& ntt = x.value;
-            if ( auto animator = ntt.pAnimator )
-            {
-                animator->incrementFrame();
+		tickAnimators();
 
-				switch (animator->type)
-                {
-                    // Handle fading animation
-                case odin::AnimationType::FADEOUT:
-					if (animator->currentFrame == animator->maxFrames - 1)
-                    {
-						_destroy(ntt);
-						deadEntities.push_back(x.key);
-                    }
-                    else {
-                        ntt.pDrawable->color.a = 1.f - (float)animator->currentFrame / (float)animator->maxFrames;
-                    }
-                default:
-                    break;
-                }
-            }
-        }
+        // Entities are destroyed by applyCommands() after the loops;
+        // removing components while iterating would skip or revisit
+        // entities.
+        Commands::Buffer& dying = commands.local();
 
-        for ( auto x : entities )
-        {
-            if ( EntityBase* pbase = x.value.base() )
-            {
-                for ( EntityBase* ebase : _contactListener.deadEntities )
+        // Handle fading animation
+        registry.view< AnimatorComponent, GraphicalComponent >().each(
+            [this, &dying]( odin::EntityIndex e, AnimatorComponent& animator,
+                            GraphicalComponent& drawable ) {
+                if ( animator.type != odin::AnimationType::FADEOUT )
+                    return;
+
+                if ( animator.currentFrame != animator.maxFrames - 1 )
                 {
-                    if ( ebase == pbase )
-                    {
-                        _destroy( x.value );
-                        deadEntities.push_back( x.key );
-                        break;
-                    }
+                    drawable.color.a = 1.f - (float) animator.currentFrame / (float) animator.maxFrames;
+                    return;
                 }
-            }
-        }
 
-        if ( !_contactListener.deadEntities.empty() )
-            _contactListener.deadEntities.clear();
+                _destroyLater( dying, e );
+            } );
+
+        trails.each(
+            [this, &dying]( odin::EntityIndex e, Transform&, GraphicalComponent& drawable,
+                            AnimatorComponent& animator ) {
+                if ( animator.currentFrame == animator.maxFrames - 1 )
+                    dying.destroy( registry.handle( e ) );
+                else
+                    drawable.color.a = 1.f - (float) animator.currentFrame / (float) animator.maxFrames;
+            } );
+
+        // Bullets which hit something. Each is looked up through the
+        // handle its body carries instead of comparing with every entity.
+        for ( odin::Handle h : _contactListener.deadEntities )
+            if ( registry.valid( h ) )
+                _destroyLater( dying, h.index );
+
+        _contactListener.clear();
 
-		for (EntityId eid : deadEntities)
-			entities.remove(eid);
+        applyCommands();
 
 
 		if (!gameOver && Player::deadPlayers >= numberPlayers - 1) {
@@ -789,11 +1070,11 @@ public:
 
 					switch (p.points)
 					{
-					case 1: entities[{"pointA", (uint16_t)i}].pAnimator->switchAnimState(0);
+					case 1: animator({"pointA", (uint16_t)i})->switchAnimState(0);
 						break;
-					case 2: entities[{"pointB", (uint16_t)i}].pAnimator->switchAnimState(0);
+					case 2: animator({"pointB", (uint16_t)i})->switchAnimState(0);
 						break;
-					case 3: entities[{"pointC", (uint16_t)i}].pAnimator->switchAnimState(0);
+					case 3: animator({"pointC", (uint16_t)i})->switchAnimState(0);
 						break;
 
 					}
@@ -830,6 +1111,55 @@ public:
 
     }
 	
+    // Copies body transforms into their entities. Bodies are only read
+    // and every entity has its own transform, so the bodies are split
+    // across the job system.
+    void syncTransforms()
+    {
+        auto& bodies = registry.pool< b2Body* >();
+        auto& transforms = registry.pool< Transform >();
+
+        jobs.parallel_for( bodies.size(), 64,
+            [&bodies, &transforms]( size_t first, size_t last ) {
+                const odin::EntityIndex* ents = bodies.entities();
+                b2Body* const* body = bodies.data();
+
+                for ( size_t i = first; i < last; ++i )
+                {
+                    Transform& tf = transforms.get( ents[ i ] );
+                    Vec2 pos = body[ i ]->GetPosition();
+                    tf.position = glm::round( glm::vec2( pos ) * 10.0f );
+                    tf.rotation = body[ i ]->GetAngle();
+                }
+            } );
+    }
+
+    // Advances every animator by one frame. Animators are packed and
+    // aren't shared between entities so they can be ticked in parallel.
+    // Trail animators are ticked a chunk per job.
+    void tickAnimators()
+    {
+        AnimatorComponent* animators = registry.pool< AnimatorComponent >().data();
+        jobs.parallel_for( registry.pool< AnimatorComponent >().size(), 64,
+            [animators]( size_t first, size_t last ) {
+                for ( size_t i = first; i < last; ++i )
+                    animators[ i ].incrementFrame();
+            } );
+
+        TrailArchetype& trails = registry.archetype< Transform, GraphicalComponent, AnimatorComponent >();
+        jobs.parallel_for( trails.chunkCount(), 1,
+            [&trails]( size_t first, size_t last ) {
+                for ( size_t c = first; c < last; ++c )
+                {
+                    trails.eachInChunk( c, []( const odin::EntityIndex*, size_t count, Transform*,
+                                               GraphicalComponent*, AnimatorComponent* animators ) {
+                        for ( size_t i = 0; i < count; ++i )
+                            animators[ i ].incrementFrame();
+                    } );
+                }
+            } );
+    }
+
 	bool drawDetected() {
 		int totalBullets = 0;
 
@@ -899,50 +1229,52 @@ public:
         //const mat4 base = scale( {}, vec3( zoom, zoom * aspect, 1 ) );
 		//update camera matrix
 		camera.update();
-		glm::mat4 cameraMatrix = camera.getCameraMatrix();
-
-        glUseProgram( program );
-
-        for ( auto x : entities )
-        {
-            Entity2& ntt = x.value;
-            if ( auto drawable = ntt.pDrawable )
-            {
-                if ( !drawable->visible )
-                    continue;
-
-				mat4 mtx = cameraMatrix * translate( {}, vec3( ntt.position, 0 ) );
-                mtx = rotate( mtx, ntt.rotation, vec3( 0, 0, 1 ) );
-
-                glUniform( uMatrix, mtx );
-
-                glUniform( uColor, usingASM? silhouetteASM(&drawable->color, drawable->interactive, &silhouette) : silhouetteCPP(&drawable->color, drawable->interactive, &silhouette));
-				
-
-                glUniform( uTexture, drawable->texture );
-                glUniform( uFacingDirection, drawable->direction );
-				glUniform( uInteractive, drawable->interactive );
-
-                if ( auto anim = ntt.pAnimator )
-                {
-                    glUniform( uCurrentAnim, (float) anim->animState );
-                    glUniform( uCurrentFrame, (float) anim->currentFrame );
-                    glUniform( uMaxFrame, (float) anim->maxFrames );
-                    glUniform( uMaxAnim, (float) anim->totalAnim );
-                }
-                else
-                {
-                    glUniform( uCurrentAnim, 0.f );
-                    glUniform( uCurrentFrame, 0.f );
-                    glUniform( uMaxFrame, 1.f );
-                    glUniform( uMaxAnim, 1.f );
-                }
-
-                glBindVertexArray( drawable->vertexArray );
-                glDrawArrays( GL_TRIANGLES, 0, drawable->count );
-            }
-				}
-        }
+		spriteBatch.begin( camera.getCameraMatrix() );
+
+        // Sprites are layered by name, so keep the drawables sorted on
+        // their names. The order rarely changes between frames.
+        auto& names = registry.pool< EntityId >();
+        registry.pool< GraphicalComponent >().sort(
+            [&names]( odin::EntityIndex a, odin::EntityIndex b ) {
+                return names.get( a ) < names.get( b );
+            } );
+
+        auto add = [this]( GraphicalComponent& drawable, AnimatorComponent* animator, Transform& tf ) {
+            if ( !drawable.visible )
+                return;
+
+            vec4 color = usingASM ? silhouetteASM(&drawable.color, drawable.interactive, &silhouette) : silhouetteCPP(&drawable.color, drawable.interactive, &silhouette);
+
+            spriteBatch.add( drawable, animator, tf.position, tf.rotation, color );
+        };
+
+        // Trails are drawn in the layer they had when they were named "bullet".
+        TrailArchetype& trails = registry.archetype< Transform, GraphicalComponent, AnimatorComponent >();
+        const EntityId trailLayer( "bullet", 0 );
+        bool trailsDrawn = false;
+
+        auto addTrails = [&add, &trails, &trailsDrawn]() {
+            trails.each( [&add]( odin::EntityIndex, Transform& tf, GraphicalComponent& drawable,
+                                 AnimatorComponent& animator ) {
+                add( drawable, &animator, tf );
+            } );
+            trailsDrawn = true;
+        };
+
+        auto& animators = registry.pool< AnimatorComponent >();
+        registry.view< GraphicalComponent, Transform >().each(
+            [&]( odin::EntityIndex e, GraphicalComponent& drawable, Transform& tf ) {
+                if ( !trailsDrawn && names.get( e ) >= trailLayer )
+                    addTrails();
+
+                add( drawable, animators.find( e ), tf );
+            } );
+
+        if ( !trailsDrawn )
+            addTrails();
+
+        spriteBatch.end();
+    }
 
 	void add(EntityId eid, GraphicalComponent gfx)
     {
@@ -1038,22 +1370,22 @@ inline void LevelScene::player_input(const InputManager& mngr, EntityId eid, int
 	if (!entities.search(eid))
         return;
 
-    Entity2& ntt = entities[ eid ];
+    odin::Handle ntt = entities[ eid ].handle;
 
 	if (!players[pindex].alive)
 		return;
 
 	//arm
-    Entity2& arm_ntt = entities[ { "playes", (uint16_t)pindex } ];
-	GraphicalComponent& arm_gfx = *arm_ntt.pDrawable;
-	AnimatorComponent& arm_anim = *arm_ntt.pAnimator;
+    odin::Handle arm_ntt = entities[ { "playes", (uint16_t)pindex } ].handle;
+	auto arm_gfx = registry.ref< GraphicalComponent >( arm_ntt );
+	auto arm_anim = registry.ref< AnimatorComponent >( arm_ntt );
 
-    b2Body& body = *ntt.pBody;
-    GraphicalComponent& gfx = *ntt.pDrawable;
-    AnimatorComponent& anim = *ntt.pAnimator;
+    b2Body& body = *registry.get< b2Body* >( ntt );
+    auto gfx = registry.ref< GraphicalComponent >( ntt );
+    auto anim = registry.ref< AnimatorComponent >( ntt );
 
 	if (!players[pindex].active)
-		players[pindex].init(&gfx, &anim, &body, &arm_gfx, &arm_anim, arm_ntt.pBody);
+		players[pindex].init(gfx, anim, &body, arm_gfx, arm_anim, registry.get< b2Body* >( arm_ntt ));
 
     Vec2 vel = body.GetLinearVelocity();
     float maxSpeed = 7.5f;
@@ -1062,12 +1394,12 @@ inline void LevelScene::player_input(const InputManager& mngr, EntityId eid, int
 
     //adjust facing direction FOR KEYBOARD ONLY
 	if (actionLeft) {
-		gfx.direction = odin::LEFT;
-		arm_gfx.direction = odin::LEFT;
+		gfx->direction = odin::LEFT;
+		arm_gfx->direction = odin::LEFT;
 	}
 	if (actionRight) {
-		gfx.direction = odin::RIGHT;
-		arm_gfx.direction = odin::RIGHT;
+		gfx->direction = odin::RIGHT;
+		arm_gfx->direction = odin::RIGHT;
 	}
 
     Vec2 aimDir = mngr.gamepads.leftStick( pindex );
@@ -1126,11 +1458,11 @@ inline void LevelScene::player_input(const InputManager& mngr, EntityId eid, int
 	// Handle Duck input on button X
 	if (mngr.gamepads.wasButtonPressed(pindex, SDL_CONTROLLER_BUTTON_RIGHTSHOULDER))
 	{
-		entities[{"ammo", (uint16_t)pindex}].pDrawable->visible = true;
+		drawable({"ammo", (uint16_t)pindex})->visible = true;
 	}
 	if (mngr.gamepads.wasButtonReleased(pindex, SDL_CONTROLLER_BUTTON_RIGHTSHOULDER))
 	{
-		entities[{"ammo", (uint16_t)pindex}].pDrawable->visible = false;
+		drawable({"ammo", (uint16_t)pindex})->visible = false;
 	}
 
     //float rTrigger = mngr.gamepads.rightTrigger( pindex );
@@ -1138,10 +1470,10 @@ inline void LevelScene::player_input(const InputManager& mngr, EntityId eid, int
     // Handle Shoot input on button B
     if ( mngr.gamepads.didRightTriggerCross( pindex, 0.85 ) || mngr.gamepads.wasButtonPressed(pindex, SDL_CONTROLLER_BUTTON_B) && players[pindex].respawning <= 0)
     {
-		//arm_anim.play = true;
-		//arm_anim.currentFrame = 1;
+		//arm_anim->play = true;
+		//arm_anim->currentFrame = 1;
 		
-		fireBullet(ntt.position, aimDirection, pindex);
+		fireBullet(registry.get< Transform >(ntt).position, aimDirection, pindex);
     }
     if (mngr.gamepads.wasButtonReleased(pindex, SDL_CONTROLLER_BUTTON_B))
     {
@@ -1158,9 +1490,9 @@ inline void LevelScene::player_input(const InputManager& mngr, EntityId eid, int
 	
     //for testing audio
 	if ( pindex == 0 && mngr.wasKeyPressed(SDLK_SPACE)) {
-		arm_anim.play = true;
-		arm_anim.currentFrame = 1;
-		fireBullet(ntt.position, aimDirection, pindex);
+		arm_anim->play = true;
+		arm_anim->currentFrame = 1;
+		fireBullet(registry.get< Transform >(ntt).position, aimDirection, pindex);
 	}
     if (mngr.wasKeyPressed(SDLK_1))
         pAudioEngine->setEventParameter("event:/Music/EnergeticTheme", "Energy", 0.0); //low energy test
@@ -1180,44 +1512,26 @@ inline void LevelScene::player_input(const InputManager& mngr, EntityId eid, int
 std::tuple<EntityBase*, Vec2, float> LevelScene::resolveBulletCollision(Vec2 position, Vec2 direction) {
 	// buffer value
 	float delta = 0.001;
-	
-	//set up input
-	b2RayCastInput input;
-	input.p1 = position;
-    input.p2 = Vec2( position.glmvec2 + glm::normalize( direction.glmvec2 ) * bulletRange );
-    //{
-    //    position.x + direction.x * bulletRange, position.y + direction.y * bulletRange
-    //};
-	input.maxFraction = 1;
-
-	//check every fixture of every body to find closest
-	float closestFraction = 1; //start with end of line as p2
-	b2Vec2 intersectionNormal(0, 0);
-
-    EntityBase* pEntityBase = nullptr;
-
-    for ( b2Body* body = b2world.GetBodyList(); body; body = body->GetNext() )
-    {
-		for ( b2Fixture* f = body->GetFixtureList(); f; f = f->GetNext() )
-        {
-			b2RayCastOutput output;
-			if ( !f->RayCast( &output, input, 0 ) )
-				continue;
-			
-            if ( !(f->GetFilterData().maskBits & BULLET) )
-				continue;
-
-			if (output.fraction < closestFraction && output.fraction > delta)
-            {
-				closestFraction = output.fraction;
-				intersectionNormal = output.normal;
-                pEntityBase = (EntityBase*) body->GetUserData();
-				//eid = x.key;
-			}
-		}
-		
-	}
-	return std::make_tuple( pEntityBase, intersectionNormal, (closestFraction * bulletRange) * 10 );
+
+    // Keeps the closest hit past the buffer value.
+    odin::ClosestRayHit closest;
+    closest.minFraction = delta;
+
+    // Only fixtures which collide with bullets are tested; the rest are
+    // rejected by the broadphase without a shape test.
+    b2Filter bulletFilter;
+    bulletFilter.categoryBits = BULLET;
+    bulletFilter.maskBits = 0xFFFF;
+
+    Vec2 end = Vec2( position.glmvec2 + glm::normalize( direction.glmvec2 ) * bulletRange );
+    b2world.RayCast( &closest, position, end, bulletFilter );
+
+    b2Body* hit = closest.fixture ? closest.fixture->GetBody() : nullptr;
+    odin::Handle h = hit ? odin::body_entity( hit, registry ) : odin::Handle {};
+    Entity2* ntt = registry.valid( h ) ? _named( h.index ) : nullptr;
+    EntityBase* pEntityBase = ntt ? ntt->base() : nullptr;
+
+	return std::make_tuple( pEntityBase, closest.normal, (closest.fraction * bulletRange) * 10 );
 
 }
 
@@ -1238,7 +1552,7 @@ inline void LevelScene::fireBullet(Vec2 position, odin::Direction8Way direction,
 
 	players[pIndex].bulletCount--;
 
-	entities[{"ammo", (uint16_t)pIndex}].pAnimator->switchAnimState(7 - (players[pIndex].bulletCount+1));
+	animator({"ammo", (uint16_t)pIndex})->switchAnimState(7 - (players[pIndex].bulletCount+1));
 
 	float length = 100.f;
 	float rotation = 0;
@@ -1314,9 +1628,19 @@ inline void LevelScene::fireBullet(Vec2 position, odin::Direction8Way direction,
 
     EntityId bid("bulleq", _bulletCount);
 
-    Entity2& bullet = entities[ bid ];
-    bullet.position = position;
-	bullet.setBase(EntityBullet{ &players[pIndex] });
+    // Bullets are fired from input listeners, so the bullet is recorded
+    // and spawned by applyCommands() once the listeners have run.
+    Commands::Buffer& spawning = commands.local();
+
+    // The count wraps after 65536 shots; a bullet that old has left the
+    // screen without hitting anything, so make way for the new one.
+    if ( entities.search( bid ) )
+        spawning.destroy( bid );
+
+    // The entity is created now so its body can carry the handle; only
+    // the name waits for the entity index.
+    Entity2 bullet( create( bid, Transform( position ) ) );
+	bullet.setBase(_localAllocator, EntityBullet{ &players[pIndex] });
 
     //bullet.pDrawable = newGraphics( GraphicalComponent::makeRect( 1, 1, { 0, 0, 0 } ) );
 
@@ -1328,25 +1652,28 @@ inline void LevelScene::fireBullet(Vec2 position, odin::Direction8Way direction,
     bodyDef.type = b2_dynamicBody;
     bodyDef.gravityScale = 0;
     bodyDef.bullet = true;
-    bodyDef.userData = bullet.base();
+    bodyDef.userData = odin::body_user_data( bullet.handle );
 
 
     //bullet.pBody = newBody( bodyDef );
     auto circ = PhysicalComponent::makeCircle( 0.05, b2world, bodyDef );
-    bullet.pBody = circ.pBody;
+    registry.emplace< b2Body* >( bullet.handle, circ.pBody );
+    spawning.create( bid, std::move( bullet ) );
     circ.pBody = nullptr;
 
-    EntityId eid("bullet", _bulletCount);
-
-    Entity2& bullet2 = entities[ eid ];
-    bullet2.position = Vec2( position + offset );
-    bullet2.rotation = rotation;
+    // The trail is never looked up by name, so it only gets a handle.
+    // Bullets are fired from input listeners, so it joins the trail
+    // archetype at the next flush rather than in the middle of a pass.
+    odin::Handle trail = registry.create();
 
-    bullet2.pDrawable = newGraphics( GraphicalComponent::makeRect(
-        length, 8.0f, { 1, 1, 1 }, 1, { length / bulletRange, 1 } ));
-    bullet2.pDrawable->texture = BULLET_TEXTURE;
+    GraphicalComponent trailGfx = GraphicalComponent::makeRect(
+        length, 8.0f, { 1, 1, 1 }, 1, { length / bulletRange, 1 } );
+    trailGfx.texture = BULLET_TEXTURE;
 
-    bullet2.pAnimator = newAnimator( AnimatorComponent( { 8 }, odin::FADEOUT ) );
+    registry.archetype< Transform, GraphicalComponent, AnimatorComponent >().defer( trail.index,
+        Transform( Vec2( position + offset ), rotation ),
+        std::move( trailGfx ),
+        AnimatorComponent( { 8 }, odin::FADEOUT ) );
 
     ++_bulletCount;
 
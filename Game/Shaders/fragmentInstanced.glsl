@@ -0,0 +1,13 @@
+#version 330 core
+
+in vec2 vTexCoord;
+in vec4 vColor; // silhouetting is applied to the instance color on the CPU
+
+uniform sampler2D uTexture;
+
+layout(location = 0) out vec4 out_Color;
+
+void main()
+{
+	out_Color = vColor * texture(uTexture, vTexCoord);
+}
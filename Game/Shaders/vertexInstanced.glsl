@@ -0,0 +1,30 @@
+#version 330
+
+layout(location = 0) in vec3 vertex;   // unit quad
+layout(location = 1) in vec2 texCoord;
+
+layout(location = 2) in vec4 iTransform; // position.xy, rotation, facing direction
+layout(location = 3) in vec4 iSize;      // width, height, texcoord scale.xy
+layout(location = 4) in vec4 iColor;
+layout(location = 5) in vec4 iFrame;     // current frame, current anim, max frames, total anims
+
+uniform mat4 uMatrix; // camera matrix
+
+out vec2 vTexCoord;
+out vec4 vColor;
+
+void main()
+{
+	vec2 local = vec2(vertex.x * iSize.x * iTransform.w, vertex.y * iSize.y);
+
+	float c = cos(iTransform.z);
+	float s = sin(iTransform.z);
+	vec2 world = iTransform.xy + vec2(c * local.x - s * local.y, s * local.x + c * local.y);
+
+	gl_Position = uMatrix * vec4(world, vertex.z, 1);
+
+	vec2 tex = texCoord * iSize.zw;
+	vTexCoord = vec2((iFrame.x + tex.x) / iFrame.z,
+					 (iFrame.y + tex.y) / iFrame.w);
+	vColor = iColor;
+}
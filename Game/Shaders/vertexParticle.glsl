@@ -0,0 +1,20 @@
+#version 330
+
+layout(location = 0) in vec3 vertex;   // unit quad
+layout(location = 1) in vec2 texCoord;
+
+layout(location = 2) in vec2 iPosition;
+layout(location = 3) in vec4 iColor;
+
+uniform mat4 uMatrix; // camera matrix
+uniform vec2 uSize;   // particle width, height
+
+out vec2 vTexCoord;
+out vec4 vColor;
+
+void main()
+{
+	gl_Position = uMatrix * vec4(iPosition + vertex.xy * uSize, vertex.z, 1);
+	vTexCoord = texCoord;
+	vColor = iColor;
+}
@@ -2,14 +2,14 @@
 
 #include <Odin/SceneManager.hpp>
 #include <Odin/TextureManager.hpp>
+#include <Odin/ParticleBatch.hpp>
 
 #include "EntityFactory.h"
 #include "Scenes.hpp"
 
 #include <functional>
-#include <future>
 
-#include "OpenCLKernel.h"
+#include "ParticleStore.hpp"
 
 using odin::GraphicalComponent;
 using odin::PhysicalComponent;
@@ -18,37 +18,6 @@ using odin::Entity;
 using odin::EntityId;
 using odin::Scene;
 
-struct Particle
-{
-    float     lifetime;
-    cl_float4 color = { 1, 1, 1, 1 };
-    cl_float2 position = { 0, 0 };
-    cl_float2 velocity = { 0, 0 };
-    
-    Particle() = default;
-
-    Particle( float lifetime, glm::vec4 color,
-              glm::vec2 pos, glm::vec2 vel )
-        : lifetime( lifetime )
-        , color( { color.x, color.y, color.z, color.w } )
-        , position( { pos.x, pos.y } )
-        , velocity( { vel.x, vel.y } )
-    {
-    }
-
-    bool isExpired() const
-    {
-        return lifetime <= 0;
-    }
-
-    static void default_update( Particle& p, float step )
-    {
-        p.lifetime -= step;
-        p.position.x += p.velocity.x * step;
-        p.position.y += p.velocity.y * step;
-    }
-};
-
 class ParticleEmitter
 {
 public:
@@ -69,9 +38,10 @@ public:
     glm::vec4 color = { 1, 1, 1, 1 };
     glm::vec4 colorVariance = { 0, 0, 0, 0 };
 
-    std::vector< Particle > particles;
+    float gravity = -100;
+    float fadeRate = 0; // Alpha lost per second.
 
-    std::function< void( Particle&, float ) > fnUpdate;
+    ParticleStore particles;
 
     ParticleEmitter( glm::vec2 position )
         : position( position )
@@ -94,8 +64,9 @@ public:
         , lifetimeVariance( move.lifetimeVariance )
         , color( move.color )
         , colorVariance( move.colorVariance )
+        , gravity( move.gravity )
+        , fadeRate( move.fadeRate )
         , particles( std::move( move.particles ) )
-        , fnUpdate( std::move( move.fnUpdate ) )
     {
     }
 
@@ -112,20 +83,22 @@ public:
         lifetimeVariance = move.lifetimeVariance;
         color = move.color;
         colorVariance = move.colorVariance;
+        gravity = move.gravity;
+        fadeRate = move.fadeRate;
         particles = std::move( move.particles );
-        fnUpdate = std::move( move.fnUpdate );
         return *this;
     }
 
     ~ParticleEmitter() = default;
 
-    Particle* emitt( int n = 1 )
+    // Emitts n particles. Returns the index of the first new particle.
+    size_t emitt( int n = 1 )
     {
+        size_t first = particles.size();
         if ( n < 1 )
-            return nullptr;
+            return first;
 
-        particles.reserve( particles.size() + n );
-        size_t first = particles.size();
+        particles.reserve( first + n );
 
         while ( n-- > 0 )
         {
@@ -137,13 +110,13 @@ public:
                 length * glm::sin( angle )
             };
 
-            particles.push_back( Particle(
-            apply_variance( lifetime, lifetimeVariance ),
-            apply_variance( color, colorVariance ),
-                position, vel ) );
+            particles.push(
+                apply_variance( lifetime, lifetimeVariance ),
+                apply_variance( color, colorVariance ),
+                position, vel );
         }
 
-        return &particles[ first ];
+        return first;
     }
 
     void spawn( float timeStep )
@@ -156,24 +129,8 @@ public:
 
     void update( float timeStep )
     {
-        for ( Particle& p : particles )
-        {
-            p.velocity.y += -100 * timeStep;
-            Particle::default_update( p, timeStep );
-        }
-
-        auto split = std::remove_if( particles.begin(), particles.end(),
-            []( Particle& p ) {
-                return p.isExpired();
-            } );
-
-        if ( fnUpdate )
-            std::for_each( particles.begin(), split,
-                [this, timeStep]( Particle& p ) {
-                    fnUpdate( p, timeStep );
-                } );
-
-        particles.erase( split, particles.end() );
+        particles.integrate( timeStep, gravity, fadeRate );
+        particles.compact();
 
         if ( active && spawnRate > 0 )
             spawn( timeStep );
@@ -181,12 +138,7 @@ public:
 
     void update2( float timeStep )
     {
-        auto split = std::remove_if( particles.begin(), particles.end(),
-            []( Particle& p ) {
-                return p.isExpired();
-            } );
-
-        particles.erase( split, particles.end() );
+        particles.compact();
 
         if ( active && spawnRate > 0 )
             spawn( timeStep );
@@ -256,17 +208,17 @@ public:
             {
                 player->alive = false;
                 EntityId eid { "player", (uint16_t) playerIndex };
-                pScene->_spawnParticle( pScene->entities[ eid ].position );
+                pScene->_spawnParticle( pScene->transform( eid ).position );
             }
         }
     };
 
     std::vector< ParticleEmitter > emitters;
 
-    //OpenCLKernel< Particle*, float > updater0;
-
     std::array< int, MAX_PLAYERS > controllerRedirect;
 
+    odin::ParticleBatch particleBatch;
+
 	TestScene( int width, int height,
                std::array< int, MAX_PLAYERS > playerDat )
 		: LevelScene( width, height, "Audio/Banks/MasterBank",
@@ -274,8 +226,8 @@ public:
                           begin( playerDat ),
                           end( playerDat ),
                           -1 ) )
-        //, updater0( "ParticleSystem.cl" )
         , controllerRedirect( playerDat )
+        , particleBatch( load_shaders( "Shaders/vertexParticle.glsl", "Shaders/fragmentInstanced.glsl" ), 2048 )
 	{
 	}
 
@@ -293,9 +245,7 @@ public:
         emitter.velocityAngle = 0;
         emitter.velocityAngleVariance = glm::pi< float >();
 
-        emitter.fnUpdate = []( Particle& p, float timeStep ) {
-            p.color.w -= timeStep / 3;
-        };
+        emitter.fadeRate = 1.f / 3;
 
         emitter.emitt( 500 );
 
@@ -309,59 +259,18 @@ public:
 		pAudioEngine->stopAllEvents();
 	}
 
-    //void updateEmitter( OpenCLKernel< Particle*, float >& updater, ParticleEmitter& em, float t )
-    //{
-    //    updater.globalWorkSize[ 0 ] = em.particles.size();
-    //    updater( em.particles, t );
-    //    em.update2( t );
-    //}
-
     void update( unsigned ticks )
     {
         LevelScene::update( ticks );
 
-        /*for ( int i = 0; i < emitters.size(); i += 4 )
-        {
-            int chunk_size = emitters.size() - i;
-
-            std::thread* threads[ 4 ];
-
-            switch ( chunk_size )
-            {
-            default: threads[ 3 ] = new std::thread( [this, i]() {
-                updateEmitter( updater3, emitters[ i + 3 ], Scene::ticksDiff / 1000.f );
-            } );
-            case 3: threads[ 2 ] = new std::thread( [this, i]() {
-                updateEmitter( updater2, emitters[ i + 2 ], Scene::ticksDiff / 1000.f );
-            } );
-            case 2: threads[ 1 ] = new std::thread( [this, i]() {
-                updateEmitter( updater1, emitters[ i + 1 ], Scene::ticksDiff / 1000.f );
-            } );
-            case 1: threads[ 0 ] = new std::thread( [this, i]() {
-                updateEmitter( updater0, emitters[ i + 0 ], Scene::ticksDiff / 1000.f );
-            } );
-            }
-
-            for ( int i = 0; i < std::min( chunk_size - 1, 4 ); ++i )
-            {
-                threads[ i ]->join();
-                delete threads[ i ];
-            }
-        }*/
-
-        std::vector< std::future< void > > futures;
-        futures.reserve( emitters.size() );
-
+        // One emitter per job; emitters vary a lot in size so idle
+        // workers steal the rest.
         float tDiff = Scene::ticksDiff / 1000.f;
-        for ( auto& em : emitters )
-        {
-            futures.push_back( std::async( [&] { em.update( tDiff ); } ) );
-            //updater0.settings.globalWorkSize[ 0 ] = em.particles.size();
-            //futures.push_back( updater0( em.particles, tDiff ) );
-        }
-
-        for ( auto& fut : futures )
-            fut.get();
+        jobs.parallel_for( emitters.size(), 1,
+            [this, tDiff]( size_t first, size_t last ) {
+                for ( size_t i = first; i < last; ++i )
+                    emitters[ i ].update( tDiff );
+            } );
 
         //for ( auto& em : emitters )
         //    em.update2( tDiff );
@@ -374,53 +283,37 @@ public:
         emitters.erase( itr, emitters.end() );
     }
 
-    GraphicalComponent _gfx = GraphicalComponent::makeRect( 1, 1 );
-
     void draw()
     {
         LevelScene::draw();
 
-        using namespace glm;
-		
-        glUseProgram( program );
-        glUniform( uTexture, _gfx.texture );
-        glUniform( uFacingDirection, _gfx.direction );
-
-        glUniform( uCurrentAnim, 0.f );
-        glUniform( uCurrentFrame, 0.f );
-        glUniform( uMaxFrame, 1.f );
-        glUniform( uMaxAnim, 1.f );
-
-        glBindVertexArray( _gfx.vertexArray );
+        particleBatch.begin( camera.getCameraMatrix() );
 
         for ( auto& emitter : emitters )
         {
-            for ( Particle& p : emitter.particles )
-            {
-                if ( p.isExpired() )
-                    continue;
-
-                mat4 mtx = camera.getCameraMatrix()
-                    * translate( {}, vec3( p.position.x, p.position.y, 0 ) );
+            const ParticleStore& ps = emitter.particles;
+            auto* out = particleBatch.append( ps.size() );
 
-                glUniform( uMatrix, mtx );
-                glUniform( uColor, vec4( p.color.x, p.color.y, p.color.z, p.color.w ) );
-                glDrawArrays( GL_TRIANGLES, 0, _gfx.count );
+            for ( size_t i = 0; i < ps.size(); ++i )
+            {
+                out[ i ].position = { ps.px[ i ], ps.py[ i ] };
+                out[ i ].color = { ps.r[ i ], ps.g[ i ], ps.b[ i ], ps.a[ i ] };
             }
         }
+
+        particleBatch.end( NULL_TEXTURE );
 	}
 
 	void init( unsigned ticks )
     {
         LevelScene::init( ticks );
 
-        Entity2& bg = entities[ EntityId( 0 ) ];
-        bg.pDrawable = newGraphics( GraphicalComponent::makeRect( width, height ) );
-		bg.pDrawable->texture = BACKGROUND_ANIM;
-		bg.pDrawable->interactive = false;
-		bg.pAnimator = newAnimator(AnimatorComponent({ 9 }));
-		bg.pAnimator->loop = false;
-		bg.pAnimator->currentFrame = 0;
+        GraphicalComponent& bg = attach( EntityId( 0 ), GraphicalComponent::makeRect( width, height ) );
+		bg.texture = BACKGROUND_ANIM;
+		bg.interactive = false;
+		AnimatorComponent& bgAnim = attach(EntityId( 0 ), AnimatorComponent({ 9 }));
+		bgAnim.loop = false;
+		bgAnim.currentFrame = 0;
 
         listeners.push_back( [this]( const InputManager& inmn ) {
             if ( inmn.wasKeyPressed( SDLK_BACKSPACE ) )
@@ -526,7 +419,7 @@ public:
 		wallFilter.categoryBits = PLATFORM;
 		wallFilter.maskBits = PLAYER | HORSE | BULLET | DEAD;
 
-        b2Body* floorBody = entities[ "floor" ].pBody = newBody( floorDef );
+        b2Body* floorBody = attach< b2Body* >( "floor", newBody( floorDef ) );
 
 		b2Fixture* fix = floorBody->CreateFixture(&boundingShape, 1);
 		fix->SetFriction(odin::PhysicalComponent::DEFAULT_FRICTION);
@@ -534,7 +427,7 @@ public:
 
 		boundingShape.Set({ 24, 14.5 }, { 24, -14.5 }); //right wall plane
 
-        b2Body* wallRBody = entities[ "wallR" ].pBody = newBody( floorDef );
+        b2Body* wallRBody = attach< b2Body* >( "wallR", newBody( floorDef ) );
 
 		fix = wallRBody->CreateFixture(&boundingShape, 1);
 		fix->SetFriction(odin::PhysicalComponent::DEFAULT_FRICTION);
@@ -542,7 +435,7 @@ public:
 
 		boundingShape.Set({ -24, 14.5 }, { -24, -14.5 }); // left wall plane
 
-        b2Body* wallLBody = entities[ "wallL" ].pBody = newBody( floorDef );
+        b2Body* wallLBody = attach< b2Body* >( "wallL", newBody( floorDef ) );
 
 		fix = wallLBody->CreateFixture(&boundingShape, 1);
 		fix->SetFriction(odin::PhysicalComponent::DEFAULT_FRICTION);
@@ -550,7 +443,7 @@ public:
 
 		boundingShape.Set({ -24, 14.5 }, { 24, 14.5 }); //ceiling
 
-		b2Body* ceilBody = entities[ "ceil" ].pBody = newBody( floorDef );
+		b2Body* ceilBody = attach< b2Body* >( "ceil", newBody( floorDef ) );
 		fix = ceilBody->CreateFixture(&boundingShape, 1);
 		fix->SetFriction(odin::PhysicalComponent::DEFAULT_FRICTION);
 		fix->SetFilterData(wallFilter);
@@ -571,6 +464,8 @@ public:
 
     void resume( unsigned tick ) override
     {
+        LevelScene::resume( tick );
+
         odin::load_texture< GLubyte[4] >( NULL_TEXTURE, 1, 1, { 0xFF, 0xFF, 0xFF, 0xFF } );
         odin::load_texture(GROUND1, "Textures/ground.png");
         odin::load_texture(BARREL, "Textures/barrel.png");
@@ -16,8 +16,7 @@ public:
 	EntityMap< GraphicalComponent > gfxComponents;
 	EntityMap< AnimatorComponent > animComponents;
 
-	b2ThreadPool                    b2thd;
-	b2World                         b2world = { { 0.f, -9.81f }, &b2thd };
+	b2World                         b2world = { { 0.f, -9.81f }, &odin::physics_executor() };
 	EntityMap< PhysicalComponent >  fsxComponents;
 
 	InputManager*                   pInputManager;
@@ -3,31 +3,47 @@
 
 #include "Allocators.hpp"
 
-#include <bitset>
+#include <cstdint>
 
+// Allocates slots of type T from this object. Free slots are linked in
+// a list, so allocate and deallocate are O(1). The most recently freed
+// slot is handed out first, while it's still in the cache. A bitmap of
+// the occupied slots lets for_each_live skip 64 free slots at a time.
 template< typename T, size_t Max >
 class TypedAllocator
 {
 public:
 
     using Type = T;
+    using Word = std::uint64_t;
+
     static constexpr size_t SIZE = Max;
+    static constexpr size_t BITS_PER_WORD = 8 * sizeof( Word );
+
+    static_assert( SIZE < UINT32_MAX, "TypedAllocator: too many slots" );
 
-    std::bitset< SIZE > occupancy;
     Type slots[ SIZE ];
 
+    TypedAllocator()
+    {
+        for ( size_t i = 0; i < SIZE; ++i )
+            _next[ i ] = std::uint32_t( i + 1 );
+    }
+
+    TypedAllocator( const TypedAllocator& ) = delete;
+    TypedAllocator& operator =( const TypedAllocator& ) = delete;
+
     Blk allocate( size_t size = sizeof( Type ) )
     {
         assert( size == sizeof( Type ) );
 
-        size_t i = 0;
-        while ( i < SIZE && occupancy.test( i ) )
-            ++i;
-
-        if ( i == SIZE )
+        if ( _free == SIZE )
             return nullptr;
 
-        occupancy.set( i );
+        size_t i = _free;
+        _free = _next[ i ];
+        _occupancy[ i / BITS_PER_WORD ] |= _bit( i );
+        ++_count;
         return slots + i;
     }
 
@@ -39,11 +55,58 @@ public:
         assert( owns( blk.ptr ) );
 
         size_t i = ((Type*) blk.ptr) - slots;
-        occupancy.set( i, false );
+        assert( occupied( i ) );
+
+        _occupancy[ i / BITS_PER_WORD ] &= ~_bit( i );
+        _next[ i ] = _free;
+        _free = std::uint32_t( i );
+        --_count;
     }
 
     constexpr bool owns( void* ptr )
     {
         return slots <= ptr && ptr < slots + SIZE;
     }
+
+    bool occupied( size_t i ) const
+    {
+        return (_occupancy[ i / BITS_PER_WORD ] & _bit( i )) != 0;
+    }
+
+    // Returns the number of occupied slots.
+    size_t count() const
+    {
+        return _count;
+    }
+
+    // Calls fn with every occupied slot, in the order of the slots.
+    // fn may deallocate the slot it's given.
+    template< typename Fn >
+    void for_each_live( Fn fn )
+    {
+        for ( size_t w = 0; w < WORDS; ++w )
+        {
+            Word word = _occupancy[ w ];
+            while ( word != 0 )
+            {
+                size_t i = w * BITS_PER_WORD + count_trailing_zeros( word );
+                word &= word - 1; // Clear the lowest set bit.
+                fn( slots[ i ] );
+            }
+        }
+    }
+
+private:
+
+    static constexpr size_t WORDS = (SIZE + BITS_PER_WORD - 1) / BITS_PER_WORD;
+
+    Word          _occupancy[ WORDS ] = { 0 }; // Bit per slot; set if it's allocated.
+    std::uint32_t _next[ SIZE ];               // Next free slot after each free slot.
+    std::uint32_t _free = 0;                   // First free slot, or SIZE if there isn't one.
+    size_t        _count = 0;
+
+    static constexpr Word _bit( size_t i )
+    {
+        return Word( 1 ) << (i % BITS_PER_WORD);
+    }
 };
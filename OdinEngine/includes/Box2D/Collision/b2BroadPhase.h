@@ -101,6 +101,11 @@ public:
 	template <typename T>
 	void RayCast(T* callback, const b2RayCastInput& input) const;
 
+	/// Ray-cast a batch of rays against the proxies in the tree.
+	/// See b2DynamicTree::RayCastBatch.
+	template <typename T>
+	void RayCastBatch(T* callback, const b2RayCastInput* inputs, int32 count) const;
+
 	/// Get the height of the embedded tree.
 	int32 GetTreeHeight() const;
 
@@ -269,6 +274,12 @@ inline void b2BroadPhase::RayCast(T* callback, const b2RayCastInput& input) cons
 	m_tree.RayCast(callback, input);
 }
 
+template <typename T>
+inline void b2BroadPhase::RayCastBatch(T* callback, const b2RayCastInput* inputs, int32 count) const
+{
+	m_tree.RayCastBatch(callback, inputs, count);
+}
+
 inline void b2BroadPhase::ShiftOrigin(const b2Vec2& newOrigin)
 {
 	m_tree.ShiftOrigin(newOrigin);
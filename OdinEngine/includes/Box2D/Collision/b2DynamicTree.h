@@ -21,9 +21,13 @@
 
 #include <Box2D/Collision/b2Collision.h>
 #include <Box2D/Common/b2GrowableStack.h>
+#include <Box2D/Common/b2Simd.h>
 
 #define b2_nullNode (-1)
 
+/// The number of rays RayCastBatch traverses the tree with at once.
+#define b2_rayPacketSize 4
+
 /// A node in the dynamic tree. The client does not interact with this directly.
 struct b2TreeNode
 {
@@ -101,6 +105,19 @@ public:
 	template <typename T>
 	void RayCast(T* callback, const b2RayCastInput& input) const;
 
+	/// Ray-cast a batch of rays against the proxies in the tree. The rays traverse
+	/// the tree in packets of b2_rayPacketSize, testing a node against every ray
+	/// of the packet at once, so each node is fetched once per packet. The callback
+	/// sees the same proxies, in the same order, as RayCast would for each ray.
+	/// Only reads the tree, so batches may be cast from several threads at once.
+	/// @param inputs the rays. Each ray extends from p1 to p1 + maxFraction * (p2 - p1).
+	/// @param count the number of rays.
+	/// @param callback a callback class with a RayCastCallback(input, proxyId, rayIndex)
+	/// method. It is called for each proxy that is hit by ray rayIndex and works
+	/// like the RayCast callback, but terminating only stops that ray.
+	template <typename T>
+	void RayCastBatch(T* callback, const b2RayCastInput* inputs, int32 count) const;
+
 	/// Validate this tree. For testing.
 	void Validate() const;
 
@@ -286,4 +303,161 @@ inline void b2DynamicTree::RayCast(T* callback, const b2RayCastInput& input) con
 	}
 }
 
+template <typename T>
+inline void b2DynamicTree::RayCastBatch(T* callback, const b2RayCastInput* inputs, int32 count) const
+{
+	for (int32 first = 0; first < count; first += b2_rayPacketSize)
+	{
+		int32 packetCount = b2Min(count - first, b2_rayPacketSize);
+
+		// Lane by lane copies of the rays. Lanes without a ray have an empty
+		// segment AABB, which overlaps nothing.
+		float32 p1x[b2_rayPacketSize], p1y[b2_rayPacketSize];
+		float32 vx[b2_rayPacketSize], vy[b2_rayPacketSize];
+		float32 absVx[b2_rayPacketSize], absVy[b2_rayPacketSize];
+		float32 lowerX[b2_rayPacketSize], lowerY[b2_rayPacketSize];
+		float32 upperX[b2_rayPacketSize], upperY[b2_rayPacketSize];
+		float32 maxFractions[b2_rayPacketSize];
+		int32 active = 0;
+
+		for (int32 lane = 0; lane < b2_rayPacketSize; ++lane)
+		{
+			b2Vec2 p1 = b2Vec2_zero;
+			b2Vec2 v = b2Vec2_zero;
+			b2AABB segmentAABB;
+			segmentAABB.lowerBound.Set(b2_maxFloat, b2_maxFloat);
+			segmentAABB.upperBound.Set(-b2_maxFloat, -b2_maxFloat);
+			float32 maxFraction = 0.0f;
+
+			if (lane < packetCount)
+			{
+				const b2RayCastInput& input = inputs[first + lane];
+				p1 = input.p1;
+				b2Vec2 p2 = input.p2;
+				b2Vec2 r = p2 - p1;
+				b2Assert(r.LengthSquared() > 0.0f);
+				r.Normalize();
+
+				// v is perpendicular to the segment.
+				v = b2Cross(1.0f, r);
+
+				maxFraction = input.maxFraction;
+				b2Vec2 t = p1 + maxFraction * (p2 - p1);
+				segmentAABB.lowerBound = b2Min(p1, t);
+				segmentAABB.upperBound = b2Max(p1, t);
+				active |= 1 << lane;
+			}
+
+			b2Vec2 abs_v = b2Abs(v);
+			p1x[lane] = p1.x;
+			p1y[lane] = p1.y;
+			vx[lane] = v.x;
+			vy[lane] = v.y;
+			absVx[lane] = abs_v.x;
+			absVy[lane] = abs_v.y;
+			lowerX[lane] = segmentAABB.lowerBound.x;
+			lowerY[lane] = segmentAABB.lowerBound.y;
+			upperX[lane] = segmentAABB.upperBound.x;
+			upperY[lane] = segmentAABB.upperBound.y;
+			maxFractions[lane] = maxFraction;
+		}
+
+		b2Float4 rayP1x = b2Load4(p1x), rayP1y = b2Load4(p1y);
+		b2Float4 rayVx = b2Load4(vx), rayVy = b2Load4(vy);
+		b2Float4 rayAbsVx = b2Load4(absVx), rayAbsVy = b2Load4(absVy);
+		b2Float4 segmentLowerX = b2Load4(lowerX), segmentLowerY = b2Load4(lowerY);
+		b2Float4 segmentUpperX = b2Load4(upperX), segmentUpperY = b2Load4(upperY);
+		b2Float4 zero = b2Splat4(0.0f);
+
+		b2GrowableStack<int32, 256> stack;
+		stack.Push(m_root);
+
+		while (stack.GetCount() > 0 && active != 0)
+		{
+			int32 nodeId = stack.Pop();
+			if (nodeId == b2_nullNode)
+			{
+				continue;
+			}
+
+			const b2TreeNode* node = m_nodes + nodeId;
+
+			// b2TestOverlap of the node AABB and each segment AABB.
+			b2Float4 nodeLowerX = b2Splat4(node->aabb.lowerBound.x);
+			b2Float4 nodeLowerY = b2Splat4(node->aabb.lowerBound.y);
+			b2Float4 nodeUpperX = b2Splat4(node->aabb.upperBound.x);
+			b2Float4 nodeUpperY = b2Splat4(node->aabb.upperBound.y);
+			b2Float4 apart = b2Or(
+				b2Or(b2Greater(segmentLowerX - nodeUpperX, zero), b2Greater(segmentLowerY - nodeUpperY, zero)),
+				b2Or(b2Greater(nodeLowerX - segmentUpperX, zero), b2Greater(nodeLowerY - segmentUpperY, zero)));
+
+			// Separating axis for segment (Gino, p80).
+			// |dot(v, p1 - c)| > dot(|v|, h)
+			b2Vec2 c = node->aabb.GetCenter();
+			b2Vec2 h = node->aabb.GetExtents();
+			b2Float4 separation = b2Abs(rayVx * (rayP1x - b2Splat4(c.x)) + rayVy * (rayP1y - b2Splat4(c.y)))
+				- (rayAbsVx * b2Splat4(h.x) + rayAbsVy * b2Splat4(h.y));
+			apart = b2Or(apart, b2Greater(separation, zero));
+
+			int32 hits = ~b2MoveMask(apart) & active;
+			if (hits == 0)
+			{
+				continue;
+			}
+
+			if (node->IsLeaf() == false)
+			{
+				stack.Push(node->child1);
+				stack.Push(node->child2);
+				continue;
+			}
+
+			for (int32 lane = 0; lane < packetCount; ++lane)
+			{
+				if ((hits & (1 << lane)) == 0)
+				{
+					continue;
+				}
+
+				const b2RayCastInput& input = inputs[first + lane];
+				b2RayCastInput subInput;
+				subInput.p1 = input.p1;
+				subInput.p2 = input.p2;
+				subInput.maxFraction = maxFractions[lane];
+
+				float32 value = callback->RayCastCallback(subInput, nodeId, first + lane);
+
+				if (value == 0.0f)
+				{
+					// The client has terminated this ray. Its segment no longer overlaps anything.
+					active &= ~(1 << lane);
+					lowerX[lane] = lowerY[lane] = b2_maxFloat;
+					upperX[lane] = upperY[lane] = -b2_maxFloat;
+				}
+				else if (value > 0.0f)
+				{
+					// Update segment bounding box.
+					maxFractions[lane] = value;
+					b2Vec2 t = input.p1 + value * (input.p2 - input.p1);
+					b2Vec2 lower = b2Min(input.p1, t);
+					b2Vec2 upper = b2Max(input.p1, t);
+					lowerX[lane] = lower.x;
+					lowerY[lane] = lower.y;
+					upperX[lane] = upper.x;
+					upperY[lane] = upper.y;
+				}
+				else
+				{
+					continue;
+				}
+
+				segmentLowerX = b2Load4(lowerX);
+				segmentLowerY = b2Load4(lowerY);
+				segmentUpperX = b2Load4(upperX);
+				segmentUpperY = b2Load4(upperY);
+			}
+		}
+	}
+}
+
 #endif
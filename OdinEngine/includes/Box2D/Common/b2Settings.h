@@ -149,6 +149,19 @@ typedef double float64;
 /// How much does an island need to cost before the world stops adding bodies to it?
 #define b2_minIslandCost			100
 
+/// How many contacts does an island need before its contacts are solved by several threads?
+#define b2_minColoredContacts		512
+
+/// The minimum number of contacts a contact solver task should solve.
+#define b2_minContactsPerTask		64
+
+/// How many contacts does an island need before the wide contact solver is used?
+#define b2_minWideContacts			32
+
+/// The maximum number of colors used to group the contacts of an island.
+/// Contacts that don't fit into these colors are solved by one thread.
+#define b2_maxConstraintColors		32
+
 /// Get the estimated cost of solving an island with the specified attributes
 int32 b2GetIslandCost(int32 bodyCount, int32 contactCount, int32 jointCount);
 
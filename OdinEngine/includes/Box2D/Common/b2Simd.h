@@ -0,0 +1,95 @@
+/*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_SIMD_H
+#define B2_SIMD_H
+
+#include <Box2D/Common/b2Settings.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define B2_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+/// Four floats operated on together. Uses SSE2 if available, otherwise a loop
+/// over the lanes; both give the same results as the scalar operations.
+/// Comparisons return lane masks which are only meant for b2And, b2Or,
+/// b2Select and b2MoveMask.
+#ifdef B2_SIMD_SSE2
+struct b2Float4
+{
+	__m128 v;
+};
+
+inline b2Float4 b2MakeFloat4(__m128 v) { b2Float4 r; r.v = v; return r; }
+inline b2Float4 b2Load4(const float32* p) { return b2MakeFloat4(_mm_loadu_ps(p)); }
+inline void b2Store4(float32* p, b2Float4 a) { _mm_storeu_ps(p, a.v); }
+inline b2Float4 b2Splat4(float32 s) { return b2MakeFloat4(_mm_set1_ps(s)); }
+inline b2Float4 operator + (b2Float4 a, b2Float4 b) { return b2MakeFloat4(_mm_add_ps(a.v, b.v)); }
+inline b2Float4 operator - (b2Float4 a, b2Float4 b) { return b2MakeFloat4(_mm_sub_ps(a.v, b.v)); }
+inline b2Float4 operator * (b2Float4 a, b2Float4 b) { return b2MakeFloat4(_mm_mul_ps(a.v, b.v)); }
+inline b2Float4 operator - (b2Float4 a) { return b2MakeFloat4(_mm_xor_ps(a.v, _mm_set1_ps(-0.0f))); }
+inline b2Float4 b2Abs(b2Float4 a) { return b2MakeFloat4(_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)); }
+inline b2Float4 b2Min(b2Float4 a, b2Float4 b) { return b2MakeFloat4(_mm_min_ps(a.v, b.v)); }
+inline b2Float4 b2Max(b2Float4 a, b2Float4 b) { return b2MakeFloat4(_mm_max_ps(a.v, b.v)); }
+inline b2Float4 b2Greater(b2Float4 a, b2Float4 b) { return b2MakeFloat4(_mm_cmpgt_ps(a.v, b.v)); }
+inline b2Float4 b2GreaterEqual(b2Float4 a, b2Float4 b) { return b2MakeFloat4(_mm_cmpge_ps(a.v, b.v)); }
+inline b2Float4 b2And(b2Float4 a, b2Float4 b) { return b2MakeFloat4(_mm_and_ps(a.v, b.v)); }
+inline b2Float4 b2Or(b2Float4 a, b2Float4 b) { return b2MakeFloat4(_mm_or_ps(a.v, b.v)); }
+inline b2Float4 b2Select(b2Float4 mask, b2Float4 a, b2Float4 b)
+{
+	return b2MakeFloat4(_mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)));
+}
+/// Bit i is set if lane i of the mask is set.
+inline int32 b2MoveMask(b2Float4 mask) { return _mm_movemask_ps(mask.v); }
+#else
+struct b2Float4
+{
+	float32 v[4];
+};
+
+#define B2_FLOAT4_OP(expr) b2Float4 r; for (int32 i = 0; i < 4; ++i) { r.v[i] = (expr); } return r
+
+inline b2Float4 b2Load4(const float32* p) { B2_FLOAT4_OP(p[i]); }
+inline void b2Store4(float32* p, b2Float4 a) { for (int32 i = 0; i < 4; ++i) { p[i] = a.v[i]; } }
+inline b2Float4 b2Splat4(float32 s) { B2_FLOAT4_OP(s); }
+inline b2Float4 operator + (b2Float4 a, b2Float4 b) { B2_FLOAT4_OP(a.v[i] + b.v[i]); }
+inline b2Float4 operator - (b2Float4 a, b2Float4 b) { B2_FLOAT4_OP(a.v[i] - b.v[i]); }
+inline b2Float4 operator * (b2Float4 a, b2Float4 b) { B2_FLOAT4_OP(a.v[i] * b.v[i]); }
+inline b2Float4 operator - (b2Float4 a) { B2_FLOAT4_OP(-a.v[i]); }
+inline b2Float4 b2Abs(b2Float4 a) { B2_FLOAT4_OP(a.v[i] < 0.0f ? -a.v[i] : a.v[i]); }
+inline b2Float4 b2Min(b2Float4 a, b2Float4 b) { B2_FLOAT4_OP(a.v[i] < b.v[i] ? a.v[i] : b.v[i]); }
+inline b2Float4 b2Max(b2Float4 a, b2Float4 b) { B2_FLOAT4_OP(a.v[i] > b.v[i] ? a.v[i] : b.v[i]); }
+inline b2Float4 b2Greater(b2Float4 a, b2Float4 b) { B2_FLOAT4_OP(a.v[i] > b.v[i] ? 1.0f : 0.0f); }
+inline b2Float4 b2GreaterEqual(b2Float4 a, b2Float4 b) { B2_FLOAT4_OP(a.v[i] >= b.v[i] ? 1.0f : 0.0f); }
+inline b2Float4 b2And(b2Float4 a, b2Float4 b) { B2_FLOAT4_OP(a.v[i] != 0.0f && b.v[i] != 0.0f ? 1.0f : 0.0f); }
+inline b2Float4 b2Or(b2Float4 a, b2Float4 b) { B2_FLOAT4_OP(a.v[i] != 0.0f || b.v[i] != 0.0f ? 1.0f : 0.0f); }
+inline b2Float4 b2Select(b2Float4 mask, b2Float4 a, b2Float4 b) { B2_FLOAT4_OP(mask.v[i] != 0.0f ? a.v[i] : b.v[i]); }
+/// Bit i is set if lane i of the mask is set.
+inline int32 b2MoveMask(b2Float4 mask)
+{
+	int32 bits = 0;
+	for (int32 i = 0; i < 4; ++i)
+	{
+		bits |= mask.v[i] != 0.0f ? 1 << i : 0;
+	}
+	return bits;
+}
+
+#undef B2_FLOAT4_OP
+#endif
+
+#endif
@@ -20,21 +20,167 @@
 #include <Box2D/Common/b2Math.h>
 #include <Box2D/Common/b2StackAllocator.h>
 #include <algorithm>
+#include <new>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#include <emmintrin.h>
+#define b2Pause() _mm_pause()
+#else
+#define b2Pause() std::this_thread::yield()
+#endif
 
 using std::thread;
 using std::unique_lock;
 using std::mutex;
 
-const int32 b2_initialPendingTaskCapacity = 256;
+const int32 b2_initialTaskDequeCapacity = 64;
 
 // Compare the cost of two tasks.
-bool b2TaskLessThan(const b2Task* l, const b2Task* r)
+bool b2TaskGreaterThan(const b2Task* l, const b2Task* r)
+{
+	return l->GetCost() > r->GetCost();
+}
+
+// The slots publish the tasks themselves: a thief's acquire load of a slot
+// sees everything the owner wrote to the task before its release store. The
+// indices are ordered by acquire/release too, rather than by standalone
+// fences, which ThreadSanitizer doesn't model.
+inline b2Task* b2TaskDeque::Buffer::Get(Index i) const
+{
+	return tasks[i & (capacity - 1)].load(std::memory_order_acquire);
+}
+
+inline void b2TaskDeque::Buffer::Put(Index i, b2Task* task)
+{
+	tasks[i & (capacity - 1)].store(task, std::memory_order_release);
+}
+
+// Allocate a buffer. The capacity must be a power of two.
+static void* b2AllocTaskBuffer(long long capacity)
+{
+	void* mem = b2Alloc(int32(capacity * sizeof(std::atomic<b2Task*>)));
+	for (long long i = 0; i < capacity; ++i)
+	{
+		new((std::atomic<b2Task*>*)mem + i) std::atomic<b2Task*>(NULL);
+	}
+	return mem;
+}
+
+b2TaskDeque::b2TaskDeque()
+{
+	Buffer* buffer = (Buffer*)b2Alloc(sizeof(Buffer));
+	buffer->capacity = b2_initialTaskDequeCapacity;
+	buffer->tasks = (std::atomic<b2Task*>*)b2AllocTaskBuffer(buffer->capacity);
+	buffer->previous = NULL;
+
+	m_top.store(0, std::memory_order_relaxed);
+	m_bottom.store(0, std::memory_order_relaxed);
+	m_buffer.store(buffer, std::memory_order_relaxed);
+}
+
+b2TaskDeque::~b2TaskDeque()
+{
+	Buffer* buffer = m_buffer.load(std::memory_order_relaxed);
+	while (buffer)
+	{
+		Buffer* previous = buffer->previous;
+		b2Free(buffer->tasks);
+		b2Free(buffer);
+		buffer = previous;
+	}
+}
+
+b2TaskDeque::Buffer* b2TaskDeque::Grow(Buffer* buffer, Index top, Index bottom)
+{
+	Buffer* grown = (Buffer*)b2Alloc(sizeof(Buffer));
+	grown->capacity = buffer->capacity * 2;
+	grown->tasks = (std::atomic<b2Task*>*)b2AllocTaskBuffer(grown->capacity);
+	grown->previous = buffer;
+
+	for (Index i = top; i < bottom; ++i)
+	{
+		grown->Put(i, buffer->Get(i));
+	}
+
+	return grown;
+}
+
+void b2TaskDeque::Push(b2Task* task)
+{
+	Index b = m_bottom.load(std::memory_order_relaxed);
+	Index t = m_top.load(std::memory_order_acquire);
+	Buffer* buffer = m_buffer.load(std::memory_order_relaxed);
+
+	if (b - t > buffer->capacity - 1)
+	{
+		buffer = Grow(buffer, t, b);
+		m_buffer.store(buffer, std::memory_order_release);
+	}
+
+	buffer->Put(b, task);
+
+	// Publish the task before the new bottom.
+	m_bottom.store(b + 1, std::memory_order_release);
+}
+
+b2Task* b2TaskDeque::Pop()
+{
+	Index b = m_bottom.load(std::memory_order_relaxed) - 1;
+	Buffer* buffer = m_buffer.load(std::memory_order_relaxed);
+	m_bottom.store(b, std::memory_order_relaxed);
+
+	// Make the reservation visible before reading top.
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	Index t = m_top.load(std::memory_order_relaxed);
+
+	if (t > b)
+	{
+		// Empty.
+		m_bottom.store(b + 1, std::memory_order_relaxed);
+		return NULL;
+	}
+
+	b2Task* task = buffer->Get(b);
+
+	if (t == b)
+	{
+		// This is the last task, so race the thieves for it.
+		if (m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed) == false)
+		{
+			task = NULL;
+		}
+		m_bottom.store(b + 1, std::memory_order_relaxed);
+	}
+
+	return task;
+}
+
+b2Task* b2TaskDeque::Steal(bool& retry)
 {
-	return l->GetCost() < r->GetCost();
+	Index t = m_top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	Index b = m_bottom.load(std::memory_order_acquire);
+
+	if (t >= b)
+	{
+		// Empty.
+		return NULL;
+	}
+
+	Buffer* buffer = m_buffer.load(std::memory_order_acquire);
+	b2Task* task = buffer->Get(t);
+
+	if (m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed) == false)
+	{
+		// Lost the race to the owner or another thief.
+		retry = true;
+		return NULL;
+	}
+
+	return task;
 }
 
-b2ThreadPool::b2ThreadPool(int32 threadCount)
-: m_pendingTasks(b2_initialPendingTaskCapacity)
+b2ThreadPool::b2ThreadPool(int32 threadCount, int32 spinCount)
 {
 	b2Assert(threadCount <= b2_maxThreadPoolThreads);
 	b2Assert(threadCount >= -1);
@@ -52,12 +198,16 @@ b2ThreadPool::b2ThreadPool(int32 threadCount)
 	threadCount = b2Max(threadCount, 0);
 
 	// Mark the pool as running.
-	m_signalShutdown = false;
+	m_signalShutdown.store(false, std::memory_order_relaxed);
+	m_pendingCount.store(0, std::memory_order_relaxed);
+	m_sleepingCount.store(0, std::memory_order_relaxed);
 
 	// Set the thread count.
 	m_threadCount = threadCount;
+	m_spinCount = b2Max(spinCount, 0);
 
 	// Construct worker threads.
+	m_threads = NULL;
 	if (threadCount > 0)
 	{
 		m_threads = (thread*)b2Alloc(threadCount * sizeof(thread));
@@ -80,89 +230,163 @@ int32 b2ThreadPool::GetThreadCount() const
 
 void b2ThreadPool::AddTasks(b2Task** tasks, int32 count)
 {
+	if (count == 0)
 	{
-		unique_lock<mutex> lk(m_taskMut);
-		for (int32 i = 0; i < count; ++i)
+		return;
+	}
+
+	int32 threadId = b2GetThreadId();
+	b2TaskDeque& deque = m_deques[threadId];
+	b2GrowableArray<b2Task*>& cheaper = m_requeued[threadId];
+
+	// Thieves steal from the top, so each deque is kept sorted with the most
+	// expensive tasks on top. The owner pops from the bottom and so works through
+	// its own tasks cheapest first, while idle threads take the expensive ones.
+	std::stable_sort(tasks, tasks + count, b2TaskGreaterThan);
+
+	// Take back queued tasks that cost less than the new ones so all of them
+	// can be pushed in order. Of tasks with equal cost, older ones stay on top.
+	b2Task* task;
+	while ((task = deque.Pop()) != NULL)
+	{
+		if (task->GetCost() >= tasks[0]->GetCost())
 		{
-			m_pendingTasks.Push(tasks[i]);
-			std::push_heap(m_pendingTasks.Data(), m_pendingTasks.Data() + m_pendingTasks.GetCount(), b2TaskLessThan);
+			deque.Push(task);
+			break;
 		}
+		cheaper.Push(task);
 	}
 
-	m_taskAddedCond.notify_all();
+	int32 i = 0;
+	while (i < count || cheaper.GetCount() > 0)
+	{
+		if (cheaper.GetCount() > 0 && (i == count || cheaper.Peek()->GetCost() >= tasks[i]->GetCost()))
+		{
+			deque.Push(cheaper.Pop());
+		}
+		else
+		{
+			deque.Push(tasks[i++]);
+		}
+	}
+
+	NotifyTasksAdded(count);
 }
 
-void b2ThreadPool::AddTask(b2Task* task)
+void b2ThreadPool::NotifyTasksAdded(int32 count)
 {
+	// Sequentially consistent so that either a worker going to sleep sees the new
+	// tasks, or this thread sees the sleeping worker.
+	m_pendingCount.fetch_add(count, std::memory_order_seq_cst);
+
+	if (m_sleepingCount.load(std::memory_order_seq_cst) == 0)
+	{
+		return;
+	}
+
+	// Sync with workers that are about to sleep so the notification isn't lost.
 	{
-		unique_lock<mutex> lk(m_taskMut);
-		m_pendingTasks.Push(task);
-		std::push_heap(m_pendingTasks.Data(), m_pendingTasks.Data() + m_pendingTasks.GetCount(), b2TaskLessThan);
+		unique_lock<mutex> lk(m_sleepMut);
 	}
 
-	m_taskAddedCond.notify_one();
+	if (count == 1)
+	{
+		m_taskAddedCond.notify_one();
+	}
+	else
+	{
+		m_taskAddedCond.notify_all();
+	}
 }
 
-void b2ThreadPool::Wait(const b2TaskGroup& taskGroup, b2StackAllocator& allocator)
+b2Task* b2ThreadPool::TryGetTask(int32 threadId)
 {
-	while (taskGroup.m_remainingTasks.load(std::memory_order_acquire) != 0)
-	{
-		b2Task* task = NULL;
+	b2Task* task = m_deques[threadId].Pop();
 
-		// Try to execute a task
+	if (task == NULL && m_pendingCount.load(std::memory_order_acquire) > 0)
+	{
+		int32 dequeCount = m_threadCount + 1;
+		bool retry = true;
+		while (task == NULL && retry)
 		{
-			std::lock(m_taskMut, m_taskGroupMut);
-			std::lock_guard<std::mutex> lk1(m_taskMut, std::adopt_lock);
-			std::lock_guard<std::mutex> lk2(m_taskGroupMut, std::adopt_lock);
-
-			// Make sure our group didn't finish between the last check and acquiring the locks.
-			if (taskGroup.m_remainingTasks.load(std::memory_order_acquire) == 0)
+			retry = false;
+			for (int32 i = 1; i < dequeCount && task == NULL; ++i)
 			{
-				return;
-			}
-
-			// Consume a task.
-			if (m_pendingTasks.GetCount() > 0)
-			{
-				std::pop_heap(m_pendingTasks.Data(), m_pendingTasks.Data() + m_pendingTasks.GetCount(), b2TaskLessThan);
-				task = m_pendingTasks.Pop();
+				task = m_deques[(threadId + i) % dequeCount].Steal(retry);
 			}
 		}
+	}
 
-		if (task == NULL)
-		{
-			// No more tasks to execute.
-			unique_lock<mutex> lk(m_taskGroupMut);
-			m_taskGroupFinishedCond.wait(lk, [&taskGroup]() -> bool
-			{
-				return taskGroup.m_remainingTasks.load(std::memory_order_acquire) == 0;
-			});
+	if (task)
+	{
+		m_pendingCount.fetch_sub(1, std::memory_order_relaxed);
+	}
 
-			return;
+	return task;
+}
+
+bool b2ThreadPool::Spin() const
+{
+	for (int32 i = 0; i < m_spinCount; ++i)
+	{
+		if (m_pendingCount.load(std::memory_order_relaxed) > 0 ||
+			m_signalShutdown.load(std::memory_order_relaxed))
+		{
+			return true;
 		}
+		b2Pause();
+	}
+	return false;
+}
 
-		// Execute the task.
-		task->Execute(allocator);
+void b2ThreadPool::Wait(const b2TaskGroup& taskGroup, b2StackAllocator& allocator)
+{
+	int32 threadId = b2GetThreadId();
 
-		// Reduce the count of tasks remaining in the group.
-		int32 groupRemainingTasks = task->GetTaskGroup()->m_remainingTasks.fetch_sub(1, std::memory_order_release);
+	while (!IsFinished(taskGroup))
+	{
+		// Try to execute a task.
+		b2Task* task = TryGetTask(threadId);
 
-		// If this was the last task in the group.
-		if (groupRemainingTasks == 1)
+		if (task)
 		{
-			// Sync with the waiting thread to ensure it reads '0' from the group's remaining tasks count.
-			// This shouldn't be necessary with the current usage since only this one thread is waiting,
-			// but just in case that changes...
+			if (ExecuteTask(task, allocator))
 			{
-				unique_lock<mutex> lk(m_taskGroupMut);
+				NotifyGroupFinished();
 			}
+			continue;
+		}
 
-			// Let waiting threads know that a group is finished.
-			m_taskGroupFinishedCond.notify_all();
+		// No more tasks to execute; the rest are executing on other threads.
+		for (int32 i = 0; i < m_spinCount; ++i)
+		{
+			if (IsFinished(taskGroup))
+			{
+				return;
+			}
+			b2Pause();
 		}
+
+		unique_lock<mutex> lk(m_taskGroupMut);
+		m_taskGroupFinishedCond.wait(lk, [&taskGroup]() -> bool
+		{
+			return IsFinished(taskGroup);
+		});
+
+		return;
 	}
 }
 
+void b2ThreadPool::NotifyGroupFinished()
+{
+	// Sync with the waiting thread to ensure it reads '0' from the group's remaining tasks count.
+	{
+		unique_lock<mutex> lk(m_taskGroupMut);
+	}
+
+	m_taskGroupFinishedCond.notify_all();
+}
+
 void b2ThreadPool::WorkerMain(int32 threadId)
 {
 	b2SetThreadId(threadId);
@@ -171,55 +395,41 @@ void b2ThreadPool::WorkerMain(int32 threadId)
 
 	for (;;)
 	{
-		b2Task* task = NULL;
+		b2Task* task = TryGetTask(threadId);
+
+		if (task)
+		{
+			// Execute the task, and if it was the last task in its group, let waiting threads know.
+			if (ExecuteTask(task, allocator))
+			{
+				NotifyGroupFinished();
+			}
+			continue;
+		}
 
+		// Briefly look for new tasks before going to sleep.
+		if (Spin() == false)
 		{
-			unique_lock<mutex> lk(m_taskMut);
+			unique_lock<mutex> lk(m_sleepMut);
+			m_sleepingCount.fetch_add(1, std::memory_order_seq_cst);
 
 			// Wait for tasks to be added, or for the pool to shutdown.
-			m_taskAddedCond.wait(lk, [this, threadId]() -> bool
+			m_taskAddedCond.wait(lk, [this]() -> bool
 			{
-				if (this->m_signalShutdown)
-				{
-					return true;
-				}
-				if (m_pendingTasks.GetCount() > 0)
-				{
-					return true;
-				}
-				return false;
+				return m_pendingCount.load(std::memory_order_seq_cst) > 0 ||
+					m_signalShutdown.load(std::memory_order_relaxed);
 			});
 
-			// Is the pool shutting down?
-			if (m_signalShutdown)
-			{
-				// Shutting down in the middle of processing tasks is not supported.
-				b2Assert(m_pendingTasks.GetCount() == 0);
-
-				return;
-			}
-
-			// Consume a task.
-			std::pop_heap(m_pendingTasks.Data(), m_pendingTasks.Data() + m_pendingTasks.GetCount(), b2TaskLessThan);
-			task = m_pendingTasks.Pop();
+			m_sleepingCount.fetch_sub(1, std::memory_order_relaxed);
 		}
 
-		// Execute the task.
-		task->Execute(allocator);
-
-		// Reduce the count of tasks remaining in the group.
-		int32 groupRemainingTasks = task->GetTaskGroup()->m_remainingTasks.fetch_sub(1, std::memory_order_acq_rel);
-
-		// If this was the last task in the group.
-		if (groupRemainingTasks == 1)
+		// Is the pool shutting down?
+		if (m_signalShutdown.load(std::memory_order_acquire))
 		{
-			// Sync with the waiting thread to ensure it reads '0' from the group's remaining tasks count.
-			{
-				unique_lock<mutex> lk(m_taskGroupMut);
-			}
+			// Shutting down in the middle of processing tasks is not supported.
+			b2Assert(m_pendingCount.load(std::memory_order_relaxed) == 0);
 
-			// Let waiting threads know that a group is finished.
-			m_taskGroupFinishedCond.notify_all();
+			return;
 		}
 	}
 }
@@ -228,8 +438,8 @@ void b2ThreadPool::Destroy()
 {
 	// Wake up the threads.
 	{
-		unique_lock<mutex> lk(m_taskMut);
-		m_signalShutdown = true;
+		unique_lock<mutex> lk(m_sleepMut);
+		m_signalShutdown.store(true, std::memory_order_release);
 	}
 	m_taskAddedCond.notify_all();
 
@@ -28,7 +28,7 @@
 
 class b2TaskGroup;
 class b2StackAllocator;
-class b2ThreadPool;
+class b2TaskExecutor;
 
 /// The base class for all tasks that are run by the thread pool.
 class b2Task
@@ -83,11 +83,11 @@ class b2TaskGroup
 {
 public:
 	/// Construct a task group.
-	b2TaskGroup(b2ThreadPool& threadPool);
+	b2TaskGroup(b2TaskExecutor& executor);
 
 	~b2TaskGroup();
 
-	/// Submit tasks for execution.
+	/// Submit tasks for execution. The executor may reorder the array.
 	void SubmitTasks(b2Task** tasks, int32 count);
 
 	/// Submit a single task for execution.
@@ -102,52 +102,162 @@ public:
 	void Wait(b2StackAllocator& allocator);
 
 private:
-	friend class b2ThreadPool;
+	friend class b2TaskExecutor;
 
 	std::atomic<uint32> m_remainingTasks;
-	b2ThreadPool* m_threadPool;
+	b2TaskExecutor* m_executor;
+};
+
+/// The interface task groups use to execute their tasks. Implement it to run
+/// tasks on an existing scheduler instead of a dedicated b2ThreadPool.
+/// While a task executes, b2GetThreadId must return an id in [1, GetThreadCount()]
+/// that no other concurrently executing task is using; id 0 belongs to the
+/// thread that steps the world.
+class b2TaskExecutor
+{
+public:
+	virtual ~b2TaskExecutor() {}
+
+	/// Get the number of threads, not counting the user thread, that execute tasks.
+	/// Must not exceed b2_maxThreadPoolThreads.
+	virtual int32 GetThreadCount() const = 0;
+
+protected:
+	friend class b2TaskGroup;
+
+	/// Add multiple tasks to be executed. The array may be reordered.
+	virtual void AddTasks(b2Task** tasks, int32 count) = 0;
+
+	/// Add a single task to be executed.
+	virtual void AddTask(b2Task* task)
+	{
+		AddTasks(&task, 1);
+	}
+
+	/// Wait for all tasks in the group to finish. The
+	/// allocator can be used to execute tasks while waiting.
+	virtual void Wait(const b2TaskGroup& taskGroup, b2StackAllocator& allocator) = 0;
+
+	/// Execute a task and mark it finished in its group.
+	/// Returns true if it was the last unfinished task in the group.
+	static bool ExecuteTask(b2Task* task, b2StackAllocator& allocator);
+
+	/// Have all tasks submitted to the group finished?
+	static bool IsFinished(const b2TaskGroup& taskGroup);
+};
+
+/// A Chase-Lev work-stealing deque of tasks, meant for internal use only.
+/// The owning thread pushes and pops at the bottom; other threads steal from the top.
+class b2TaskDeque
+{
+public:
+	b2TaskDeque();
+
+	~b2TaskDeque();
+
+	/// Push a task onto the bottom. Only the owner may push.
+	void Push(b2Task* task);
+
+	/// Pop the most recently pushed task. Only the owner may pop.
+	/// Returns NULL if the deque is empty.
+	b2Task* Pop();
+
+	/// Steal the least recently pushed task. Returns NULL if the deque is empty
+	/// or if another thread took the task first, in which case retry is set.
+	b2Task* Steal(bool& retry);
+
+private:
+	typedef long long Index;
+
+	// A ring buffer of tasks. Buffers that were grown out of are kept
+	// until the deque is destroyed since thieves may still be reading them.
+	struct Buffer
+	{
+		Index capacity;
+		std::atomic<b2Task*>* tasks;
+		Buffer* previous;
+
+		b2Task* Get(Index i) const;
+		void Put(Index i, b2Task* task);
+	};
+
+	Buffer* Grow(Buffer* buffer, Index top, Index bottom);
+
+	// Keep the thieves' index and the owner's index on separate cache lines.
+	std::atomic<Index> m_top;
+	char m_padding[b2_cacheLineSize];
+	std::atomic<Index> m_bottom;
+	std::atomic<Buffer*> m_buffer;
 };
 
 /// The thread pool executes tasks submitted by task groups.
-class b2ThreadPool
+/// Each thread has its own work-stealing deque; idle threads steal tasks from
+/// the others. Each deque is kept sorted by cost, across submissions, so the highest
+/// cost tasks are stolen first; the owning thread pops the cheapest ones itself.
+/// Any of the pool's threads may submit tasks, including tasks which submit
+/// tasks of their own (e.g. the colored contact solve). A submitter only pushes
+/// to its own deque, m_deques[b2GetThreadId()], which only it pops from and others
+/// only steal from, so submissions need no lock. Threads outside the pool all have
+/// thread id 0 and share the first deque, so only one of them may submit at a time.
+class b2ThreadPool : public b2TaskExecutor
 {
 public:
 	/// Construct a thread pool.
 	/// @param threadCount the number of threads to use. If -1, defaults to the number of logical cores - 1.
-	b2ThreadPool(int32 threadCount = -1);
+	/// @param spinCount how many times an idle thread checks for new tasks before it goes to sleep.
+	/// Spinning reduces the latency of the next task group at the cost of busy CPU time.
+	b2ThreadPool(int32 threadCount = -1, int32 spinCount = 0);
 
 	~b2ThreadPool();
 
 	/// Get the number of threads in the pool.
 	int32 GetThreadCount() const;
 
-private:
-	friend class b2TaskGroup;
-
-	// Add multiple tasks to be executed.
+protected:
+	// Add multiple tasks to be executed. The array is sorted by cost.
 	void AddTasks(b2Task** tasks, int32 count);
 
-	// Add a single task to be executed.
-	void AddTask(b2Task* task);
-
 	// Wait for all tasks in the group to finish. The
 	// allocator is used to execute tasks while waiting.
 	void Wait(const b2TaskGroup& taskGroup, b2StackAllocator& allocator);
 
+private:
+	// Let waiting threads know that a group is finished.
+	void NotifyGroupFinished();
+
+	// Let sleeping workers know that tasks were added.
+	void NotifyTasksAdded(int32 count);
+
+	// Pop a task from the thread's own deque, or steal one from another thread.
+	b2Task* TryGetTask(int32 threadId);
+
+	// Spin for a while waiting for tasks. Returns true if tasks are pending.
+	bool Spin() const;
+
 	void WorkerMain(int32 threadId);
 
 	void Destroy();
 
-	std::mutex m_taskMut;
+	b2TaskDeque m_deques[b2_maxThreads];
+
+	// Queued tasks taken back by AddTasks to make room for more expensive ones.
+	b2GrowableArray<b2Task*> m_requeued[b2_maxThreads];
+
+	// The number of tasks sitting in the deques.
+	std::atomic<int32> m_pendingCount;
+
+	std::mutex m_sleepMut;
 	std::condition_variable m_taskAddedCond;
+	std::atomic<int32> m_sleepingCount;
+
 	std::mutex m_taskGroupMut;
 	std::condition_variable m_taskGroupFinishedCond;
-	b2GrowableArray<b2Task*> m_pendingTasks;
 
 	std::thread* m_threads;
 	int32 m_threadCount;
+	int32 m_spinCount;
 
-	bool m_signalShutdown;
+	std::atomic<bool> m_signalShutdown;
 };
 
 inline b2Task::b2Task()
@@ -222,10 +332,10 @@ void b2TaskGroup::SubmitRangedTasks(RangedTaskType* tasks, int32 taskCount, int3
 	allocator.Free(taskPtrs);
 }
 
-inline b2TaskGroup::b2TaskGroup(b2ThreadPool& threadPool)
+inline b2TaskGroup::b2TaskGroup(b2TaskExecutor& executor)
 {
 	m_remainingTasks.store(0, std::memory_order_relaxed);
-	m_threadPool = &threadPool;
+	m_executor = &executor;
 }
 
 inline b2TaskGroup::~b2TaskGroup()
@@ -243,7 +353,7 @@ inline void b2TaskGroup::SubmitTasks(b2Task** tasks, int32 count)
 		tasks[i]->m_taskGroup = this;
 	}
 
-	m_threadPool->AddTasks(tasks, count);
+	m_executor->AddTasks(tasks, count);
 }
 
 inline void b2TaskGroup::SubmitTask(b2Task* task)
@@ -252,12 +362,27 @@ inline void b2TaskGroup::SubmitTask(b2Task* task)
 
 	task->m_taskGroup = this;
 
-	m_threadPool->AddTask(task);
+	m_executor->AddTask(task);
 }
 
 inline void b2TaskGroup::Wait(b2StackAllocator& allocator)
 {
-	m_threadPool->Wait(*this, allocator);
+	m_executor->Wait(*this, allocator);
+}
+
+inline bool b2TaskExecutor::ExecuteTask(b2Task* task, b2StackAllocator& allocator)
+{
+	task->Execute(allocator);
+
+	// Reduce the count of tasks remaining in the group.
+	uint32 groupRemainingTasks = task->GetTaskGroup()->m_remainingTasks.fetch_sub(1, std::memory_order_acq_rel);
+
+	return groupRemainingTasks == 1;
+}
+
+inline bool b2TaskExecutor::IsFinished(const b2TaskGroup& taskGroup)
+{
+	return taskGroup.m_remainingTasks.load(std::memory_order_acquire) == 0;
 }
 
 #endif
@@ -23,11 +23,41 @@
 #include <Box2D/Dynamics/b2Fixture.h>
 #include <Box2D/Dynamics/b2World.h>
 #include <Box2D/Common/b2StackAllocator.h>
+#include <Box2D/Common/b2Simd.h>
 
 #define B2_DEBUG_SOLVER 0
 
 bool g_blockSolve = true;
 
+struct b2WideVelocityConstraintPoint
+{
+	float32 rAx[b2_wideLanes], rAy[b2_wideLanes];
+	float32 rBx[b2_wideLanes], rBy[b2_wideLanes];
+	float32 normalImpulse[b2_wideLanes];
+	float32 tangentImpulse[b2_wideLanes];
+	float32 normalMass[b2_wideLanes];
+	float32 tangentMass[b2_wideLanes];
+	float32 velocityBias[b2_wideLanes];
+};
+
+/// The velocity constraints of up to four contacts, stored lane by lane.
+/// Unused lanes are zero and have a constraint index of -1.
+struct b2WideVelocityConstraint
+{
+	b2WideVelocityConstraintPoint points[b2_maxManifoldPoints];
+	float32 normalX[b2_wideLanes], normalY[b2_wideLanes];
+	float32 normalMass[4][b2_wideLanes]; // ex.x, ex.y, ey.x, ey.y
+	float32 K[4][b2_wideLanes]; // ex.x, ex.y, ey.x, ey.y
+	float32 invMassA[b2_wideLanes], invMassB[b2_wideLanes];
+	float32 invIA[b2_wideLanes], invIB[b2_wideLanes];
+	float32 friction[b2_wideLanes];
+	float32 tangentSpeed[b2_wideLanes];
+	int32 indexA[b2_wideLanes];
+	int32 indexB[b2_wideLanes];
+	int32 constraintIndex[b2_wideLanes];
+	int32 pointCount;
+};
+
 struct b2ContactPositionConstraint
 {
 	b2Vec2 localPoints[b2_maxManifoldPoints];
@@ -53,6 +83,12 @@ b2ContactSolver::b2ContactSolver(b2ContactSolverDef* def)
 	m_positions = def->positions;
 	m_velocities = def->velocities;
 	m_contacts = def->contacts;
+	m_colorOffsets = NULL;
+	m_colorCount = 0;
+	m_sequentialColor = -1;
+	m_wideConstraints = NULL;
+	m_colorBatchOffsets = NULL;
+	m_wideCount = 0;
 
 	// Initialize position independent portions of the constraints.
 	for (int32 i = 0; i < m_count; ++i)
@@ -132,10 +168,118 @@ b2ContactSolver::b2ContactSolver(b2ContactSolverDef* def)
 
 b2ContactSolver::~b2ContactSolver()
 {
+	if (m_colorBatchOffsets)
+	{
+		m_allocator->Free(m_wideConstraints);
+		m_allocator->Free(m_colorBatchOffsets);
+	}
+	if (m_colorOffsets)
+	{
+		m_allocator->Free(m_colorOffsets);
+	}
 	m_allocator->Free(m_velocityConstraints);
 	m_allocator->Free(m_positionConstraints);
 }
 
+// Greedily assign each constraint the lowest color that none of the other
+// constraints on its bodies have, then group the constraints by color.
+// Bodies that can't move don't count, so a stack resting on the ground
+// needs only a few colors. The greedy pass walks the constraints in order,
+// so the coloring is deterministic.
+void b2ContactSolver::Color()
+{
+	b2Assert(m_colorOffsets == NULL);
+
+	// One extra color for the constraints that didn't fit into the others.
+	m_colorOffsets = (int32*)m_allocator->Allocate((b2_maxConstraintColors + 2) * sizeof(int32));
+
+	int32 bodyCount = 0;
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		bodyCount = b2Max(bodyCount, b2Max(m_velocityConstraints[i].indexA, m_velocityConstraints[i].indexB) + 1);
+	}
+
+	uint32* bodyColors = (uint32*)m_allocator->Allocate(bodyCount * sizeof(uint32));
+	int32* colors = (int32*)m_allocator->Allocate(m_count * sizeof(int32));
+	memset(bodyColors, 0, bodyCount * sizeof(uint32));
+	memset(m_colorOffsets, 0, (b2_maxConstraintColors + 2) * sizeof(int32));
+
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		const b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
+		bool movableA = vc->invMassA != 0.0f || vc->invIA != 0.0f;
+		bool movableB = vc->invMassB != 0.0f || vc->invIB != 0.0f;
+
+		uint32 used = (movableA ? bodyColors[vc->indexA] : 0) | (movableB ? bodyColors[vc->indexB] : 0);
+
+		int32 color = 0;
+		while (color < b2_maxConstraintColors && (used & (1u << color)))
+		{
+			++color;
+		}
+
+		if (color < b2_maxConstraintColors)
+		{
+			if (movableA)
+			{
+				bodyColors[vc->indexA] |= 1u << color;
+			}
+			if (movableB)
+			{
+				bodyColors[vc->indexB] |= 1u << color;
+			}
+		}
+
+		colors[i] = color;
+		++m_colorOffsets[color + 1];
+	}
+
+	// Turn the counts into offsets and drop the empty colors.
+	m_colorCount = 0;
+	m_sequentialColor = -1;
+	int32 colorStart[b2_maxConstraintColors + 1];
+	int32 offset = 0;
+	for (int32 color = 0; color <= b2_maxConstraintColors; ++color)
+	{
+		int32 count = m_colorOffsets[color + 1];
+		colorStart[color] = offset;
+		if (count > 0)
+		{
+			if (color == b2_maxConstraintColors)
+			{
+				m_sequentialColor = m_colorCount;
+			}
+			m_colorOffsets[m_colorCount++] = offset;
+		}
+		offset += count;
+	}
+	m_colorOffsets[m_colorCount] = offset;
+
+	// Reorder the constraints and the contacts by color.
+	b2ContactVelocityConstraint* velocityConstraints = (b2ContactVelocityConstraint*)m_allocator->Allocate(m_count * sizeof(b2ContactVelocityConstraint));
+	b2ContactPositionConstraint* positionConstraints = (b2ContactPositionConstraint*)m_allocator->Allocate(m_count * sizeof(b2ContactPositionConstraint));
+	b2Contact** contacts = (b2Contact**)m_allocator->Allocate(m_count * sizeof(b2Contact*));
+
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		int32 index = colorStart[colors[i]]++;
+		velocityConstraints[index] = m_velocityConstraints[i];
+		velocityConstraints[index].contactIndex = index;
+		positionConstraints[index] = m_positionConstraints[i];
+		contacts[index] = m_contacts[m_velocityConstraints[i].contactIndex];
+	}
+
+	memcpy(m_velocityConstraints, velocityConstraints, m_count * sizeof(b2ContactVelocityConstraint));
+	memcpy(m_positionConstraints, positionConstraints, m_count * sizeof(b2ContactPositionConstraint));
+	memcpy(m_contacts, contacts, m_count * sizeof(b2Contact*));
+
+	m_allocator->Free(contacts);
+	m_allocator->Free(positionConstraints);
+	m_allocator->Free(velocityConstraints);
+	m_allocator->Free(colors);
+	m_allocator->Free(bodyColors);
+}
+
 // Initialize position dependent portions of the velocity constraints.
 void b2ContactSolver::InitializeVelocityConstraints()
 {
@@ -249,9 +393,14 @@ void b2ContactSolver::InitializeVelocityConstraints()
 }
 
 void b2ContactSolver::WarmStart()
+{
+	WarmStart(0, m_count);
+}
+
+void b2ContactSolver::WarmStart(int32 begin, int32 end)
 {
 	// Warm start.
-	for (int32 i = 0; i < m_count; ++i)
+	for (int32 i = begin; i < end; ++i)
 	{
 		b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
 
@@ -281,16 +430,29 @@ void b2ContactSolver::WarmStart()
 			vB += mB * P;
 		}
 
-		m_velocities[indexA].v = vA;
-		m_velocities[indexA].w = wA;
-		m_velocities[indexB].v = vB;
-		m_velocities[indexB].w = wB;
+		// Bodies that can't move may be shared by constraints of the same
+		// color, so only write back the bodies the constraint can change.
+		if (mA != 0.0f || iA != 0.0f)
+		{
+			m_velocities[indexA].v = vA;
+			m_velocities[indexA].w = wA;
+		}
+		if (mB != 0.0f || iB != 0.0f)
+		{
+			m_velocities[indexB].v = vB;
+			m_velocities[indexB].w = wB;
+		}
 	}
 }
 
 void b2ContactSolver::SolveVelocityConstraints()
 {
-	for (int32 i = 0; i < m_count; ++i)
+	SolveVelocityConstraints(0, m_count);
+}
+
+void b2ContactSolver::SolveVelocityConstraints(int32 begin, int32 end)
+{
+	for (int32 i = begin; i < end; ++i)
 	{
 		b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
 
@@ -594,10 +756,371 @@ void b2ContactSolver::SolveVelocityConstraints()
 			}
 		}
 
-		m_velocities[indexA].v = vA;
-		m_velocities[indexA].w = wA;
-		m_velocities[indexB].v = vB;
-		m_velocities[indexB].w = wB;
+		// Bodies that can't move may be shared by constraints of the same
+		// color, so only write back the bodies the constraint can change.
+		if (mA != 0.0f || iA != 0.0f)
+		{
+			m_velocities[indexA].v = vA;
+			m_velocities[indexA].w = wA;
+		}
+		if (mB != 0.0f || iB != 0.0f)
+		{
+			m_velocities[indexB].v = vB;
+			m_velocities[indexB].w = wB;
+		}
+	}
+}
+
+void b2ContactSolver::InitializeWideConstraints()
+{
+	b2Assert(m_colorOffsets != NULL && m_colorBatchOffsets == NULL);
+
+	// Constraints with one and two points are solved differently, so they
+	// get batches of their own.
+	m_colorBatchOffsets = (int32*)m_allocator->Allocate((m_colorCount + 1) * sizeof(int32));
+	m_wideCount = 0;
+	for (int32 color = 0; color < m_colorCount; ++color)
+	{
+		m_colorBatchOffsets[color] = m_wideCount;
+		if (color == m_sequentialColor)
+		{
+			continue;
+		}
+
+		int32 counts[b2_maxManifoldPoints + 1] = { 0 };
+		for (int32 i = m_colorOffsets[color]; i < m_colorOffsets[color + 1]; ++i)
+		{
+			++counts[m_velocityConstraints[i].pointCount];
+		}
+
+		for (int32 pointCount = 1; pointCount <= b2_maxManifoldPoints; ++pointCount)
+		{
+			m_wideCount += (counts[pointCount] + b2_wideLanes - 1) / b2_wideLanes;
+		}
+	}
+	m_colorBatchOffsets[m_colorCount] = m_wideCount;
+
+	m_wideConstraints = (b2WideVelocityConstraint*)m_allocator->Allocate(m_wideCount * sizeof(b2WideVelocityConstraint));
+	memset(m_wideConstraints, 0, m_wideCount * sizeof(b2WideVelocityConstraint));
+
+	for (int32 color = 0; color < m_colorCount; ++color)
+	{
+		if (color == m_sequentialColor)
+		{
+			continue;
+		}
+
+		b2WideVelocityConstraint* wc = m_wideConstraints + m_colorBatchOffsets[color];
+		for (int32 pointCount = 1; pointCount <= b2_maxManifoldPoints; ++pointCount)
+		{
+			int32 lane = 0;
+			for (int32 i = m_colorOffsets[color]; i < m_colorOffsets[color + 1]; ++i)
+			{
+				const b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
+				if (vc->pointCount != pointCount)
+				{
+					continue;
+				}
+
+				if (lane == 0)
+				{
+					for (int32 k = 0; k < b2_wideLanes; ++k)
+					{
+						wc->constraintIndex[k] = -1;
+					}
+					wc->pointCount = pointCount;
+				}
+
+				wc->constraintIndex[lane] = i;
+				wc->indexA[lane] = vc->indexA;
+				wc->indexB[lane] = vc->indexB;
+				wc->invMassA[lane] = vc->invMassA;
+				wc->invMassB[lane] = vc->invMassB;
+				wc->invIA[lane] = vc->invIA;
+				wc->invIB[lane] = vc->invIB;
+				wc->friction[lane] = vc->friction;
+				wc->tangentSpeed[lane] = vc->tangentSpeed;
+				wc->normalX[lane] = vc->normal.x;
+				wc->normalY[lane] = vc->normal.y;
+				wc->normalMass[0][lane] = vc->normalMass.ex.x;
+				wc->normalMass[1][lane] = vc->normalMass.ex.y;
+				wc->normalMass[2][lane] = vc->normalMass.ey.x;
+				wc->normalMass[3][lane] = vc->normalMass.ey.y;
+				wc->K[0][lane] = vc->K.ex.x;
+				wc->K[1][lane] = vc->K.ex.y;
+				wc->K[2][lane] = vc->K.ey.x;
+				wc->K[3][lane] = vc->K.ey.y;
+
+				for (int32 j = 0; j < pointCount; ++j)
+				{
+					const b2VelocityConstraintPoint* vcp = vc->points + j;
+					b2WideVelocityConstraintPoint* wcp = wc->points + j;
+					wcp->rAx[lane] = vcp->rA.x;
+					wcp->rAy[lane] = vcp->rA.y;
+					wcp->rBx[lane] = vcp->rB.x;
+					wcp->rBy[lane] = vcp->rB.y;
+					wcp->normalImpulse[lane] = vcp->normalImpulse;
+					wcp->tangentImpulse[lane] = vcp->tangentImpulse;
+					wcp->normalMass[lane] = vcp->normalMass;
+					wcp->tangentMass[lane] = vcp->tangentMass;
+					wcp->velocityBias[lane] = vcp->velocityBias;
+				}
+
+				if (++lane == b2_wideLanes)
+				{
+					++wc;
+					lane = 0;
+				}
+			}
+
+			if (lane != 0)
+			{
+				++wc;
+			}
+		}
+
+		b2Assert(wc == m_wideConstraints + m_colorBatchOffsets[color + 1]);
+	}
+}
+
+// The wide solver does the same floating point operations, in the same
+// order, as SolveVelocityConstraints. Constraints of one color share no
+// body that can move, so the results match the colored scalar solver.
+void b2ContactSolver::SolveWideVelocityConstraints(int32 begin, int32 end)
+{
+	for (int32 i = begin; i < end; ++i)
+	{
+		b2WideVelocityConstraint* wc = m_wideConstraints + i;
+
+		// Gather the velocities of the bodies: vA.x, vA.y, wA, vB.x, vB.y, wB.
+		float32 velocities[6][b2_wideLanes];
+		for (int32 lane = 0; lane < b2_wideLanes; ++lane)
+		{
+			b2Velocity velocityA = { b2Vec2_zero, 0.0f };
+			b2Velocity velocityB = { b2Vec2_zero, 0.0f };
+			if (wc->constraintIndex[lane] >= 0)
+			{
+				velocityA = m_velocities[wc->indexA[lane]];
+				velocityB = m_velocities[wc->indexB[lane]];
+			}
+			velocities[0][lane] = velocityA.v.x;
+			velocities[1][lane] = velocityA.v.y;
+			velocities[2][lane] = velocityA.w;
+			velocities[3][lane] = velocityB.v.x;
+			velocities[4][lane] = velocityB.v.y;
+			velocities[5][lane] = velocityB.w;
+		}
+
+		b2Float4 vAx = b2Load4(velocities[0]), vAy = b2Load4(velocities[1]), wA = b2Load4(velocities[2]);
+		b2Float4 vBx = b2Load4(velocities[3]), vBy = b2Load4(velocities[4]), wB = b2Load4(velocities[5]);
+
+		b2Float4 mA = b2Load4(wc->invMassA);
+		b2Float4 iA = b2Load4(wc->invIA);
+		b2Float4 mB = b2Load4(wc->invMassB);
+		b2Float4 iB = b2Load4(wc->invIB);
+
+		b2Float4 normalX = b2Load4(wc->normalX);
+		b2Float4 normalY = b2Load4(wc->normalY);
+		b2Float4 tangentX = normalY;
+		b2Float4 tangentY = -normalX;
+		b2Float4 friction = b2Load4(wc->friction);
+		b2Float4 tangentSpeed = b2Load4(wc->tangentSpeed);
+		b2Float4 zero = b2Splat4(0.0f);
+
+		int32 pointCount = wc->pointCount;
+
+		// Solve tangent constraints first because non-penetration is more important
+		// than friction.
+		for (int32 j = 0; j < pointCount; ++j)
+		{
+			b2WideVelocityConstraintPoint* wcp = wc->points + j;
+			b2Float4 rAx = b2Load4(wcp->rAx), rAy = b2Load4(wcp->rAy);
+			b2Float4 rBx = b2Load4(wcp->rBx), rBy = b2Load4(wcp->rBy);
+
+			// Relative velocity at contact
+			b2Float4 dvx = vBx - wB * rBy - vAx + wA * rAy;
+			b2Float4 dvy = vBy + wB * rBx - vAy - wA * rAx;
+
+			// Compute tangent force
+			b2Float4 vt = dvx * tangentX + dvy * tangentY - tangentSpeed;
+			b2Float4 lambda = b2Load4(wcp->tangentMass) * -vt;
+
+			// b2Clamp the accumulated force
+			b2Float4 tangentImpulse = b2Load4(wcp->tangentImpulse);
+			b2Float4 maxFriction = friction * b2Load4(wcp->normalImpulse);
+			b2Float4 newImpulse = b2Max(-maxFriction, b2Min(tangentImpulse + lambda, maxFriction));
+			lambda = newImpulse - tangentImpulse;
+			b2Store4(wcp->tangentImpulse, newImpulse);
+
+			// Apply contact impulse
+			b2Float4 Px = lambda * tangentX;
+			b2Float4 Py = lambda * tangentY;
+
+			vAx = vAx - mA * Px;
+			vAy = vAy - mA * Py;
+			wA = wA - iA * (rAx * Py - rAy * Px);
+
+			vBx = vBx + mB * Px;
+			vBy = vBy + mB * Py;
+			wB = wB + iB * (rBx * Py - rBy * Px);
+		}
+
+		// Solve normal constraints
+		if (pointCount == 1 || g_blockSolve == false)
+		{
+			for (int32 j = 0; j < pointCount; ++j)
+			{
+				b2WideVelocityConstraintPoint* wcp = wc->points + j;
+				b2Float4 rAx = b2Load4(wcp->rAx), rAy = b2Load4(wcp->rAy);
+				b2Float4 rBx = b2Load4(wcp->rBx), rBy = b2Load4(wcp->rBy);
+
+				// Relative velocity at contact
+				b2Float4 dvx = vBx - wB * rBy - vAx + wA * rAy;
+				b2Float4 dvy = vBy + wB * rBx - vAy - wA * rAx;
+
+				// Compute normal impulse
+				b2Float4 vn = dvx * normalX + dvy * normalY;
+				b2Float4 lambda = -b2Load4(wcp->normalMass) * (vn - b2Load4(wcp->velocityBias));
+
+				// b2Clamp the accumulated impulse
+				b2Float4 normalImpulse = b2Load4(wcp->normalImpulse);
+				b2Float4 newImpulse = b2Max(normalImpulse + lambda, zero);
+				lambda = newImpulse - normalImpulse;
+				b2Store4(wcp->normalImpulse, newImpulse);
+
+				// Apply contact impulse
+				b2Float4 Px = lambda * normalX;
+				b2Float4 Py = lambda * normalY;
+
+				vAx = vAx - mA * Px;
+				vAy = vAy - mA * Py;
+				wA = wA - iA * (rAx * Py - rAy * Px);
+
+				vBx = vBx + mB * Px;
+				vBy = vBy + mB * Py;
+				wB = wB + iB * (rBx * Py - rBy * Px);
+			}
+		}
+		else
+		{
+			// Block solver, see SolveVelocityConstraints. Every case is evaluated
+			// and the first valid solution is selected per lane.
+			b2WideVelocityConstraintPoint* cp1 = wc->points + 0;
+			b2WideVelocityConstraintPoint* cp2 = wc->points + 1;
+			b2Float4 rA1x = b2Load4(cp1->rAx), rA1y = b2Load4(cp1->rAy);
+			b2Float4 rB1x = b2Load4(cp1->rBx), rB1y = b2Load4(cp1->rBy);
+			b2Float4 rA2x = b2Load4(cp2->rAx), rA2y = b2Load4(cp2->rAy);
+			b2Float4 rB2x = b2Load4(cp2->rBx), rB2y = b2Load4(cp2->rBy);
+
+			b2Float4 ax = b2Load4(cp1->normalImpulse);
+			b2Float4 ay = b2Load4(cp2->normalImpulse);
+
+			// Relative velocity at contact
+			b2Float4 dv1x = vBx - wB * rB1y - vAx + wA * rA1y;
+			b2Float4 dv1y = vBy + wB * rB1x - vAy - wA * rA1x;
+			b2Float4 dv2x = vBx - wB * rB2y - vAx + wA * rA2y;
+			b2Float4 dv2y = vBy + wB * rB2x - vAy - wA * rA2x;
+
+			// Compute normal velocity
+			b2Float4 vn1 = dv1x * normalX + dv1y * normalY;
+			b2Float4 vn2 = dv2x * normalX + dv2y * normalY;
+
+			// Compute b'
+			b2Float4 Kexx = b2Load4(wc->K[0]), Kexy = b2Load4(wc->K[1]);
+			b2Float4 Keyx = b2Load4(wc->K[2]), Keyy = b2Load4(wc->K[3]);
+			b2Float4 bx = vn1 - b2Load4(cp1->velocityBias);
+			b2Float4 by = vn2 - b2Load4(cp2->velocityBias);
+			bx = bx - (Kexx * ax + Keyx * ay);
+			by = by - (Kexy * ax + Keyy * ay);
+
+			// Case 1: vn = 0
+			b2Float4 x1x = -(b2Load4(wc->normalMass[0]) * bx + b2Load4(wc->normalMass[2]) * by);
+			b2Float4 x1y = -(b2Load4(wc->normalMass[1]) * bx + b2Load4(wc->normalMass[3]) * by);
+			b2Float4 case1 = b2And(b2GreaterEqual(x1x, zero), b2GreaterEqual(x1y, zero));
+
+			// Case 2: vn1 = 0 and x2 = 0
+			b2Float4 x2x = -b2Load4(cp1->normalMass) * bx;
+			b2Float4 case2 = b2And(b2GreaterEqual(x2x, zero), b2GreaterEqual(Kexy * x2x + by, zero));
+
+			// Case 3: vn2 = 0 and x1 = 0
+			b2Float4 x3y = -b2Load4(cp2->normalMass) * by;
+			b2Float4 case3 = b2And(b2GreaterEqual(x3y, zero), b2GreaterEqual(Keyx * x3y + bx, zero));
+
+			// Case 4: x1 = 0 and x2 = 0
+			b2Float4 case4 = b2And(b2GreaterEqual(bx, zero), b2GreaterEqual(by, zero));
+
+			// No solution, keep the old impulse.
+			b2Float4 xx = b2Select(case1, x1x, b2Select(case2, x2x, b2Select(case3, zero, b2Select(case4, zero, ax))));
+			b2Float4 xy = b2Select(case1, x1y, b2Select(case2, zero, b2Select(case3, x3y, b2Select(case4, zero, ay))));
+
+			// Get the incremental impulse
+			b2Float4 dx = xx - ax;
+			b2Float4 dy = xy - ay;
+
+			// Apply incremental impulse
+			b2Float4 P1x = dx * normalX, P1y = dx * normalY;
+			b2Float4 P2x = dy * normalX, P2y = dy * normalY;
+
+			vAx = vAx - mA * (P1x + P2x);
+			vAy = vAy - mA * (P1y + P2y);
+			wA = wA - iA * ((rA1x * P1y - rA1y * P1x) + (rA2x * P2y - rA2y * P2x));
+
+			vBx = vBx + mB * (P1x + P2x);
+			vBy = vBy + mB * (P1y + P2y);
+			wB = wB + iB * ((rB1x * P1y - rB1y * P1x) + (rB2x * P2y - rB2y * P2x));
+
+			// Accumulate
+			b2Store4(cp1->normalImpulse, xx);
+			b2Store4(cp2->normalImpulse, xy);
+		}
+
+		// Scatter the velocities of the bodies that can move.
+		b2Store4(velocities[0], vAx);
+		b2Store4(velocities[1], vAy);
+		b2Store4(velocities[2], wA);
+		b2Store4(velocities[3], vBx);
+		b2Store4(velocities[4], vBy);
+		b2Store4(velocities[5], wB);
+		for (int32 lane = 0; lane < b2_wideLanes; ++lane)
+		{
+			if (wc->constraintIndex[lane] < 0)
+			{
+				continue;
+			}
+
+			if (wc->invMassA[lane] != 0.0f || wc->invIA[lane] != 0.0f)
+			{
+				m_velocities[wc->indexA[lane]].v.Set(velocities[0][lane], velocities[1][lane]);
+				m_velocities[wc->indexA[lane]].w = velocities[2][lane];
+			}
+			if (wc->invMassB[lane] != 0.0f || wc->invIB[lane] != 0.0f)
+			{
+				m_velocities[wc->indexB[lane]].v.Set(velocities[3][lane], velocities[4][lane]);
+				m_velocities[wc->indexB[lane]].w = velocities[5][lane];
+			}
+		}
+	}
+}
+
+void b2ContactSolver::StoreWideImpulses()
+{
+	for (int32 i = 0; i < m_wideCount; ++i)
+	{
+		const b2WideVelocityConstraint* wc = m_wideConstraints + i;
+		for (int32 lane = 0; lane < b2_wideLanes; ++lane)
+		{
+			if (wc->constraintIndex[lane] < 0)
+			{
+				continue;
+			}
+
+			b2ContactVelocityConstraint* vc = m_velocityConstraints + wc->constraintIndex[lane];
+			for (int32 j = 0; j < wc->pointCount; ++j)
+			{
+				vc->points[j].normalImpulse = wc->points[j].normalImpulse[lane];
+				vc->points[j].tangentImpulse = wc->points[j].tangentImpulse[lane];
+			}
+		}
 	}
 }
 
@@ -669,10 +1192,19 @@ struct b2PositionSolverManifold
 
 // Sequential solver.
 bool b2ContactSolver::SolvePositionConstraints()
+{
+	float32 minSeparation = SolvePositionConstraints(0, m_count);
+
+	// We can't expect minSpeparation >= -b2_linearSlop because we don't
+	// push the separation above -b2_linearSlop.
+	return minSeparation >= -3.0f * b2_linearSlop;
+}
+
+float32 b2ContactSolver::SolvePositionConstraints(int32 begin, int32 end)
 {
 	float32 minSeparation = 0.0f;
 
-	for (int32 i = 0; i < m_count; ++i)
+	for (int32 i = begin; i < end; ++i)
 	{
 		b2ContactPositionConstraint* pc = m_positionConstraints + i;
 
@@ -734,16 +1266,20 @@ bool b2ContactSolver::SolvePositionConstraints()
 			aB += iB * b2Cross(rB, P);
 		}
 
-		m_positions[indexA].c = cA;
-		m_positions[indexA].a = aA;
+		if (mA != 0.0f || iA != 0.0f)
+		{
+			m_positions[indexA].c = cA;
+			m_positions[indexA].a = aA;
+		}
 
-		m_positions[indexB].c = cB;
-		m_positions[indexB].a = aB;
+		if (mB != 0.0f || iB != 0.0f)
+		{
+			m_positions[indexB].c = cB;
+			m_positions[indexB].a = aB;
+		}
 	}
 
-	// We can't expect minSpeparation >= -b2_linearSlop because we don't
-	// push the separation above -b2_linearSlop.
-	return minSeparation >= -3.0f * b2_linearSlop;
+	return minSeparation;
 }
 
 // Sequential position solver for position constraints.
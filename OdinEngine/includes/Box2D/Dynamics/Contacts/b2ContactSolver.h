@@ -27,6 +27,10 @@ class b2Contact;
 class b2Body;
 class b2StackAllocator;
 struct b2ContactPositionConstraint;
+struct b2WideVelocityConstraint;
+
+/// The number of constraints in a batch of the wide solver.
+#define b2_wideLanes 4
 
 struct b2VelocityConstraintPoint
 {
@@ -72,15 +76,39 @@ public:
 	b2ContactSolver(b2ContactSolverDef* def);
 	~b2ContactSolver();
 
+	/// Reorder the constraints, and the contacts, so that they are grouped by color.
+	/// Constraints of the same color share no body that can move, so each color
+	/// can be split across threads. Colors must still be solved one after another.
+	/// The constraints of m_sequentialColor (if not -1) didn't fit into any
+	/// other color and must be solved by one thread.
+	void Color();
+
 	void InitializeVelocityConstraints();
 
 	void WarmStart();
 	void SolveVelocityConstraints();
 	void StoreImpulses();
 
+	/// Solve the constraints [begin, end).
+	void WarmStart(int32 begin, int32 end);
+	void SolveVelocityConstraints(int32 begin, int32 end);
+
 	bool SolvePositionConstraints();
 	bool SolveTOIPositionConstraints(int32 toiIndexA, int32 toiIndexB);
 
+	/// Solve the position constraints [begin, end). Returns the minimum separation.
+	float32 SolvePositionConstraints(int32 begin, int32 end);
+
+	/// Pack the velocity constraints of every color except m_sequentialColor into
+	/// batches of four constraints with the same point count. Requires Color().
+	void InitializeWideConstraints();
+
+	/// Solve the velocity constraints of the batches [begin, end), four at once.
+	void SolveWideVelocityConstraints(int32 begin, int32 end);
+
+	/// Copy the impulses of the batches back into the velocity constraints.
+	void StoreWideImpulses();
+
 	b2TimeStep m_step;
 	b2Position* m_positions;
 	b2Velocity* m_velocities;
@@ -89,6 +117,16 @@ public:
 	b2ContactVelocityConstraint* m_velocityConstraints;
 	b2Contact** m_contacts;
 	int m_count;
+
+	// Constraints of color i are [m_colorOffsets[i], m_colorOffsets[i + 1]).
+	int32* m_colorOffsets;
+	int32 m_colorCount;
+	int32 m_sequentialColor;
+
+	// Batches of color i are [m_colorBatchOffsets[i], m_colorBatchOffsets[i + 1]).
+	b2WideVelocityConstraint* m_wideConstraints;
+	int32* m_colorBatchOffsets;
+	int32 m_wideCount;
 };
 
 #endif
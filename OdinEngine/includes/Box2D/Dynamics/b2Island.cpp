@@ -26,6 +26,7 @@
 #include <Box2D/Dynamics/Contacts/b2ContactSolver.h>
 #include <Box2D/Dynamics/Joints/b2Joint.h>
 #include <Box2D/Common/b2StackAllocator.h>
+#include <Box2D/Common/b2Threading.h>
 #include <Box2D/Common/b2Timer.h>
 
 /*
@@ -162,6 +163,7 @@ b2Island::b2Island(
 
 	m_allocator = allocator;
 	m_listener = listener;
+	m_executor = NULL;
 
 	m_bodies = (b2Body**)m_allocator->Allocate(bodyCapacity * sizeof(b2Body*));
 	m_contacts = (b2Contact**)m_allocator->Allocate(contactCapacity	 * sizeof(b2Contact*));
@@ -191,6 +193,7 @@ b2Island::b2Island(
 
 	m_allocator = NULL;
 	m_listener = listener;
+	m_executor = NULL;
 
 	m_bodies = bodies;
 	m_contacts = contacts;
@@ -200,6 +203,112 @@ b2Island::b2Island(
 	m_positions = positions;
 }
 
+enum b2ContactSolverPhase
+{
+	e_warmStartPhase,
+	e_solveVelocityPhase,
+	e_solveWideVelocityPhase,
+	e_solvePositionPhase
+};
+
+/// Solve the contacts [begin, end) for one phase. Returns the minimum separation
+/// if the phase solves position constraints.
+static float32 b2SolveContacts(b2ContactSolver& solver, b2ContactSolverPhase phase, int32 begin, int32 end)
+{
+	switch (phase)
+	{
+	case e_warmStartPhase:
+		solver.WarmStart(begin, end);
+		break;
+	case e_solveVelocityPhase:
+		solver.SolveVelocityConstraints(begin, end);
+		break;
+	case e_solveWideVelocityPhase:
+		solver.SolveWideVelocityConstraints(begin, end);
+		break;
+	case e_solvePositionPhase:
+		return solver.SolvePositionConstraints(begin, end);
+	}
+	return 0.0f;
+}
+
+/// Solves part of one color of an island's contacts.
+class b2ContactSolverTask : public b2RangedTask
+{
+public:
+	b2ContactSolver* m_solver;
+	b2ContactSolverPhase m_phase;
+	int32 m_offset;
+	float32 m_minSeparation;
+
+private:
+	virtual void Execute(b2StackAllocator&) /* override */
+	{
+		m_minSeparation = b2SolveContacts(*m_solver, m_phase, m_offset + m_beginIndex, m_offset + m_endIndex);
+	}
+};
+
+/// Run one phase of a colored contact solver. The colors are solved one after
+/// another, the contacts of one color are split among the executor's threads
+/// (if any). The wide phase splits batches of contacts instead.
+/// Returns the minimum separation if the phase solves position constraints.
+static float32 b2SolveColors(b2ContactSolver& solver, b2ContactSolverPhase phase,
+	b2TaskExecutor* executor, b2StackAllocator& allocator)
+{
+	b2ContactSolverTask tasks[b2_maxThreads];
+	int32 maxTaskCount = executor ? b2Min(executor->GetThreadCount() + 1, b2_maxThreads) : 1;
+
+	float32 minSeparation = 0.0f;
+	for (int32 color = 0; color < solver.m_colorCount; ++color)
+	{
+		int32 begin = solver.m_colorOffsets[color];
+		int32 end = solver.m_colorOffsets[color + 1];
+
+		if (color == solver.m_sequentialColor)
+		{
+			// The wide solver has no batches for these.
+			b2ContactSolverPhase sequentialPhase = phase == e_solveWideVelocityPhase ? e_solveVelocityPhase : phase;
+			minSeparation = b2Min(minSeparation, b2SolveContacts(solver, sequentialPhase, begin, end));
+			continue;
+		}
+
+		int32 contactsPerElement = 1;
+		if (phase == e_solveWideVelocityPhase)
+		{
+			begin = solver.m_colorBatchOffsets[color];
+			end = solver.m_colorBatchOffsets[color + 1];
+			contactsPerElement = b2_wideLanes;
+		}
+
+		int32 count = end - begin;
+		int32 taskCount = b2Min(maxTaskCount, count * contactsPerElement / b2_minContactsPerTask);
+		if (taskCount <= 1)
+		{
+			minSeparation = b2Min(minSeparation, b2SolveContacts(solver, phase, begin, end));
+			continue;
+		}
+
+		for (int32 i = 0; i < taskCount; ++i)
+		{
+			tasks[i].m_solver = &solver;
+			tasks[i].m_phase = phase;
+			tasks[i].m_offset = begin;
+			tasks[i].m_minSeparation = 0.0f;
+		}
+
+		b2TaskGroup group(*executor);
+		group.SubmitRangedTasks(tasks, taskCount, count, allocator);
+		group.Wait(allocator);
+
+		for (int32 i = 0; i < taskCount; ++i)
+		{
+			minSeparation = b2Min(minSeparation, tasks[i].m_minSeparation);
+		}
+	}
+
+	return minSeparation;
+}
+
 b2Island::~b2Island()
 {
 	if (m_allocator)
@@ -213,7 +322,7 @@ b2Island::~b2Island()
 	}
 }
 
-void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& gravity, bool allowSleep)
+bool b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& gravity, bool allowSleep)
 {
 	b2Timer timer;
 
@@ -229,9 +338,13 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 		b2Vec2 v = b->m_linearVelocity;
 		float32 w = b->m_angularVelocity;
 
-		// Store positions for continuous collision.
-		b->m_sweep.c0 = b->m_sweep.c;
-		b->m_sweep.a0 = b->m_sweep.a;
+		// Store positions for continuous collision. Static bodies never move,
+		// and one can be in several islands solved at once, so they aren't written.
+		if (b->m_type != b2_staticBody)
+		{
+			b->m_sweep.c0 = b->m_sweep.c;
+			b->m_sweep.a0 = b->m_sweep.a;
+		}
 
 		if (b->m_type == b2_dynamicBody)
 		{
@@ -274,16 +387,57 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 	contactSolverDef.allocator = m_allocator;
 
 	b2ContactSolver contactSolver(&contactSolverDef);
+
+	// Large islands group their contacts by color and solve each color on
+	// several threads. The coloring only depends on the order of the contacts,
+	// and is done even without threads, so the results don't depend on the
+	// number of threads. The wide solver packs contacts of the same color
+	// into batches.
+	bool large = step.contactColoring && m_contactCount >= b2_minColoredContacts;
+	b2TaskExecutor* executor = NULL;
+	if (large && m_executor && m_executor->GetThreadCount() > 0)
+	{
+		executor = m_executor;
+	}
+	bool wide = step.wideContactSolver && m_contactCount >= b2_minWideContacts;
+	bool colored = large || wide;
+	if (colored)
+	{
+		contactSolver.Color();
+	}
+
 	contactSolver.InitializeVelocityConstraints();
 
-	if (step.warmStarting)
+	if (colored)
+	{
+		// Initialize the joints first; tasks executed while waiting may
+		// change the island indices of shared static bodies.
+		for (int32 i = 0; i < m_jointCount; ++i)
+		{
+			m_joints[i]->InitVelocityConstraints(solverData);
+		}
+
+		if (step.warmStarting)
+		{
+			b2SolveColors(contactSolver, e_warmStartPhase, executor, *m_allocator);
+		}
+	}
+	else
 	{
-		contactSolver.WarmStart();
+		if (step.warmStarting)
+		{
+			contactSolver.WarmStart();
+		}
+
+		for (int32 i = 0; i < m_jointCount; ++i)
+		{
+			m_joints[i]->InitVelocityConstraints(solverData);
+		}
 	}
 
-	for (int32 i = 0; i < m_jointCount; ++i)
+	if (wide)
 	{
-		m_joints[i]->InitVelocityConstraints(solverData);
+		contactSolver.InitializeWideConstraints();
 	}
 
 	profile->solveInit = timer.GetMilliseconds();
@@ -297,7 +451,23 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 			m_joints[j]->SolveVelocityConstraints(solverData);
 		}
 
-		contactSolver.SolveVelocityConstraints();
+		if (wide)
+		{
+			b2SolveColors(contactSolver, e_solveWideVelocityPhase, executor, *m_allocator);
+		}
+		else if (colored)
+		{
+			b2SolveColors(contactSolver, e_solveVelocityPhase, executor, *m_allocator);
+		}
+		else
+		{
+			contactSolver.SolveVelocityConstraints();
+		}
+	}
+
+	if (wide)
+	{
+		contactSolver.StoreWideImpulses();
 	}
 
 	// Store impulses for warm starting
@@ -342,7 +512,17 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 	bool positionSolved = false;
 	for (int32 i = 0; i < step.positionIterations; ++i)
 	{
-		bool contactsOkay = contactSolver.SolvePositionConstraints();
+		bool contactsOkay;
+		if (colored)
+		{
+			// See b2ContactSolver::SolvePositionConstraints.
+			float32 minSeparation = b2SolveColors(contactSolver, e_solvePositionPhase, executor, *m_allocator);
+			contactsOkay = minSeparation >= -3.0f * b2_linearSlop;
+		}
+		else
+		{
+			contactsOkay = contactSolver.SolvePositionConstraints();
+		}
 
 		bool jointsOkay = true;
 		for (int32 j = 0; j < m_jointCount; ++j)
@@ -408,11 +588,22 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 
 		if (minSleepTime >= b2_timeToSleep && positionSolved)
 		{
-			for (int32 i = 0; i < m_bodyCount; ++i)
-			{
-				b2Body* b = m_bodies[i];
-				b->SetAwake(false);
-			}
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void b2Island::Sleep()
+{
+	// Static bodies are shared with other islands and have no motion to stop.
+	for (int32 i = 0; i < m_bodyCount; ++i)
+	{
+		b2Body* b = m_bodies[i];
+		if (b->GetType() != b2_staticBody)
+		{
+			b->SetAwake(false);
 		}
 	}
 }
@@ -28,6 +28,8 @@ class b2Contact;
 class b2Joint;
 class b2StackAllocator;
 class b2ContactListener;
+class b2ContactSolver;
+class b2TaskExecutor;
 struct b2ContactVelocityConstraint;
 struct b2Profile;
 
@@ -50,7 +52,12 @@ public:
 		m_jointCount = 0;
 	}
 
-	void Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& gravity, bool allowSleep);
+	/// Returns true if the island has rested long enough to sleep. The
+	/// caller puts it to sleep with Sleep(), once no other island is
+	/// being solved which could read its bodies' flags.
+	bool Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& gravity, bool allowSleep);
+
+	void Sleep();
 
 	void SolveTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiIndexB);
 
@@ -79,6 +86,9 @@ public:
 	b2StackAllocator* m_allocator;
 	b2ContactListener* m_listener;
 
+	/// If set, large islands solve their contacts on the executor's threads.
+	b2TaskExecutor* m_executor;
+
 	b2Body** m_bodies;
 	b2Contact** m_contacts;
 	b2Joint** m_joints;
@@ -46,6 +46,8 @@ struct b2TimeStep
 	int32 velocityIterations;
 	int32 positionIterations;
 	bool warmStarting;
+	bool contactColoring;
+	bool wideContactSolver;
 };
 
 /// This is an internal structure.
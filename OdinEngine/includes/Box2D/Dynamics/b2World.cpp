@@ -46,14 +46,16 @@ public:
 		b2Body** bodies, b2Contact** contacts, b2Joint** joints,
 		b2Velocity* velocities, b2Position* positions, b2ContactListener* listener,
 		const b2TimeStep& timestep, b2Vec2 gravity, bool allowSleep,
-		b2SolveTask* next)
+		b2TaskExecutor* executor, b2SolveTask* next)
 		: m_island(bodyCount, contactCount, jointCount,
 		bodies, contacts, joints,
 		velocities, positions, listener)
 	{
+		m_island.m_executor = executor;
 		m_timestep = &timestep;
 		m_gravity = gravity;
 		m_allowSleep = allowSleep;
+		m_sleep = false;
 		m_next = next;
 		SetCost(b2GetIslandCost(bodyCount, contactCount, jointCount));
 	}
@@ -62,6 +64,17 @@ public:
 
 	b2Profile& GetProfile() { return m_profile; }
 
+	// Puts the island to sleep if it came to rest. Called after every
+	// island is solved, since the traversal reads the bodies' flags while
+	// tasks run.
+	void Sleep()
+	{
+		if (m_sleep)
+		{
+			m_island.Sleep();
+		}
+	}
+
 private:
 
 	virtual void Execute(b2StackAllocator& allocator) /* override */
@@ -75,7 +88,7 @@ private:
 			m_island.m_bodies[i]->SetIslandIndex(i);
 		}
 
-		m_island.Solve(&m_profile, *m_timestep, m_gravity, m_allowSleep);
+		m_sleep = m_island.Solve(&m_profile, *m_timestep, m_gravity, m_allowSleep);
 
 		// Unset the allocator.
 		m_island.m_allocator = NULL;
@@ -85,6 +98,7 @@ private:
 	const b2TimeStep* m_timestep;
 	b2Vec2 m_gravity;
 	bool m_allowSleep;
+	bool m_sleep;
 	b2SolveTask* m_next;
 	b2Profile m_profile;
 };
@@ -152,7 +166,7 @@ private:
 	}
 };
 
-b2World::b2World(const b2Vec2& gravity, b2ThreadPool* threadPool)
+b2World::b2World(const b2Vec2& gravity, b2TaskExecutor* executor)
 : m_nonStaticBodies(b2_initialNonStaticBodiesCapacity)
 , m_staticBodies(b2_initialStaticBodiesCapacity)
 {
@@ -168,6 +182,8 @@ b2World::b2World(const b2Vec2& gravity, b2ThreadPool* threadPool)
 	m_warmStarting = true;
 	m_continuousPhysics = true;
 	m_subStepping = false;
+	m_contactColoring = true;
+	m_wideContactSolver = false;
 
 	m_stepComplete = true;
 
@@ -182,15 +198,17 @@ b2World::b2World(const b2Vec2& gravity, b2ThreadPool* threadPool)
 
 	memset(&m_profile, 0, sizeof(b2Profile));
 
-	if (threadPool && threadPool->GetThreadCount() > 0)
+	if (executor && executor->GetThreadCount() > 0)
 	{
-		m_threadPool = threadPool;
+		b2Assert(executor->GetThreadCount() <= b2_maxThreadPoolThreads);
+
+		m_executor = executor;
 		
-		m_threadCount = threadPool->GetThreadCount() + 1;
+		m_threadCount = executor->GetThreadCount() + 1;
 	}
 	else
 	{
-		m_threadPool = NULL;
+		m_executor = NULL;
 
 		m_threadCount = 1;
 	}
@@ -682,7 +700,10 @@ void b2World::Solve(const b2TimeStep& step)
 		}
 
 		b2Profile profile;
-		island.Solve(&profile, step, m_gravity, m_allowSleep);
+		if (island.Solve(&profile, step, m_gravity, m_allowSleep))
+		{
+			island.Sleep();
+		}
 		m_profile.solveInit += profile.solveInit;
 		m_profile.solveVelocity += profile.solveVelocity;
 		m_profile.solvePosition += profile.solvePosition;
@@ -1023,6 +1044,8 @@ void b2World::SolveTOI(const b2TimeStep& step)
 		subStep.positionIterations = 20;
 		subStep.velocityIterations = step.velocityIterations;
 		subStep.warmStarting = false;
+		subStep.contactColoring = false;
+		subStep.wideContactSolver = false;
 		island.SolveTOI(subStep, bA->GetIslandIndex(), bB->GetIslandIndex());
 
 		{
@@ -1069,7 +1092,7 @@ void b2World::SolveTOI(const b2TimeStep& step)
 
 void b2World::SynchronizeFixturesMT()
 {
-	b2TaskGroup group(*m_threadPool);
+	b2TaskGroup group(*m_executor);
 
 	b2BroadphaseGenerateDefferedMovesTask moveTasks[b2_maxThreads];
 
@@ -1094,7 +1117,7 @@ void b2World::FindNewContactsMT()
 {
 	m_contactManager.m_deferCreates = true;
 
-	b2TaskGroup group(*m_threadPool);
+	b2TaskGroup group(*m_executor);
 
 	b2BroadphaseFindNewContactsTask tasks[b2_maxThreads];
 
@@ -1127,7 +1150,7 @@ void b2World::CollideMT()
 	m_contactManager.m_deferDestroys = true;
 	m_contactManager.m_deferAwakenings = true;
 
-	b2TaskGroup group(*m_threadPool);
+	b2TaskGroup group(*m_executor);
 
 	b2CollideTask contactsTasks[b2_maxThreads];
 	b2CollideTask toiContactsTasks[b2_maxThreads];
@@ -1161,7 +1184,7 @@ void b2World::CollideMT()
 void b2World::SolveMT(const b2TimeStep& step)
 {
 	b2SolveTask* solveTaskList = NULL;
-	b2TaskGroup solveGroup(*m_threadPool);
+	b2TaskGroup solveGroup(*m_executor);
 
 	int32 allBodiesCapacity = m_bodyCount + m_contactManager.GetContactCount() + m_jointCount;
 	int32 allContactsCapacity = m_contactManager.GetContactCount();
@@ -1321,7 +1344,7 @@ void b2World::SolveMT(const b2TimeStep& step)
 			new(task)b2SolveTask(bodyCount, contactCount, jointCount,
 				bodies, contacts, joints, velocities, positions,
 				m_contactManager.m_contactListener,
-				step, m_gravity, m_allowSleep, solveTaskList);
+				step, m_gravity, m_allowSleep, m_executor, solveTaskList);
 			solveTaskList = task;
 
 			bodies += bodyCount;
@@ -1353,7 +1376,7 @@ void b2World::SolveMT(const b2TimeStep& step)
 		new(task)b2SolveTask(bodyCount, contactCount, jointCount,
 			bodies, contacts, joints, velocities, positions,
 			m_contactManager.m_contactListener,
-			step, m_gravity, m_allowSleep, solveTaskList);
+			step, m_gravity, m_allowSleep, m_executor, solveTaskList);
 		solveTaskList = task;
 
 		allBodiesCount += bodyCount;
@@ -1377,6 +1400,8 @@ void b2World::SolveMT(const b2TimeStep& step)
 	{
 		b2SolveTask* task = solveTaskList;
 
+		task->Sleep();
+
 		// Save profile times.
 		m_profile.solveInit += task->GetProfile().solveInit;
 		m_profile.solveVelocity += task->GetProfile().solveVelocity;
@@ -1424,7 +1449,7 @@ void b2World::SolveMT(const b2TimeStep& step)
 
 void b2World::ClearIslandFlagsMT()
 {
-	b2TaskGroup group(*m_threadPool);
+	b2TaskGroup group(*m_executor);
 
 	b2ClearContactIslandFlagsTask contactsTasks[b2_maxThreads];
 	b2ClearContactIslandFlagsTask toiContactsTasks[b2_maxThreads];
@@ -1507,6 +1532,8 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
 	step.dtRatio = m_inv_dt0 * dt;
 
 	step.warmStarting = m_warmStarting;
+	step.contactColoring = m_contactColoring;
+	step.wideContactSolver = m_wideContactSolver;
 	
 	// Update contacts. This is where some contacts are destroyed.
 	{
@@ -1590,6 +1617,23 @@ void b2World::QueryAABB(b2QueryCallback* callback, const b2AABB& aabb) const
 	m_contactManager.m_broadPhase.Query(&wrapper, aabb);
 }
 
+// Same rules as b2ContactFilter::ShouldCollide.
+static bool b2ShouldRayCast(const b2Filter* filter, const b2Fixture* fixture)
+{
+	if (filter == NULL)
+	{
+		return true;
+	}
+
+	const b2Filter& filterB = fixture->GetFilterData();
+	if (filter->groupIndex == filterB.groupIndex && filter->groupIndex != 0)
+	{
+		return filter->groupIndex > 0;
+	}
+
+	return (filter->maskBits & filterB.categoryBits) != 0 && (filter->categoryBits & filterB.maskBits) != 0;
+}
+
 struct b2WorldRayCastWrapper
 {
 	float32 RayCastCallback(const b2RayCastInput& input, int32 proxyId)
@@ -1597,6 +1641,12 @@ struct b2WorldRayCastWrapper
 		void* userData = broadPhase->GetUserData(proxyId);
 		b2FixtureProxy* proxy = (b2FixtureProxy*)userData;
 		b2Fixture* fixture = proxy->fixture;
+
+		if (b2ShouldRayCast(filter, fixture) == false)
+		{
+			return input.maxFraction;
+		}
+
 		int32 index = proxy->childIndex;
 		b2RayCastOutput output;
 		bool hit = fixture->RayCast(&output, input, index);
@@ -1613,6 +1663,7 @@ struct b2WorldRayCastWrapper
 
 	const b2BroadPhase* broadPhase;
 	b2RayCastCallback* callback;
+	const b2Filter* filter;
 };
 
 void b2World::RayCast(b2RayCastCallback* callback, const b2Vec2& point1, const b2Vec2& point2) const
@@ -1620,6 +1671,7 @@ void b2World::RayCast(b2RayCastCallback* callback, const b2Vec2& point1, const b
 	b2WorldRayCastWrapper wrapper;
 	wrapper.broadPhase = &m_contactManager.m_broadPhase;
 	wrapper.callback = callback;
+	wrapper.filter = NULL;
 	b2RayCastInput input;
 	input.maxFraction = 1.0f;
 	input.p1 = point1;
@@ -1627,6 +1679,74 @@ void b2World::RayCast(b2RayCastCallback* callback, const b2Vec2& point1, const b
 	m_contactManager.m_broadPhase.RayCast(&wrapper, input);
 }
 
+void b2World::RayCast(b2RayCastCallback* callback, const b2Vec2& point1, const b2Vec2& point2, const b2Filter& filter) const
+{
+	b2WorldRayCastWrapper wrapper;
+	wrapper.broadPhase = &m_contactManager.m_broadPhase;
+	wrapper.callback = callback;
+	wrapper.filter = &filter;
+	b2RayCastInput input;
+	input.maxFraction = 1.0f;
+	input.p1 = point1;
+	input.p2 = point2;
+	m_contactManager.m_broadPhase.RayCast(&wrapper, input);
+}
+
+struct b2WorldRayCastBatchWrapper
+{
+	float32 RayCastCallback(const b2RayCastInput& input, int32 proxyId, int32 rayIndex)
+	{
+		void* userData = broadPhase->GetUserData(proxyId);
+		b2FixtureProxy* proxy = (b2FixtureProxy*)userData;
+		b2Fixture* fixture = proxy->fixture;
+
+		if (b2ShouldRayCast(filter, fixture) == false)
+		{
+			return input.maxFraction;
+		}
+
+		int32 index = proxy->childIndex;
+		b2RayCastOutput output;
+		bool hit = fixture->RayCast(&output, input, index);
+
+		if (hit)
+		{
+			// Keep the hit and clip the ray to it.
+			b2RayCastResult* result = results + rayIndex;
+			result->fixture = fixture;
+			result->point = (1.0f - output.fraction) * input.p1 + output.fraction * input.p2;
+			result->normal = output.normal;
+			result->fraction = output.fraction;
+			return output.fraction;
+		}
+
+		return input.maxFraction;
+	}
+
+	const b2BroadPhase* broadPhase;
+	b2RayCastResult* results;
+	const b2Filter* filter;
+};
+
+void b2World::RayCastBatch(const b2RayCastInput* inputs, b2RayCastResult* results, int32 count,
+	const b2Filter* filter) const
+{
+	for (int32 i = 0; i < count; ++i)
+	{
+		const b2RayCastInput& input = inputs[i];
+		results[i].fixture = NULL;
+		results[i].point = input.p1 + input.maxFraction * (input.p2 - input.p1);
+		results[i].normal.SetZero();
+		results[i].fraction = input.maxFraction;
+	}
+
+	b2WorldRayCastBatchWrapper wrapper;
+	wrapper.broadPhase = &m_contactManager.m_broadPhase;
+	wrapper.results = results;
+	wrapper.filter = filter;
+	m_contactManager.m_broadPhase.RayCastBatch(&wrapper, inputs, count);
+}
+
 void b2World::DrawShape(b2Fixture* fixture, const b2Transform& xf, const b2Color& color)
 {
 	switch (fixture->GetType())
@@ -31,12 +31,22 @@
 struct b2AABB;
 struct b2BodyDef;
 struct b2Color;
+struct b2Filter;
 struct b2JointDef;
 class b2Body;
 class b2Draw;
 class b2Fixture;
 class b2Joint;
-class b2ThreadPool;
+class b2TaskExecutor;
+
+/// The closest fixture hit by one ray of b2World::RayCastBatch.
+struct b2RayCastResult
+{
+	b2Fixture* fixture;	///< NULL if the ray hit nothing.
+	b2Vec2 point;		///< The point of initial intersection.
+	b2Vec2 normal;		///< The normal vector at the point of intersection.
+	float32 fraction;	///< The fraction of the ray to the point, maxFraction if nothing was hit.
+};
 
 /// The world class manages all physics entities, dynamic simulation,
 /// and asynchronous queries. The world also contains efficient memory
@@ -46,8 +56,8 @@ class b2World
 public:
 	/// Construct a world object.
 	/// @param gravity the world gravity vector.
-	/// @param threadPool a thread pool that will enable multi-threaded stepping if provided.
-	b2World(const b2Vec2& gravity, b2ThreadPool* threadPool = NULL);
+	/// @param executor a thread pool, or other task executor, that will enable multi-threaded stepping if provided.
+	b2World(const b2Vec2& gravity, b2TaskExecutor* executor = NULL);
 
 	/// Destruct the world. All physics entities are destroyed and all heap memory is released.
 	~b2World();
@@ -125,6 +135,28 @@ public:
 	/// @param point2 the ray ending point
 	void RayCast(b2RayCastCallback* callback, const b2Vec2& point1, const b2Vec2& point2) const;
 
+	/// Ray-cast the world for the fixtures in the path of the ray that would collide
+	/// with a fixture using the given filter data, as decided by the default contact
+	/// filter. Fixtures are filtered before their shapes are tested, so fixtures
+	/// the ray can't hit cost no more than a broad-phase check.
+	/// @param callback a user implemented callback class.
+	/// @param point1 the ray starting point
+	/// @param point2 the ray ending point
+	/// @param filter the collision filtering data of the ray.
+	void RayCast(b2RayCastCallback* callback, const b2Vec2& point1, const b2Vec2& point2, const b2Filter& filter) const;
+
+	/// Ray-cast the world for the closest fixture hit by each ray of a batch. The rays
+	/// traverse the broad-phase together, see b2DynamicTree::RayCastBatch. This only reads
+	/// the world, so batches may be cast in parallel (e.g. split across b2ThreadPool tasks)
+	/// as long as the world isn't stepped or modified meanwhile.
+	/// The ray-cast ignores shapes that contain the starting point.
+	/// @param inputs the rays. Each ray extends from p1 to p1 + maxFraction * (p2 - p1).
+	/// @param results receives the closest hit of each ray.
+	/// @param count the number of rays.
+	/// @param filter if not NULL, the collision filtering data of the rays, see RayCast.
+	void RayCastBatch(const b2RayCastInput* inputs, b2RayCastResult* results, int32 count,
+		const b2Filter* filter = NULL) const;
+
 	/// Get the world body list. With the returned body, use b2Body::GetNext to get
 	/// the next body in the world list. A NULL body indicates the end of the list.
 	/// @return the head of the world body list.
@@ -161,6 +193,18 @@ public:
 	void SetSubStepping(bool flag) { m_subStepping = flag; }
 	bool GetSubStepping() const { return m_subStepping; }
 
+	/// Enable/disable contact coloring. Islands with at least b2_minColoredContacts
+	/// contacts group them into colors which are solved on several threads. The
+	/// results don't depend on the number of threads. On by default.
+	void SetContactColoring(bool flag) { m_contactColoring = flag; }
+	bool GetContactColoring() const { return m_contactColoring; }
+
+	/// Enable/disable the wide contact solver. It solves the velocity constraints
+	/// of four independent contacts at once (using SSE2 if available) in islands
+	/// with at least b2_minWideContacts contacts.
+	void SetWideContactSolver(bool flag) { m_wideContactSolver = flag; }
+	bool GetWideContactSolver() const { return m_wideContactSolver; }
+
 	/// Get the number of broad-phase proxies.
 	int32 GetProxyCount() const;
 
@@ -274,11 +318,14 @@ private:
 	bool m_continuousPhysics;
 	bool m_subStepping;
 
+	bool m_contactColoring;
+	bool m_wideContactSolver;
+
 	bool m_stepComplete;
 
 	b2Profile m_profile;
 
-	b2ThreadPool* m_threadPool;
+	b2TaskExecutor* m_executor;
 
 	int32 m_threadCount;
 };
@@ -345,7 +392,7 @@ inline bool b2World::IsLocked() const
 
 inline bool b2World::IsMultithreadedStepEnabled() const
 {
-	return m_threadPool != NULL;
+	return m_executor != NULL;
 }
 
 inline void b2World::SetAutoClearForces(bool flag)
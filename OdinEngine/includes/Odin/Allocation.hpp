@@ -0,0 +1,75 @@
+// Andrew Meckling
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+namespace odin
+{
+    // A unit of allocated memory. Containers which take an allocator
+    // only need allocate( size ) to return something with a ptr and a
+    // size, and deallocate to take the same thing back, so the Game's
+    // Blk based allocators plug straight in.
+    struct MemoryBlock
+    {
+        void*  ptr;
+        size_t size;
+    };
+
+    // Default allocator of the engine's containers. Calls operator new.
+    class NewAllocator
+    {
+    public:
+
+        MemoryBlock allocate( size_t size )
+        {
+            return { ::operator new( size ), size };
+        }
+
+        void deallocate( MemoryBlock blk )
+        {
+            ::operator delete( blk.ptr );
+        }
+    };
+
+    // Growth policies pick a container's new capacity when it's full.
+    // grow( capacity, required ) returns at least required.
+
+    // Doubles the capacity; the fewest reallocations.
+    struct DoublingGrowth
+    {
+        static size_t grow( size_t capacity, size_t required )
+        {
+            return std::max( capacity * 2, required );
+        }
+    };
+
+    // Grows the capacity by half. The blocks freed by earlier growth add
+    // up to enough for a later one, so first fit allocators reuse them.
+    struct HalfGrowth
+    {
+        static size_t grow( size_t capacity, size_t required )
+        {
+            return std::max( capacity + capacity / 2 + 1, required );
+        }
+    };
+
+    // True if moving a T to another address and forgetting the original
+    // is the same as copying its bytes. Containers move such types with
+    // memcpy and skip the moved-from destructors. Specialize it for types
+    // which hold owning pointers but no pointers into themselves.
+    template< typename T >
+    struct is_trivially_relocatable
+        : std::integral_constant< bool, std::is_trivially_copyable< T >::value >
+    {
+    };
+
+    template< typename T, typename D >
+    struct is_trivially_relocatable< std::unique_ptr< T, D > >
+        : is_trivially_relocatable< D >
+    {
+    };
+
+} // namespace odin
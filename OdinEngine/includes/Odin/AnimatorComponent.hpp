@@ -1,8 +1,10 @@
 // Andrew Meckling
 #pragma once
 
-#include <vector>
+#include <algorithm>
 #include <array>
+#include <initializer_list>
+#include <vector>
 
 namespace odin
 {
@@ -0,0 +1,292 @@
+// Andrew Meckling
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "Registry.hpp"
+
+namespace odin
+{
+    // Sum of the arguments; a C++11 constexpr fold.
+    constexpr size_t _sum()
+    {
+        return 0;
+    }
+
+    template< typename... Rest >
+    constexpr size_t _sum( size_t first, Rest... rest )
+    {
+        return first + _sum( rest... );
+    }
+
+    // Index of T in the list of types.
+    template< typename T, typename... Types >
+    struct _type_index;
+
+    template< typename T, typename... Rest >
+    struct _type_index< T, T, Rest... >
+        : std::integral_constant< size_t, 0 >
+    {
+    };
+
+    template< typename T, typename First, typename... Rest >
+    struct _type_index< T, First, Rest... >
+        : std::integral_constant< size_t, 1 + _type_index< T, Rest... >::value >
+    {
+    };
+
+    // Stores the entities which have exactly the listed components, in
+    // chunks of CHUNK_BYTES. Inside a chunk every component type has its
+    // own packed array, so a pass over all of the components reads each
+    // array front to back with no lookups and no gaps.
+    // Rows are numbered across chunks in the dense order of the set:
+    // row r lives at index r % CHUNK_CAPACITY of chunk r / CHUNK_CAPACITY.
+    // Removing an entity moves the last row into its place.
+    // Adding and removing rows invalidates references into the chunks, so
+    // structural changes made while the rows are being iterated (or from
+    // jobs) are queued with defer() and deferRemove() and applied by
+    // flush() once iteration is over.
+    template< typename... Components >
+    class Archetype
+        : public SparseSet
+    {
+    public:
+
+        static constexpr size_t COMPONENT_COUNT = sizeof...( Components );
+        static constexpr size_t CHUNK_BYTES = 16 * 1024;
+
+        // Rows per chunk, leaving room to align every array.
+        static constexpr size_t CHUNK_CAPACITY =
+            (CHUNK_BYTES - _sum( alignof( Components )... )) / _sum( sizeof( Components )... );
+
+        static_assert( CHUNK_CAPACITY > 0, "components don't fit in a chunk" );
+
+        Archetype()
+        {
+            size_t offset = 0;
+            size_t i = 0;
+            using expand = int[];
+            (void) expand { 0, (
+                offset = (offset + alignof( Components ) - 1) / alignof( Components ) * alignof( Components ),
+                _offsets[ i++ ] = offset,
+                offset += sizeof( Components ) * CHUNK_CAPACITY,
+                0)... };
+        }
+
+        Archetype( const Archetype& ) = delete;
+        Archetype& operator =( const Archetype& ) = delete;
+
+        ~Archetype()
+        {
+            for ( std::uint32_t row = 0; row < _dense.size(); ++row )
+                _destroyRow( row );
+        }
+
+        // Adds the entity with its components. It must not be in the set.
+        void emplace( EntityIndex e, Components... components )
+        {
+            assert( !contains( e ) );
+
+            std::uint32_t row = std::uint32_t( _dense.size() );
+            if ( row / CHUNK_CAPACITY == _chunks.size() )
+                _chunks.emplace_back( new Chunk );
+
+            _push( e );
+            _constructRow( row, std::move( components )... );
+        }
+
+        // Removes the entity's row, and drops any queued change to it:
+        // the Registry calls this when the entity is destroyed, and its
+        // index may be reused before the next flush().
+        bool remove( EntityIndex e ) override
+        {
+            if ( !_pendingAdds.empty() )
+            {
+                _pendingAdds.erase( std::remove_if( _pendingAdds.begin(), _pendingAdds.end(),
+                    [e]( const std::tuple< EntityIndex, Components... >& add ) {
+                        return std::get< 0 >( add ) == e;
+                    } ), _pendingAdds.end() );
+            }
+
+            if ( !_pendingRemoves.empty() )
+            {
+                _pendingRemoves.erase( std::remove( _pendingRemoves.begin(), _pendingRemoves.end(), e ),
+                                       _pendingRemoves.end() );
+            }
+
+            return _removeRow( e );
+        }
+
+        // Returns the entity's component, or nullptr if it isn't in the set.
+        template< typename T >
+        T* find( EntityIndex e )
+        {
+            return contains( e ) ? &get< T >( e ) : nullptr;
+        }
+
+        // Returns the entity's component. The entity must be in the set.
+        template< typename T >
+        T& get( EntityIndex e )
+        {
+            std::uint32_t row = _sparse[ e ];
+            return _array< _type_index< T, Components... >::value >( row / CHUNK_CAPACITY )[ row % CHUNK_CAPACITY ];
+        }
+
+        // Returns the number of chunks holding rows.
+        size_t chunkCount() const
+        {
+            return (_dense.size() + CHUNK_CAPACITY - 1) / CHUNK_CAPACITY;
+        }
+
+        // Calls fn( entities, count, components... ) for a chunk, where
+        // entities and every component are arrays of count elements.
+        // Different chunks may be processed by different jobs.
+        template< typename Fn >
+        void eachInChunk( size_t chunk, Fn&& fn )
+        {
+            _eachInChunk( chunk, fn, std::index_sequence_for< Components... >{} );
+        }
+
+        // Calls fn( entity, components... ) for every row, chunk by chunk.
+        template< typename Fn >
+        void each( Fn&& fn )
+        {
+            for ( size_t c = 0; c < chunkCount(); ++c )
+            {
+                eachInChunk( c, [&fn]( const EntityIndex* ents, size_t count, Components*... arrays ) {
+                    for ( size_t i = 0; i < count; ++i )
+                        fn( ents[ i ], arrays[ i ]... );
+                } );
+            }
+        }
+
+        // Queues the entity to be added by the next flush().
+        void defer( EntityIndex e, Components... components )
+        {
+            _pendingAdds.emplace_back( e, std::move( components )... );
+        }
+
+        // Queues the entity to be removed by the next flush().
+        void deferRemove( EntityIndex e )
+        {
+            _pendingRemoves.push_back( e );
+        }
+
+        // Applies the queued removals, then the queued additions.
+        void flush()
+        {
+            for ( EntityIndex e : _pendingRemoves )
+                _removeRow( e );
+
+            for ( auto& add : _pendingAdds )
+                _emplace( add, std::index_sequence_for< Components... >{} );
+
+            _pendingRemoves.clear();
+            _pendingAdds.clear();
+        }
+
+    private:
+
+        struct Chunk
+        {
+            std::max_align_t storage[ CHUNK_BYTES / sizeof( std::max_align_t ) ];
+        };
+
+        std::vector< std::unique_ptr< Chunk > > _chunks;
+        size_t                                  _offsets[ COMPONENT_COUNT ]; // Array offsets in a chunk.
+
+        std::vector< std::tuple< EntityIndex, Components... > > _pendingAdds;
+        std::vector< EntityIndex >                              _pendingRemoves;
+
+        bool _removeRow( EntityIndex e )
+        {
+            if ( !contains( e ) )
+                return false;
+
+            std::uint32_t row = _sparse[ e ];
+            std::uint32_t last = std::uint32_t( _dense.size() - 1 );
+            if ( row != last )
+                _moveRow( row, last );
+
+            _destroyRow( last );
+            _pop( row );
+            return true;
+        }
+
+        template< size_t I >
+        using _Component = typename std::tuple_element< I, std::tuple< Components... > >::type;
+
+        template< size_t I >
+        _Component< I >* _array( size_t chunk )
+        {
+            static_assert( alignof( _Component< I > ) <= alignof( std::max_align_t ), "over-aligned component" );
+            return reinterpret_cast< _Component< I >* >(
+                reinterpret_cast< char* >( _chunks[ chunk ]->storage ) + _offsets[ I ] );
+        }
+
+        template< size_t I >
+        _Component< I >* _at( std::uint32_t row )
+        {
+            return _array< I >( row / CHUNK_CAPACITY ) + row % CHUNK_CAPACITY;
+        }
+
+        void _constructRow( std::uint32_t row, Components&&... components )
+        {
+            _constructRow( row, std::index_sequence_for< Components... >{}, std::move( components )... );
+        }
+
+        template< size_t... I >
+        void _constructRow( std::uint32_t row, std::index_sequence< I... >, Components&&... components )
+        {
+            using expand = int[];
+            (void) expand { 0, (new( _at< I >( row ) ) Components( std::move( components ) ), 0)... };
+        }
+
+        void _moveRow( std::uint32_t to, std::uint32_t from )
+        {
+            _moveRow( to, from, std::index_sequence_for< Components... >{} );
+        }
+
+        template< size_t... I >
+        void _moveRow( std::uint32_t to, std::uint32_t from, std::index_sequence< I... > )
+        {
+            using expand = int[];
+            (void) expand { 0, (*_at< I >( to ) = std::move( *_at< I >( from ) ), 0)... };
+        }
+
+        void _destroyRow( std::uint32_t row )
+        {
+            _destroyRow( row, std::index_sequence_for< Components... >{} );
+        }
+
+        template< size_t... I >
+        void _destroyRow( std::uint32_t row, std::index_sequence< I... > )
+        {
+            using expand = int[];
+            (void) expand { 0, (_at< I >( row )->~Components(), 0)... };
+        }
+
+        template< typename Fn, size_t... I >
+        void _eachInChunk( size_t chunk, Fn& fn, std::index_sequence< I... > )
+        {
+            size_t first = chunk * CHUNK_CAPACITY;
+            size_t count = _dense.size() - first < CHUNK_CAPACITY ? _dense.size() - first : CHUNK_CAPACITY;
+            fn( _dense.data() + first, count, _array< I >( chunk )... );
+        }
+
+        template< size_t... I >
+        void _emplace( std::tuple< EntityIndex, Components... >& add, std::index_sequence< I... > )
+        {
+            emplace( std::get< 0 >( add ), std::move( std::get< I + 1 >( add ) )... );
+        }
+    };
+
+} // namespace odin
@@ -2,8 +2,12 @@
 #pragma once
 
 #include <algorithm>
+#include <cstring>
 #include <initializer_list>
 
+#include "Allocation.hpp"
+#include "SearchLayout.hpp"
+
 namespace odin
 {
     // Convenience definition used by BinarySearchMap.
@@ -21,24 +25,41 @@ namespace odin
     // Datawise, the allocated memory looks like this:
     //     struct AllocatedMemory {
     //         KeyType keys[ N ];
-    //         ValueType values[ N ];
+    //         ValueType values[ N ]; // (aligned for ValueType)
     //     };
     // where N is the capacity of the dictionary.
     // The elements stored by this container are sorted on their keys.
     // This is to allow key lookup to utilize a binary search. This 
     // dramatically improves lookup performance at the cost of insertion
     // /deletion performance.
-    template< typename KeyType_, typename ValueType_ >
+    // The Layout decides how a key is searched for (see SearchLayout.hpp);
+    // large maps which are searched far more often than they change can
+    // use EytzingerLayout. Entries are sorted whatever the layout.
+    // Memory comes from the Allocator (see Allocation.hpp), which must
+    // return blocks aligned for both keys and values, and the Growth
+    // policy picks the capacity when the map is full. Keys and values
+    // which are trivially relocatable are moved with memcpy.
+    template< typename KeyType_, typename ValueType_,
+              template< typename > class Layout_ = SortedLayout,
+              typename Allocator_ = NewAllocator,
+              typename Growth_ = DoublingGrowth >
     class BinarySearchMap
     {
     public:
 
         using KeyType   = KeyType_;
         using ValueType = ValueType_;
+        using Layout    = Layout_< KeyType_ >;
+        using Allocator = Allocator_;
+        using Growth    = Growth_;
 
         static constexpr size_t KEY_SIZE   = sizeof( KeyType );
         static constexpr size_t VALUE_SIZE = sizeof( ValueType );
 
+        // True if entries are moved around with memcpy.
+        static constexpr bool RELOCATABLE = is_trivially_relocatable< KeyType >::value
+                                         && is_trivially_relocatable< ValueType >::value;
+
         template< typename T >
         struct _iterator;
 
@@ -50,22 +71,46 @@ namespace odin
 
     private:
 
-        void*  _pData;      // Pointer to the allocated memory.
-        size_t _capacity;   // Maximum number of entries that can be stored by _pData.
-        size_t _count;      // Current number of entries that are stored by _pData.
+        using Block = decltype( std::declval< Allocator& >().allocate( size_t() ) );
 
-        friend void std::swap( BinarySearchMap& a, BinarySearchMap& b );
+        void*     _pData;     // Pointer to the allocated memory.
+        size_t    _capacity;  // Maximum number of entries that can be stored by _pData.
+        size_t    _count;     // Current number of entries that are stored by _pData.
+        Layout    _layout;    // Search index over the keys, if the layout keeps one.
+        Allocator _allocator; // Source of _pData.
 
-        // Allocates a block of memory for the keys and values.
-        static void* _allocate( size_t capacity )
+        // Offset of the values from the keys, in bytes.
+        static size_t _valuesOffset( size_t capacity )
         {
-            return new char[ (KEY_SIZE + VALUE_SIZE) * capacity ];
+            constexpr size_t align = alignof( ValueType );
+            return (KEY_SIZE * capacity + align - 1) / align * align;
+        }
+
+        // Size of the block holding capacity keys and values, in bytes.
+        static size_t _bytes( size_t capacity )
+        {
+            return _valuesOffset( capacity ) + VALUE_SIZE * capacity;
+        }
+
+        // Allocates a block of memory for the keys and values. A capacity
+        // of 0 allocates nothing.
+        void* _allocate( size_t capacity )
+        {
+            if ( capacity == 0 )
+                return nullptr;
+
+            Block blk = _allocator.allocate( _bytes( capacity ) );
+            if ( blk.ptr == nullptr )
+                throw "out of memory";
+
+            return blk.ptr;
         }
 
         // Deallocates a block of memory used by the keys and values.
-        static void _deallocate( void* pData )
+        void _deallocate( void* pData, size_t capacity )
         {
-            delete[] pData;
+            if ( pData != nullptr )
+                _allocator.deallocate( Block { pData, _bytes( capacity ) } );
         }
 
         #define _pKeys _keys()
@@ -87,13 +132,13 @@ namespace odin
         // Gets a pointer to the values.
         ValueType* _values()
         {
-            return reinterpret_cast< ValueType* >( _pKeys + _capacity );
+            return reinterpret_cast< ValueType* >( (char*) _pData + _valuesOffset( _capacity ) );
         }
 
         // Gets a const pointer to the values.
         const ValueType* _values() const
         {
-            return reinterpret_cast< const ValueType* >( _pKeys + _capacity );
+            return reinterpret_cast< const ValueType* >( (const char*) _pData + _valuesOffset( _capacity ) );
         }
 
         // Constructs a key and a value at a specific index in the map.
@@ -113,19 +158,23 @@ namespace odin
     public:
 
         // Allocates memory for the table of keys and values.
-        // Default capacity is 12; capacity must be greater than 0.
-        explicit BinarySearchMap( size_t capacity = 12 )
-            : _pData( _allocate( capacity ) )
+        // Default capacity is 12. A capacity of 0 allocates nothing until
+        // the first entry is added.
+        explicit BinarySearchMap( size_t capacity = 12, Allocator allocator = Allocator() )
+            : _pData( nullptr )
             , _capacity( capacity )
             , _count( 0 )
+            , _allocator( std::move( allocator ) )
         {
+            _pData = _allocate( capacity );
         }
 
         // Allocates memory for the supplied table, plus an optional amount of padding.
         // The provided initializer_list does not need to be in any order, however,
         // supplying duplicate keys will result in undefined behaviour.
-        BinarySearchMap( InitializerListType list, size_t padding = 0 )
-            : BinarySearchMap( list.size() + padding )
+        BinarySearchMap( InitializerListType list, size_t padding = 0,
+                         Allocator allocator = Allocator() )
+            : BinarySearchMap( list.size() + padding, std::move( allocator ) )
         {
             _count = list.size();
 
@@ -155,7 +204,7 @@ namespace odin
 
         // Copies the contents of a map into the constructed map.
         BinarySearchMap( const BinarySearchMap& copy )
-            : BinarySearchMap( copy._capacity )
+            : BinarySearchMap( copy._capacity, copy._allocator )
         {
             _count = copy._count;
             for ( size_t i = 0; i < copy._count; ++i )
@@ -167,7 +216,9 @@ namespace odin
             : _pData( move._pData )
             , _capacity( move._capacity )
             , _count( move._count )
+            , _allocator( move._allocator )
         {
+            _layout.swap( move._layout );
             move._pData = nullptr;
             move._capacity = 0;
             move._count = 0;
@@ -179,7 +230,9 @@ namespace odin
             if ( _capacity != copy._capacity )
             {
                 clear();
-                _deallocate( _pData );
+                _deallocate( _pData, _capacity );
+                _pData = nullptr; // Stay destructible if allocating throws.
+                _capacity = 0;
                 _pData = _allocate( copy._capacity );
                 _capacity = copy._capacity;
 
@@ -200,21 +253,32 @@ namespace odin
             }
 
             _count = copy._count;
+            _layout.invalidate();
             return *this;
         }
 
         // Moves the contents from one map into another map.
         BinarySearchMap& operator =( BinarySearchMap&& move )
         {
-            std::swap( *this, move );
+            swap( move );
             return *this;
         }
 
+        // Exchanges the contents of two maps.
+        void swap( BinarySearchMap& other )
+        {
+            std::swap( _pData, other._pData );
+            std::swap( _capacity, other._capacity );
+            std::swap( _count, other._count );
+            std::swap( _allocator, other._allocator );
+            _layout.swap( other._layout );
+        }
+
         // Clears and deallocates the map.
         ~BinarySearchMap()
         {
             clear();
-            _deallocate( _pData );
+            _deallocate( _pData, _capacity );
         }
 
         // Returns the number of entries in the map.
@@ -233,12 +297,13 @@ namespace odin
         // Returns the size of the allocated memory in bytes.
         size_t size() const
         {
-            return (KEY_SIZE + VALUE_SIZE) * _capacity;
+            return _bytes( _capacity );
         }
 
         // Empties the map without deallocating memory.
         void clear()
         {
+            _layout.invalidate();
             while ( _count > 0 )
                 _destroy( --_count );
         }
@@ -257,29 +322,22 @@ namespace odin
             return itr ? *itr : throw "key not found";
         }
 
-        // Performs a binary search over the keys.
+        // Searches the keys using the map's layout. If the key isn't found
+        // the returned iterator is null but still points where the key
+        // would be inserted.
         Iterator search( KeyType key )
         {
-            const KeyType* lower = _pKeys;
-            const KeyType* upper = (_pKeys + _count) - 1;
-            const KeyType* mid   = _pKeys + (_count / 2);
-
-            while ( lower <= upper )
-            {
-                if ( *mid < key ) lower = mid + 1;
-           else if ( *mid > key ) upper = mid - 1;
-                else return Iterator( this, mid );
-
-                mid = lower + (upper - lower) / 2;
-            }
-
-            return Iterator( nullptr, mid );
+            size_t pos = _layout.lower_bound( _pKeys, _count, key );
+            bool found = pos < _count && !(key < _pKeys[ pos ]);
+            return Iterator( found ? this : nullptr, _pKeys + pos );
         }
 
-        // Performs a binary search over the keys.
+        // Searches the keys using the map's layout.
         ConstIterator search( KeyType key ) const
         {
-            return const_cast< BinarySearchMap* >( this )->search( key );
+            size_t pos = _layout.lower_bound( _pKeys, _count, key );
+            bool found = pos < _count && !(key < _pKeys[ pos ]);
+            return ConstIterator( found ? const_cast< BinarySearchMap* >( this ) : nullptr, _pKeys + pos );
         }
 
         // Allocates memory, moves entries, then deallocates memory.
@@ -310,6 +368,77 @@ namespace odin
             return true;
         }
 
+        // Removes every entry for which pred( key, value ) returns true.
+        // The remaining entries are compacted in a single pass.
+        // Returns the number of entries removed.
+        template< typename Predicate >
+        size_t remove_if( Predicate pred )
+        {
+            size_t kept = 0;
+            for ( size_t i = 0; i < _count; ++i )
+            {
+                const KeyType& key = _pKeys[ i ];
+                if ( pred( key, _pValues[ i ] ) )
+                    continue;
+
+                _compact( kept++, i );
+            }
+
+            return _truncate( kept );
+        }
+
+        // Removes the entries with the keys in the range [first, last).
+        // The keys must be sorted; keys which aren't in the map are ignored.
+        // The map is compacted in a single pass, starting from the first
+        // removed entry. Returns the number of entries removed.
+        template< typename KeyIterator >
+        size_t erase( KeyIterator first, KeyIterator last )
+        {
+            if ( first == last )
+                return 0;
+
+            size_t kept = std::lower_bound( _pKeys, _pKeys + _count, *first ) - _pKeys;
+            for ( size_t i = kept; i < _count; ++i )
+            {
+                while ( first != last && *first < _pKeys[ i ] )
+                    ++first;
+
+                if ( first != last && !(_pKeys[ i ] < *first) )
+                    continue;
+
+                _compact( kept++, i );
+            }
+
+            return _truncate( kept );
+        }
+
+        // Adds the entries (MapEntry-like objects) in the random access
+        // range [first, last), which must be sorted on their keys. The
+        // values are moved out of the range. Entries are merged in from
+        // the back of the map, so every entry moves at most once.
+        // Like add(), keys already in the map (or repeated in the range)
+        // are skipped. Returns the number of entries added.
+        template< typename EntryIterator >
+        size_t insert_range( EntryIterator first, EntryIterator last )
+        {
+            return _merge( size_t( last - first ),
+                [first]( size_t i ) -> const KeyType& { return first[ i ].key; },
+                [first]( size_t i ) -> ValueType& { return first[ i ].value; } );
+        }
+
+        // Moves every entry of another map into this map, skipping keys
+        // this map already has. Empties the other map.
+        // Returns the number of entries added.
+        size_t merge( BinarySearchMap&& other )
+        {
+            size_t added = _merge( other._count,
+                [&other]( size_t i ) -> const KeyType& { return other._pKeys[ i ]; },
+                [&other]( size_t i ) -> ValueType& { return other._pValues[ i ]; } );
+
+            other.clear();
+            return added;
+        }
+
     private:
 
         // Allocates memory, moves entries, then deallocates memory.
@@ -322,18 +451,30 @@ namespace odin
             if ( size == _capacity )
                 return;
 
-            BinarySearchMap tmp( size ); // Holder for old map data.
+            BinarySearchMap tmp( size, _allocator ); // Holder for old map data.
             tmp._count = std::min( _count, size );
 
-            std::swap( *this, tmp );
+            swap( tmp );
             // Pay careful attention when trying to understand the meaning
             // of the code after the swap.
 
             // Move old map data back into the current map.
-            for ( size_t i = 0; i < _count; ++i )
-                _construct( i < splitPos ? i : i + splitSize,
-                            std::move( tmp._pKeys[ i ] ),
-                            std::move( tmp._pValues[ i ] ) );
+            if ( RELOCATABLE )
+            {
+                size_t head = std::min( splitPos, _count );
+                _relocate( 0, tmp._pKeys, tmp._pValues, head );
+                _relocate( head + splitSize, tmp._pKeys + head, tmp._pValues + head, _count - head );
+            }
+            else
+            {
+                for ( size_t i = 0; i < _count; ++i )
+                {
+                    _construct( i < splitPos ? i : i + splitSize,
+                                std::move( tmp._pKeys[ i ] ),
+                                std::move( tmp._pValues[ i ] ) );
+                    tmp._destroy( i );
+                }
+            }
 
             // Destroy untouched elements.
             for ( size_t i = _count; i < tmp._count; ++i )
@@ -343,6 +484,19 @@ namespace odin
             // tmp's dtor cleans up old memory allocation.
         }
 
+        // Copies the bytes of count entries into the slots starting at pos.
+        // Only for relocatable entries; the sources must be forgotten.
+        // The sources are null when an empty map grows, and memmove
+        // mustn't be given null even to copy nothing.
+        void _relocate( size_t pos, const KeyType* keys, const ValueType* values, size_t count )
+        {
+            if ( count == 0 )
+                return;
+
+            std::memmove( (void*) (_pKeys + pos), keys, KEY_SIZE * count );
+            std::memmove( (void*) (_pValues + pos), values, VALUE_SIZE * count );
+        }
+
         // Inserts a key and a value at a specific index in the map.
         // Reallocates memory if necessary. Returns an iterator to the
         // newly inserted entry.
@@ -355,22 +509,33 @@ namespace odin
 
             if ( _count == _capacity )
             {
+                size_t capacity = Growth::grow( _capacity, _count + 1 );
                 if ( pos == _count ) // Appending
-                    reallocate( _capacity * 2 );
+                    reallocate( capacity );
                 else
-                    _reallocateSplit( _capacity * 2, pos );
+                    _reallocateSplit( capacity, pos );
             }
-            else // Shift chunk of data right when not appending
+            else if ( pos < _count && RELOCATABLE )
             {
-                for ( size_t i = _count; i > pos; --i )
+                _relocate( pos + 1, _pKeys + pos, _pValues + pos, _count - pos );
+            }
+            else if ( pos < _count ) // Shift chunk of data right when not appending
+            {
+                // The slot past the end is raw memory; construct into it.
+                _construct( _count, move( _pKeys[ _count - 1 ] ), move( _pValues[ _count - 1 ] ) );
+
+                for ( size_t i = _count - 1; i > pos; --i )
                 {
                     _pKeys[ i ]   = move( _pKeys[ i - 1 ] );
                     _pValues[ i ] = move( _pValues[ i - 1 ] );
                 }
+
+                _destroy( pos );
             }
 
             _construct( pos, move( key ), move( value ) );
             ++_count;
+            _layout.invalidate();
 
             return Iterator( this, _pKeys + pos );
         }
@@ -382,21 +547,127 @@ namespace odin
             if ( pos >= _count )
                 throw "index out of bounds";
 
-            // Shift chunk of data left when erasing from middle
-            for ( size_t i = pos; i < _count - count; ++i )
+            if ( RELOCATABLE )
             {
-                _pKeys[ i ]   = std::move( _pKeys[ i + count ] );
-                _pValues[ i ] = std::move( _pValues[ i + count ] );
+                for ( size_t i = pos; i < pos + count; ++i )
+                    _destroy( i );
+
+                _relocate( pos, _pKeys + pos + count, _pValues + pos + count, _count - pos - count );
             }
+            else
+            {
+                // Shift chunk of data left when erasing from middle
+                for ( size_t i = pos; i < _count - count; ++i )
+                {
+                    _pKeys[ i ]   = std::move( _pKeys[ i + count ] );
+                    _pValues[ i ] = std::move( _pValues[ i + count ] );
+                }
 
-            for ( size_t i = _count - count; i < _count; ++i )
-                _destroy( i );
+                for ( size_t i = _count - count; i < _count; ++i )
+                    _destroy( i );
+            }
 
             _count -= count;
+            _layout.invalidate();
 
             return Iterator( pos < _count ? this : nullptr, _pKeys + pos );
         }
 
+        // Moves the entry at index from to the lower index to.
+        void _compact( size_t to, size_t from )
+        {
+            if ( to == from )
+                return;
+
+            _pKeys[ to ]   = std::move( _pKeys[ from ] );
+            _pValues[ to ] = std::move( _pValues[ from ] );
+        }
+
+        // Destroys every entry from index count onwards.
+        // Returns the number of entries destroyed.
+        size_t _truncate( size_t count )
+        {
+            size_t removed = _count - count;
+            if ( removed > 0 )
+                _layout.invalidate();
+
+            while ( _count > count )
+                _destroy( --_count );
+
+            return removed;
+        }
+
+        // Merges n entries, sorted on their keys, into the map.
+        // keyAt( i ) and valueAt( i ) access the i-th entry.
+        template< typename KeyAt, typename ValueAt >
+        size_t _merge( size_t n, KeyAt keyAt, ValueAt valueAt )
+        {
+            // An entry is skipped if its key repeats the previous one.
+            auto repeated = [&keyAt]( size_t j ) {
+                return j > 0 && !(keyAt( j - 1 ) < keyAt( j ));
+            };
+
+            // Count the new keys first so the map grows at most once.
+            size_t added = 0;
+            size_t a = 0;
+            for ( size_t j = 0; j < n; ++j )
+            {
+                if ( repeated( j ) )
+                    continue;
+
+                while ( a < _count && _pKeys[ a ] < keyAt( j ) )
+                    ++a;
+
+                if ( a == _count || keyAt( j ) < _pKeys[ a ] )
+                    ++added;
+            }
+
+            if ( added == 0 )
+                return 0;
+
+            if ( _count + added > _capacity )
+                reallocate( Growth::grow( _capacity, _count + added ) );
+
+            // Fill the map from the back. Slots below the old count hold
+            // (possibly moved from) entries; slots above it are raw memory.
+            // Once every new entry is placed the rest is already in place.
+            const size_t oldCount = _count;
+            auto place = [this, oldCount]( size_t pos, KeyType&& key, ValueType&& value ) {
+                if ( pos < oldCount )
+                {
+                    _pKeys[ pos ]   = std::move( key );
+                    _pValues[ pos ] = std::move( value );
+                }
+                else
+                {
+                    _construct( pos, std::move( key ), std::move( value ) );
+                }
+            };
+
+            size_t out = oldCount + added;
+            a = oldCount;
+            for ( size_t j = n; j-- > 0 && out > a; )
+            {
+                if ( repeated( j ) )
+                    continue;
+
+                while ( a > 0 && keyAt( j ) < _pKeys[ a - 1 ] )
+                {
+                    --a;
+                    place( --out, std::move( _pKeys[ a ] ), std::move( _pValues[ a ] ) );
+                }
+
+                if ( a > 0 && !(_pKeys[ a - 1 ] < keyAt( j )) )
+                    continue;
+
+                place( --out, KeyType( keyAt( j ) ), std::move( valueAt( j ) ) );
+            }
+
+            _count = oldCount + added;
+            _layout.invalidate();
+            return added;
+        }
+
     public:
 
         #pragma region Iterators
@@ -524,12 +795,12 @@ namespace odin
 
         const_iterator cbegin() const
         {
-            return ConstIterator( this, _pKeys );
+            return ConstIterator( const_cast< BinarySearchMap* >( this ), _pKeys );
         }
 
         const_iterator cend() const
         {
-            return ConstIterator( this, _pKeys + _count );
+            return ConstIterator( const_cast< BinarySearchMap* >( this ), _pKeys + _count );
         }
 
         const_iterator begin() const
@@ -555,12 +826,10 @@ namespace odin
 
 namespace std
 {
-    template< typename K, typename V >
-    void swap( odin::BinarySearchMap< K, V >& a,
-               odin::BinarySearchMap< K, V >& b )
+    template< typename K, typename V, template< typename > class L, typename A, typename G >
+    void swap( odin::BinarySearchMap< K, V, L, A, G >& a,
+               odin::BinarySearchMap< K, V, L, A, G >& b )
     {
-        std::swap( a._pData, b._pData );
-        std::swap( a._capacity, b._capacity );
-        std::swap( a._count, b._count );
+        a.swap( b );
     }
 }
@@ -0,0 +1,244 @@
+// Andrew Meckling
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "BinarySearchMap.hpp"
+#include "JobSystem.hpp"
+#include "Registry.hpp"
+
+namespace odin
+{
+    // Adds a component to an entity once it exists. Shared by the
+    // command buffers of every allocator, so they can be appended.
+    template< typename Name >
+    class EntityAddCommand
+    {
+    public:
+
+        Name name;
+
+        explicit EntityAddCommand( Name name )
+            : name( name )
+        {
+        }
+
+        virtual ~EntityAddCommand() = default;
+
+        virtual void apply( Registry& registry, EntityIndex e ) = 0;
+    };
+
+    // Records structural changes to a scene's entities so they can be
+    // requested while the entities are being iterated (or from jobs) and
+    // made later, all at once. Entities are named by the key of the
+    // scene's entity index; Value is the entry stored under that key.
+    // The buffer only records; the scene applies the commands, in order:
+    // destroys, then creates, then added components. A name can be
+    // destroyed and created again in one batch.
+    // Alloc is a standard library allocator, rebound for each of the
+    // buffer's vectors; a buffer which only lives for a frame can take
+    // its memory from a frame arena.
+    template< typename Name, typename Value, typename Alloc = std::allocator< Value > >
+    class EntityCommandBuffer
+    {
+        template< typename T >
+        using _Vector = std::vector< T, typename std::allocator_traits< Alloc >::template rebind_alloc< T > >;
+
+    public:
+
+        using Entry = MapEntry< Name, Value >;
+
+        using AddCommand = EntityAddCommand< Name >;
+
+        EntityCommandBuffer() = default;
+
+        explicit EntityCommandBuffer( const Alloc& alloc )
+            : _created( alloc )
+            , _destroyedNames( alloc )
+            , _destroyedHandles( alloc )
+            , _added( alloc )
+        {
+        }
+
+        EntityCommandBuffer( EntityCommandBuffer&& ) = default;
+        EntityCommandBuffer& operator =( EntityCommandBuffer&& ) = default;
+
+        // Creates the named entity with the given entry.
+        void create( Name name, Value value = Value() )
+        {
+            _created.push_back( { name, std::move( value ) } );
+        }
+
+        void destroy( Name name )
+        {
+            _destroyedNames.push_back( name );
+        }
+
+        // Destroys an entity which isn't in the entity index.
+        void destroy( Handle h )
+        {
+            _destroyedHandles.push_back( h );
+        }
+
+        // Adds (or replaces) a component of the named entity.
+        template< typename T >
+        void add( Name name, T component )
+        {
+            _added.emplace_back( new _Add< T >( name, std::move( component ) ) );
+        }
+
+        bool empty() const
+        {
+            return _created.empty() && _destroyedNames.empty()
+                && _destroyedHandles.empty() && _added.empty();
+        }
+
+        void clear()
+        {
+            _created.clear();
+            _destroyedNames.clear();
+            _destroyedHandles.clear();
+            _added.clear();
+        }
+
+        // Moves the commands of another buffer after this buffer's.
+        template< typename OtherAlloc >
+        void append( EntityCommandBuffer< Name, Value, OtherAlloc >& other )
+        {
+            _moveAppend( _created, other._created );
+            _moveAppend( _destroyedNames, other._destroyedNames );
+            _moveAppend( _destroyedHandles, other._destroyedHandles );
+            _moveAppend( _added, other._added );
+        }
+
+        // Sorts the creates and destroys on their names, ready to be
+        // merged into (and erased from) the entity index in one pass.
+        // Repeated destroys are dropped. Repeated creates are kept, in the
+        // order they were recorded: their values may own entities, which
+        // whoever rejects them must destroy. Added components keep the
+        // order they were recorded in.
+        void sort()
+        {
+            std::stable_sort( _created.begin(), _created.end(),
+                []( const Entry& a, const Entry& b ) {
+                    return a.key < b.key;
+                } );
+
+            std::sort( _destroyedNames.begin(), _destroyedNames.end() );
+            _destroyedNames.erase( std::unique( _destroyedNames.begin(), _destroyedNames.end() ),
+                                   _destroyedNames.end() );
+        }
+
+        _Vector< Entry >& created()
+        {
+            return _created;
+        }
+
+        const _Vector< Name >& destroyedNames() const
+        {
+            return _destroyedNames;
+        }
+
+        const _Vector< Handle >& destroyedHandles() const
+        {
+            return _destroyedHandles;
+        }
+
+        const _Vector< std::unique_ptr< AddCommand > >& added() const
+        {
+            return _added;
+        }
+
+    private:
+
+        template< typename, typename, typename >
+        friend class EntityCommandBuffer;
+
+        template< typename T >
+        class _Add
+            : public AddCommand
+        {
+        public:
+
+            _Add( Name name, T&& component )
+                : AddCommand( name )
+                , _component( std::move( component ) )
+            {
+            }
+
+            void apply( Registry& registry, EntityIndex e ) override
+            {
+                registry.emplace< T >( e, std::move( _component ) );
+            }
+
+        private:
+
+            T _component;
+        };
+
+        _Vector< Entry >                         _created;
+        _Vector< Name >                          _destroyedNames;
+        _Vector< Handle >                        _destroyedHandles;
+        _Vector< std::unique_ptr< AddCommand > > _added;
+
+        template< typename To, typename From >
+        static void _moveAppend( To& to, From& from )
+        {
+            to.reserve( to.size() + from.size() );
+            for ( auto& x : from )
+                to.push_back( std::move( x ) );
+
+            from.clear();
+        }
+    };
+
+    // One EntityCommandBuffer per thread of a JobSystem, so threads record
+    // commands without locking. Threads which aren't workers share the
+    // first buffer and must not record at the same time.
+    // merge() gathers the commands at a sync point, when nothing records.
+    template< typename Name, typename Value >
+    class ThreadCommandBuffers
+    {
+    public:
+
+        using Buffer = EntityCommandBuffer< Name, Value >;
+
+        explicit ThreadCommandBuffers( JobSystem& jobs )
+            : _jobs( jobs )
+        {
+            // Separate allocations keep the buffers off each other's cache lines.
+            for ( int i = 0; i <= jobs.threadCount(); ++i )
+                _buffers.emplace_back( new Buffer );
+        }
+
+        ThreadCommandBuffers( const ThreadCommandBuffers& ) = delete;
+        ThreadCommandBuffers& operator =( const ThreadCommandBuffers& ) = delete;
+
+        // Returns the calling thread's buffer.
+        Buffer& local()
+        {
+            return *_buffers[ _jobs.threadIndex() ];
+        }
+
+        // Moves every thread's commands into one sorted buffer, which
+        // allocates with alloc.
+        template< typename Alloc = std::allocator< Value > >
+        EntityCommandBuffer< Name, Value, Alloc > merge( const Alloc& alloc = Alloc() )
+        {
+            EntityCommandBuffer< Name, Value, Alloc > all( alloc );
+            for ( auto& buffer : _buffers )
+                all.append( *buffer );
+
+            all.sort();
+            return all;
+        }
+
+    private:
+
+        JobSystem&                               _jobs;
+        std::vector< std::unique_ptr< Buffer > > _buffers; // Indexed by JobSystem::threadIndex.
+    };
+
+} // namespace odin
@@ -1,14 +1,27 @@
 // Andrew Meckling
 #pragma once
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <type_traits>
 #include <iostream>
 
 namespace odin
 {
+    // Packs count characters of a tag into a bit pattern, the first
+    // character at bit shift. Matches the byte layout of EntityId on
+    // little endian machines.
+    constexpr std::uint64_t _packTag( const char* tag, std::size_t count, unsigned shift )
+    {
+        return count == 0 ? 0
+            : (std::uint64_t( static_cast< unsigned char >( tag[ 0 ] ) ) << shift)
+              | _packTag( tag + 1, count - 1, shift + 8 );
+    }
 
     // 64bit (8byte) data structure used to uniquely identify 
     // entities in the entity-component system.
+    // Every constructor is constexpr, so ids built from literals are
+    // constants, and their bit patterns can be template arguments.
     union EntityId
     {
         std::uint64_t   _bitPattern;
@@ -18,20 +31,31 @@ namespace odin
             char          name[ 6 ];
         };
 
-        explicit EntityId( std::uint64_t entityId = 0 );
+        constexpr explicit EntityId( std::uint64_t entityId = 0 )
+            : _bitPattern( entityId )
+        {
+        }
+
+        // Tags of 1 to 6 characters, followed by a 16 bit number.
+        template< std::size_t N, typename = std::enable_if_t< (N >= 2 && N <= 7) > >
+        constexpr EntityId( const char (&tag)[ N ], std::uint16_t num = 0 )
+            : _bitPattern( std::uint64_t( num ) | _packTag( tag, N - 1, 16 ) )
+        {
+        }
 
-        EntityId( const char (&tag)[ 2 ], std::uint16_t num = 0 );
-        EntityId( const char (&tag)[ 3 ], std::uint16_t num = 0 );
-        EntityId( const char (&tag)[ 4 ], std::uint16_t num = 0 );
-        EntityId( const char (&tag)[ 5 ], std::uint16_t num = 0 );
-        EntityId( const char (&tag)[ 6 ], std::uint16_t num = 0 );
-        EntityId( const char (&tag)[ 7 ], std::uint16_t num = 0 );
+        // Tags of 7 or 8 characters, which leave no room for a number.
+        constexpr EntityId( const char (&tag)[ 8 ] )
+            : _bitPattern( _packTag( tag, 7, 8 ) )
+        {
+        }
 
-        EntityId( const char (&tag)[ 8 ] );
-        EntityId( const char (&tag)[ 9 ] );
+        constexpr EntityId( const char (&tag)[ 9 ] )
+            : _bitPattern( _packTag( tag, 8, 0 ) )
+        {
+        }
 
-        template< unsigned N, typename = std::enable_if_t< (N <= 7) > >
-        bool hasTag( const char (&tag)[ N ] ) const
+        template< std::size_t N, typename = std::enable_if_t< (N <= 7) > >
+        constexpr bool hasTag( const char (&tag)[ N ] ) const
         {
             static_assert( N > 1, "tag must contain at least 1 character" );
             static_assert( N <= 7, "tag can contain at most 6 characters" );
@@ -40,6 +64,19 @@ namespace odin
         }
     };
 
+    namespace literals
+    {
+        // "wintex"_eid is EntityId( "wintex", 0 ). Tags of 7 or 8
+        // characters take up the number's bytes, like the constructors.
+        constexpr EntityId operator "" _eid( const char* tag, std::size_t length )
+        {
+            return length >= 1 && length <= 6 ? EntityId( _packTag( tag, length, 16 ) )
+                 : length == 7 ? EntityId( _packTag( tag, 7, 8 ) )
+                 : length == 8 ? EntityId( _packTag( tag, 8, 0 ) )
+                 : throw "tag must contain 1 to 8 characters";
+        }
+    }
+
     inline std::ostream& operator <<( std::ostream& os, const EntityId& eid )
     {
         char name[ 7 ] = { 0 };
@@ -47,32 +84,32 @@ namespace odin
         return os << eid._bitPattern << "(" << name << ":" << eid.index << ")";
     }
 
-    inline bool operator ==( const EntityId& lhs, const EntityId& rhs )
+    constexpr bool operator ==( const EntityId& lhs, const EntityId& rhs )
     {
         return lhs._bitPattern == rhs._bitPattern;
     }
 
-    inline bool operator !=( const EntityId& lhs, const EntityId& rhs )
+    constexpr bool operator !=( const EntityId& lhs, const EntityId& rhs )
     {
         return lhs._bitPattern != rhs._bitPattern;
     }
 
-    inline bool operator <( const EntityId& lhs, const EntityId& rhs )
+    constexpr bool operator <( const EntityId& lhs, const EntityId& rhs )
     {
         return lhs._bitPattern < rhs._bitPattern;
     }
 
-    inline bool operator >( const EntityId& lhs, const EntityId& rhs )
+    constexpr bool operator >( const EntityId& lhs, const EntityId& rhs )
     {
         return lhs._bitPattern > rhs._bitPattern;
     }
 
-    inline bool operator <=( const EntityId& lhs, const EntityId& rhs )
+    constexpr bool operator <=( const EntityId& lhs, const EntityId& rhs )
     {
         return lhs._bitPattern <= rhs._bitPattern;
     }
 
-    inline bool operator >=( const EntityId& lhs, const EntityId& rhs )
+    constexpr bool operator >=( const EntityId& lhs, const EntityId& rhs )
     {
         return lhs._bitPattern >= rhs._bitPattern;
     }
@@ -69,6 +69,9 @@ namespace odin
 		FacingDirection  direction = RIGHT;
 		bool visible = true;
 
+        glm::vec2  size = { 0, 0 };     // Dimensions of a rect (0 if not made by makeRect).
+        glm::vec2  texScale = { 1, 1 }; // Texture coordinate scale of a rect.
+
         GraphicalComponent() = default;
 
         template< typename Vertex >
@@ -120,6 +123,8 @@ namespace odin
 			, direction (move.direction)
             , visible( move.visible )
 			, interactive(move.interactive)
+            , size( move.size )
+            , texScale( move.texScale )
         {
             move.pData = nullptr;
             move.count = 0;
@@ -145,6 +150,8 @@ namespace odin
 			swap(direction, move.direction);
 			swap(visible, move.visible);
 			swap(interactive, move.interactive);
+            swap( size, move.size );
+            swap( texScale, move.texScale );
             return *this;
         }
 
@@ -167,12 +174,15 @@ namespace odin
                 { -width / 2, -height / 2, 0, 0, y },
             };
             
-			return GraphicalComponent( vertices, 6, glm::vec4{ color, alpha }, {
+			GraphicalComponent rect( vertices, 6, glm::vec4{ color, alpha }, {
                 Attribute< float >( 3 ),
                 Attribute< float >( 2 )
                 //make_vert_attr< glm::vec3 >(),
                 //make_vert_attr< glm::vec2 >()
             } );
+            rect.size = { width, height };
+            rect.texScale = tex;
+            return rect;
         }
 
         static GraphicalComponent makeRightTri(
@@ -0,0 +1,60 @@
+// Andrew Meckling
+#include "InstancedQuad.hpp"
+
+using namespace odin;
+
+InstancedQuad::InstancedQuad( size_t instanceSize, size_t capacity )
+    : _instanceSize( instanceSize )
+    , _capacity( capacity > 0 ? capacity : 1 )
+{
+    // Same winding and texture coordinates as GraphicalComponent::makeRect.
+    float vertices[][5] = {
+        { -0.5f, -0.5f, 0, 0, 1 },
+        { -0.5f, +0.5f, 0, 0, 0 },
+        { +0.5f, +0.5f, 0, 1, 0 },
+
+        { +0.5f, +0.5f, 0, 1, 0 },
+        { +0.5f, -0.5f, 0, 1, 1 },
+        { -0.5f, -0.5f, 0, 0, 1 },
+    };
+
+    glGenVertexArrays( 1, &_vertexArray );
+    glBindVertexArray( _vertexArray );
+
+    glGenBuffers( 1, &_quadBuffer );
+    glBindBuffer( GL_ARRAY_BUFFER, _quadBuffer );
+    glBufferData( GL_ARRAY_BUFFER, sizeof( vertices ), vertices, GL_STATIC_DRAW );
+
+    glEnableVertexAttribArray( 0 );
+    glVertexAttribPointer( 0, 3, GL_FLOAT, GL_FALSE, sizeof( vertices[ 0 ] ), (void*) 0 );
+    glEnableVertexAttribArray( 1 );
+    glVertexAttribPointer( 1, 2, GL_FLOAT, GL_FALSE, sizeof( vertices[ 0 ] ), (void*) (sizeof( float ) * 3) );
+
+    glGenBuffers( 1, &_instanceBuffer );
+    glBindBuffer( GL_ARRAY_BUFFER, _instanceBuffer );
+    glBufferData( GL_ARRAY_BUFFER, _instanceSize * _capacity, nullptr, GL_STREAM_DRAW );
+
+    glBindVertexArray( 0 );
+}
+
+InstancedQuad::~InstancedQuad()
+{
+    glDeleteVertexArrays( 1, &_vertexArray );
+    glDeleteBuffers( 1, &_quadBuffer );
+    glDeleteBuffers( 1, &_instanceBuffer );
+}
+
+void InstancedQuad::bind() const
+{
+    glBindVertexArray( _vertexArray );
+    glBindBuffer( GL_ARRAY_BUFFER, _instanceBuffer );
+}
+
+void InstancedQuad::_upload( const void* instances, size_t count, size_t capacity )
+{
+    if ( count > _capacity )
+        _capacity = capacity;
+
+    glBufferData( GL_ARRAY_BUFFER, _instanceSize * _capacity, nullptr, GL_STREAM_DRAW );
+    glBufferSubData( GL_ARRAY_BUFFER, 0, _instanceSize * count, instances );
+}
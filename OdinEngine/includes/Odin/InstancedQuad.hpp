@@ -0,0 +1,63 @@
+// Andrew Meckling
+#pragma once
+
+#include <GL/glew.h>
+
+#include <vector>
+
+namespace odin
+{
+    // The vertex array shared by the instanced batches: a unit quad at
+    // attribute locations 0 (position) and 1 (texture coordinates), and a
+    // streamed buffer of per-instance data. Owners point their instance
+    // attributes, from FIRST_INSTANCE_ATTRIB on, into the instance buffer
+    // while the quad is bound.
+    class InstancedQuad
+    {
+    public:
+
+        static constexpr GLuint FIRST_INSTANCE_ATTRIB = 2;
+
+        InstancedQuad( size_t instanceSize, size_t capacity );
+
+        InstancedQuad( const InstancedQuad& ) = delete;
+        InstancedQuad& operator =( const InstancedQuad& ) = delete;
+
+        ~InstancedQuad();
+
+        // Binds the vertex array and the instance buffer.
+        void bind() const;
+
+        static void unbind()
+        {
+            glBindVertexArray( 0 );
+        }
+
+        // Orphans the previous frame's storage so the driver doesn't have
+        // to wait for pending draws, then fills it with the instances. The
+        // buffer grows to the vector's capacity when they don't fit.
+        // The quad must be bound.
+        template< typename Instance >
+        void upload( const std::vector< Instance >& instances )
+        {
+            _upload( instances.data(), instances.size(), instances.capacity() );
+        }
+
+        // Draws count instances of the quad. The quad must be bound.
+        void draw( GLsizei count ) const
+        {
+            glDrawArraysInstanced( GL_TRIANGLES, 0, 6, count );
+        }
+
+    private:
+
+        GLuint _vertexArray = 0;
+        GLuint _quadBuffer = 0;
+        GLuint _instanceBuffer = 0;
+        size_t _instanceSize;
+        size_t _capacity; // Capacity of _instanceBuffer in instances.
+
+        void _upload( const void* instances, size_t count, size_t capacity );
+    };
+
+} // namespace odin
@@ -0,0 +1,267 @@
+// Andrew Meckling
+#include "JobSystem.hpp"
+
+using namespace odin;
+
+struct JobCounter::Job
+{
+    std::function< void() > fn;
+    JobCounter*             counter;
+    JobPriority             priority;
+};
+
+namespace
+{
+    // Identifies the worker running on the current thread.
+    thread_local const JobSystem* tls_owner = nullptr;
+    thread_local size_t           tls_index = 0;
+}
+
+JobSystem::JobSystem( int threadCount )
+{
+    if ( threadCount < 0 )
+        threadCount = int( std::thread::hardware_concurrency() ) - 1;
+
+    threadCount = std::max( threadCount, 0 );
+
+    _queues.reserve( threadCount + 1 );
+    for ( int i = 0; i <= threadCount; ++i )
+        _queues.emplace_back( new Queue );
+
+    _workers.reserve( threadCount );
+    for ( int i = 0; i < threadCount; ++i )
+        _workers.emplace_back( &JobSystem::_workerMain, this, size_t( i + 1 ) );
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard< std::mutex > lock( _sleepMutex );
+        _shutdown = true;
+    }
+    _wake.notify_all();
+
+    for ( std::thread& worker : _workers )
+        worker.join();
+
+    // Only jobs queued without ever being waited on can be left over.
+    for ( auto& queue : _queues )
+        for ( auto& jobs : queue->jobs )
+            for ( Job* job : jobs )
+                delete job;
+}
+
+size_t JobSystem::threadIndex() const
+{
+    return tls_owner == this ? tls_index : 0;
+}
+
+void JobSystem::run( std::function< void() > fn, JobCounter* counter, JobPriority priority )
+{
+    if ( counter )
+        counter->_pending.fetch_add( 1, std::memory_order_relaxed );
+
+    _push( threadIndex(), new Job { std::move( fn ), counter, priority } );
+}
+
+void JobSystem::runAfter( JobCounter&             dependency,
+                          std::function< void() > fn,
+                          JobCounter*             counter,
+                          JobPriority             priority )
+{
+    if ( counter )
+        counter->_pending.fetch_add( 1, std::memory_order_relaxed );
+
+    Job* job = new Job { std::move( fn ), counter, priority };
+
+    {
+        std::lock_guard< std::mutex > lock( dependency._mutex );
+        if ( !dependency.done() )
+        {
+            dependency._continuations.push_back( job );
+            return;
+        }
+    }
+
+    _push( threadIndex(), job );
+}
+
+void JobSystem::wait( JobCounter& counter )
+{
+    while ( !counter.done() )
+    {
+        if ( !helpOne() )
+            std::this_thread::yield();
+    }
+}
+
+bool JobSystem::helpOne( JobPriority lowest )
+{
+    size_t index = threadIndex();
+
+    if ( Job* job = _take( index, lowest ) )
+    {
+        _execute( index, job );
+        return true;
+    }
+
+    return false;
+}
+
+JobStats JobSystem::endFrame()
+{
+    Clock::time_point now = Clock::now();
+    long long frameNs = std::chrono::duration_cast< std::chrono::nanoseconds >( now - _frameStart ).count();
+    _frameStart = now;
+
+    long long workerNs = 0;
+    size_t jobsRun = 0;
+
+    for ( size_t i = 0; i < _queues.size(); ++i )
+    {
+        long long busy = _queues[ i ]->busyNs.exchange( 0, std::memory_order_relaxed );
+        jobsRun += _queues[ i ]->jobsRun.exchange( 0, std::memory_order_relaxed );
+
+        // Queue 0 belongs to the threads that wait; they aren't workers.
+        if ( i > 0 )
+            workerNs += busy;
+    }
+
+    JobStats stats;
+    stats.frameMs = frameNs / 1e6;
+    stats.utilisation = _workers.empty() || frameNs <= 0
+        ? 0.0
+        : std::min( 1.0, double( workerNs ) / (double( frameNs ) * _workers.size()) );
+    stats.jobsRun = jobsRun;
+    return stats;
+}
+
+bool JobSystem::_hasQueued() const
+{
+    for ( const auto& queued : _queued )
+        if ( queued.load( std::memory_order_acquire ) > 0 )
+            return true;
+
+    return false;
+}
+
+void JobSystem::_push( size_t index, Job* job )
+{
+    size_t priority = size_t( job->priority );
+
+    {
+        Queue& queue = *_queues[ index ];
+        std::lock_guard< std::mutex > lock( queue.mutex );
+        queue.jobs[ priority ].push_back( job );
+    }
+
+    _queued[ priority ].fetch_add( 1, std::memory_order_release );
+
+    // Sync with workers that are about to sleep so the wake up isn't lost.
+    {
+        std::lock_guard< std::mutex > lock( _sleepMutex );
+    }
+    _wake.notify_one();
+}
+
+JobSystem::Job* JobSystem::_take( size_t index, JobPriority lowest )
+{
+    for ( size_t priority = 0; priority <= size_t( lowest ); ++priority )
+    {
+        if ( _queued[ priority ].load( std::memory_order_acquire ) <= 0 )
+            continue;
+
+        // Newest job from our own queue first; it's likely still in cache.
+        // Otherwise steal the oldest job from someone else.
+        for ( size_t i = 0; i < _queues.size(); ++i )
+        {
+            Queue& queue = *_queues[ (index + i) % _queues.size() ];
+            std::lock_guard< std::mutex > lock( queue.mutex );
+
+            auto& jobs = queue.jobs[ priority ];
+            if ( jobs.empty() )
+                continue;
+
+            Job* job;
+            if ( i == 0 )
+            {
+                job = jobs.back();
+                jobs.pop_back();
+            }
+            else
+            {
+                job = jobs.front();
+                jobs.pop_front();
+            }
+
+            _queued[ priority ].fetch_sub( 1, std::memory_order_relaxed );
+            return job;
+        }
+    }
+
+    return nullptr;
+}
+
+void JobSystem::_execute( size_t index, Job* job )
+{
+    Clock::time_point start = Clock::now();
+
+    job->fn();
+    _finish( job->counter );
+    delete job;
+
+    Queue& queue = *_queues[ index ];
+    queue.busyNs.fetch_add( std::chrono::duration_cast< std::chrono::nanoseconds >( Clock::now() - start ).count(),
+                            std::memory_order_relaxed );
+    queue.jobsRun.fetch_add( 1, std::memory_order_relaxed );
+}
+
+void JobSystem::_finish( JobCounter* counter )
+{
+    if ( !counter )
+        return;
+
+    std::vector< Job* > ready;
+
+    {
+        std::lock_guard< std::mutex > lock( counter->_mutex );
+        if ( counter->_pending.fetch_sub( 1, std::memory_order_acq_rel ) != 1 )
+            return;
+
+        ready.swap( counter->_continuations );
+    }
+
+    // The counter may be destroyed from here on.
+    size_t index = threadIndex();
+    for ( Job* job : ready )
+        _push( index, job );
+}
+
+void JobSystem::_workerMain( size_t index )
+{
+    tls_owner = this;
+    tls_index = index;
+
+    for ( ;; )
+    {
+        if ( Job* job = _take( index ) )
+        {
+            _execute( index, job );
+            continue;
+        }
+
+        std::unique_lock< std::mutex > lock( _sleepMutex );
+        _wake.wait( lock, [this] {
+            return _shutdown || _hasQueued();
+        } );
+
+        if ( _shutdown && !_hasQueued() )
+            return;
+    }
+}
+
+JobSystem& odin::job_system()
+{
+    static JobSystem system;
+    return system;
+}
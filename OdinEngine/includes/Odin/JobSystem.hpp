@@ -0,0 +1,211 @@
+// Andrew Meckling
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace odin
+{
+    class JobSystem;
+
+    // Workers always pick high priority jobs before normal ones. Jobs are
+    // never interrupted; priority only decides which job starts next.
+    enum class JobPriority
+    {
+        HIGH,   // e.g. physics tasks the frame is waiting on.
+        NORMAL, // e.g. cosmetic work like particles.
+        COUNT
+    };
+
+    // Worker activity gathered between two calls to JobSystem::endFrame().
+    struct JobStats
+    {
+        double frameMs;     // Wall time covered by the stats.
+        double utilisation; // Fraction of worker time spent running jobs (0 to 1).
+        size_t jobsRun;     // Jobs run by workers and waiting threads.
+    };
+
+    // Counts the outstanding jobs submitted against it. A counter is done
+    // once every one of those jobs has finished. Jobs submitted with
+    // JobSystem::runAfter are held back until their dependency is done.
+    class JobCounter
+    {
+    public:
+
+        JobCounter() = default;
+
+        JobCounter( const JobCounter& ) = delete;
+        JobCounter& operator =( const JobCounter& ) = delete;
+
+        ~JobCounter()
+        {
+            // Don't let the counter die while a finishing job still holds the lock.
+            std::lock_guard< std::mutex > lock( _mutex );
+        }
+
+        // Returns true if no jobs submitted against the counter are pending.
+        bool done() const
+        {
+            return _pending.load( std::memory_order_acquire ) == 0;
+        }
+
+    private:
+
+        friend class JobSystem;
+
+        struct Job;
+
+        std::atomic< int >  _pending { 0 };
+        std::mutex          _mutex;         // Guards _continuations.
+        std::vector< Job* > _continuations; // Jobs waiting for this counter.
+    };
+
+    // A pool of persistent worker threads, one per additional core.
+    // Every worker owns a deque of jobs; it pops the newest job from its own
+    // deque and steals the oldest job from the other deques when it runs dry.
+    // Threads which are not workers (e.g. the main thread) share one extra
+    // deque. Waiting on a counter executes pending jobs instead of blocking,
+    // so jobs may wait on other jobs. Jobs must not throw.
+    class JobSystem
+    {
+    public:
+
+        // Creates the pool. If threadCount is -1 the pool makes one worker
+        // for every logical core except the calling thread's.
+        explicit JobSystem( int threadCount = -1 );
+
+        JobSystem( const JobSystem& ) = delete;
+        JobSystem& operator =( const JobSystem& ) = delete;
+
+        // Finishes the queued jobs and joins the workers.
+        ~JobSystem();
+
+        // Number of worker threads (not counting the calling thread).
+        int threadCount() const
+        {
+            return int( _workers.size() );
+        }
+
+        // Index of the calling thread: 1 to threadCount() on the workers,
+        // 0 on any other thread.
+        size_t threadIndex() const;
+
+        // Queues a job. The counter, if any, is not done until the job finishes.
+        void run( std::function< void() > fn,
+                  JobCounter*             counter = nullptr,
+                  JobPriority             priority = JobPriority::NORMAL );
+
+        // Queues a job which won't start before the dependency is done.
+        void runAfter( JobCounter&             dependency,
+                       std::function< void() > fn,
+                       JobCounter*             counter = nullptr,
+                       JobPriority             priority = JobPriority::NORMAL );
+
+        // Executes queued jobs on the calling thread until the counter is done.
+        void wait( JobCounter& counter );
+
+        // Executes one queued job of at least the given priority on the
+        // calling thread. Returns false if there was nothing to run.
+        bool helpOne( JobPriority lowest = JobPriority::NORMAL );
+
+        // Returns the activity since the previous call and starts a new frame.
+        JobStats endFrame();
+
+        // Splits the range [0, count) into chunks of at least grain items and
+        // queues a call to fn( first, last ) for every chunk. Returns without
+        // waiting; the counter is done once every chunk has been processed.
+        template< typename Fn >
+        void parallel_for( size_t count, size_t grain, Fn fn, JobCounter& counter,
+                           JobPriority priority = JobPriority::NORMAL )
+        {
+            if ( count == 0 )
+                return;
+
+            grain = std::max< size_t >( grain, 1 );
+
+            // Several chunks per thread leaves some to steal when the
+            // items are of uneven cost.
+            size_t chunks = std::min( (count + grain - 1) / grain,
+                                      size_t( threadCount() + 1 ) * 4 );
+            size_t size = count / chunks;
+            size_t extra = count % chunks;
+            size_t first = 0;
+
+            for ( size_t i = 0; i < chunks; ++i )
+            {
+                size_t last = first + size + (i < extra ? 1 : 0);
+                run( [fn, first, last] { fn( first, last ); }, &counter, priority );
+                first = last;
+            }
+        }
+
+        // Calls fn( first, last ) over chunks of the range [0, count) and
+        // waits for all of them. Small ranges are processed inline.
+        template< typename Fn >
+        void parallel_for( size_t count, size_t grain, Fn&& fn )
+        {
+            if ( count <= grain || threadCount() == 0 )
+            {
+                if ( count > 0 )
+                    fn( size_t( 0 ), count );
+                return;
+            }
+
+            JobCounter counter;
+            parallel_for( count, grain, std::ref( fn ), counter );
+            wait( counter );
+        }
+
+    private:
+
+        using Job = JobCounter::Job;
+        using Clock = std::chrono::steady_clock;
+
+        static constexpr size_t PRIORITY_COUNT = size_t( JobPriority::COUNT );
+
+        // Deques of jobs owned by one thread and stolen from by the rest.
+        struct Queue
+        {
+            std::mutex         mutex;
+            std::deque< Job* > jobs[ PRIORITY_COUNT ];
+
+            std::atomic< long long > busyNs { 0 }; // Time spent running jobs this frame.
+            std::atomic< size_t >    jobsRun { 0 };
+        };
+
+        std::vector< std::unique_ptr< Queue > > _queues; // [0] is shared by non-worker threads.
+        std::vector< std::thread >              _workers;
+
+        std::atomic< int >      _queued[ PRIORITY_COUNT ] = {}; // Jobs sitting in the queues.
+        std::mutex              _sleepMutex;
+        std::condition_variable _wake;
+        bool                    _shutdown = false;
+
+        Clock::time_point       _frameStart = Clock::now();
+
+        bool _hasQueued() const;
+
+        void _push( size_t index, Job* job );
+
+        // Pops from the queue at index, or steals from another queue.
+        Job* _take( size_t index, JobPriority lowest = JobPriority::NORMAL );
+
+        void _execute( size_t index, Job* job );
+
+        void _finish( JobCounter* counter );
+
+        void _workerMain( size_t index );
+    };
+
+    // The process wide job system shared by the engine and game code.
+    JobSystem& job_system();
+
+} // namespace odin
@@ -0,0 +1,65 @@
+// Andrew Meckling
+#include "ParticleBatch.hpp"
+
+#include "glhelp.h"
+
+#include <cstddef>
+
+using namespace odin;
+
+ParticleBatch::ParticleBatch( GLuint program, size_t capacity )
+    : _program( program )
+    , _uMatrix( glGetUniformLocation( program, "uMatrix" ) )
+    , _uTexture( glGetUniformLocation( program, "uTexture" ) )
+    , _uSize( glGetUniformLocation( program, "uSize" ) )
+    , _quad( sizeof( Instance ), capacity )
+{
+    _instances.reserve( capacity );
+
+    const GLuint position = InstancedQuad::FIRST_INSTANCE_ATTRIB;
+    const GLuint color = InstancedQuad::FIRST_INSTANCE_ATTRIB + 1;
+
+    _quad.bind();
+
+    glEnableVertexAttribArray( position );
+    glVertexAttribPointer( position, 2, GL_FLOAT, GL_FALSE, sizeof( Instance ),
+                           (void*) offsetof( Instance, position ) );
+    glVertexAttribDivisor( position, 1 );
+
+    glEnableVertexAttribArray( color );
+    glVertexAttribPointer( color, 4, GL_FLOAT, GL_FALSE, sizeof( Instance ),
+                           (void*) offsetof( Instance, color ) );
+    glVertexAttribDivisor( color, 1 );
+
+    InstancedQuad::unbind();
+}
+
+void ParticleBatch::begin( const glm::mat4& cameraMatrix )
+{
+    _cameraMatrix = cameraMatrix;
+    _instances.clear();
+}
+
+void ParticleBatch::end( int texture, glm::vec2 size )
+{
+    _drawnCount = _instances.size();
+    _drawCalls = 0;
+
+    if ( _instances.empty() )
+        return;
+
+    glUseProgram( _program );
+    glUniform( _uMatrix, _cameraMatrix );
+    glUniform( _uTexture, texture );
+    glUniform( _uSize, size );
+
+    _quad.bind();
+    _quad.upload( _instances );
+
+    _quad.draw( GLsizei( _instances.size() ) );
+    ++_drawCalls;
+
+    InstancedQuad::unbind();
+
+    _instances.clear();
+}
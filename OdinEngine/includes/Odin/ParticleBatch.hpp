@@ -0,0 +1,84 @@
+// Andrew Meckling
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "InstancedQuad.hpp"
+
+namespace odin
+{
+    // Draws particles as small textured quads with a single instanced
+    // draw call. Each instance is only a position and a color; all particles
+    // in a batch share a size and a texture unit. The instance buffer is
+    // orphaned and refilled every frame. The program must follow the
+    // attribute layout of vertexParticle.glsl.
+    class ParticleBatch
+    {
+    public:
+
+        // Per-instance vertex data. Matches attribute locations 2 and 3.
+        struct Instance
+        {
+            glm::vec2 position;
+            glm::vec4 color;
+        };
+
+        explicit ParticleBatch( GLuint program, size_t capacity = 1024 );
+
+        ParticleBatch( const ParticleBatch& ) = delete;
+        ParticleBatch& operator =( const ParticleBatch& ) = delete;
+
+        // Starts a new batch. Discards any particles that were not drawn.
+        void begin( const glm::mat4& cameraMatrix );
+
+        // Queues a particle.
+        void add( glm::vec2 position, const glm::vec4& color )
+        {
+            _instances.push_back( { position, color } );
+        }
+
+        // Queues n particles and returns a pointer to the first one so
+        // the caller can fill them in directly.
+        Instance* append( size_t n )
+        {
+            size_t first = _instances.size();
+            _instances.resize( first + n );
+            return _instances.data() + first;
+        }
+
+        // Uploads the queued particles and draws them with one draw call.
+        void end( int texture, glm::vec2 size = { 1, 1 } );
+
+        // Number of particles drawn by the last call to end().
+        size_t count() const
+        {
+            return _drawnCount;
+        }
+
+        // Number of draw calls issued by the last call to end().
+        size_t drawCalls() const
+        {
+            return _drawCalls;
+        }
+
+    private:
+
+        GLuint _program;
+        GLint  _uMatrix;
+        GLint  _uTexture;
+        GLint  _uSize;
+
+        InstancedQuad _quad;
+
+        glm::mat4 _cameraMatrix;
+
+        std::vector< Instance > _instances;
+
+        size_t _drawnCount = 0;
+        size_t _drawCalls = 0;
+    };
+
+} // namespace odin
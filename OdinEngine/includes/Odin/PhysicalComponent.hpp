@@ -2,11 +2,68 @@
 
 #include <Box2D/Box2D.h>
 
+#include <cassert>
+#include <cstdint>
+
 #include "Math.hpp"
+#include "Registry.hpp"
 
 namespace odin
 {
 
+    // Bodies carry the handle of their entity as user data: the index
+    // plus one, so that null still means the body has no entity, in the
+    // low bits and the generation in the high bits. 32 bit pointers only
+    // have room for 24 bits of index and the low 8 bits of generation.
+    static constexpr unsigned BODY_INDEX_BITS = sizeof( std::uintptr_t ) >= 8 ? 32 : 24;
+    static constexpr std::uintptr_t BODY_INDEX_MASK = (std::uintptr_t( 1 ) << BODY_INDEX_BITS) - 1;
+    static constexpr std::uint32_t BODY_GENERATION_MASK = std::uint32_t( ~std::uintptr_t( 0 ) >> BODY_INDEX_BITS );
+
+    inline void* body_user_data( Handle h )
+    {
+        assert( std::uintptr_t( h.index ) < BODY_INDEX_MASK );
+        return (void*) ((std::uintptr_t( h.generation & BODY_GENERATION_MASK ) << BODY_INDEX_BITS)
+                        | (std::uintptr_t( h.index ) + 1));
+    }
+
+    // Returns the handle of a body's entity, or a null handle if the body
+    // has no entity or its entity was destroyed, even if another entity
+    // has since reused the index. The body's user data must come from
+    // body_user_data and the registry which made the handle.
+    inline Handle body_entity( const b2Body* body, const Registry& registry )
+    {
+        std::uintptr_t data = std::uintptr_t( body->GetUserData() );
+        if ( data == 0 )
+            return {};
+
+        Handle current = registry.handle( EntityIndex( (data & BODY_INDEX_MASK) - 1 ) );
+        bool same = (current.generation & BODY_GENERATION_MASK) == std::uint32_t( data >> BODY_INDEX_BITS );
+        return same ? current : Handle {};
+    }
+
+    // Keeps the closest fixture a ray hits further along it than
+    // minFraction. Each hit clips the ray, so only closer fixtures are
+    // tested from then on.
+    struct ClosestRayHit
+        : b2RayCastCallback
+    {
+        float32    minFraction = 0;
+        b2Fixture* fixture = nullptr;
+        b2Vec2     normal = { 0, 0 };
+        float32    fraction = 1; // The end of the ray if nothing was hit.
+
+        float32 ReportFixture( b2Fixture* f, const b2Vec2&, const b2Vec2& n, float32 frac ) override
+        {
+            if ( frac <= minFraction )
+                return -1;
+
+            fixture = f;
+            normal = n;
+            fraction = frac;
+            return frac;
+        }
+    };
+
     inline b2Vec2 getShapePosition( const b2Shape* shape )
     {
         if ( shape->m_type == b2Shape::e_circle )
@@ -0,0 +1,100 @@
+// Andrew Meckling
+#include "PhysicsExecutor.hpp"
+
+#include <thread>
+
+using namespace odin;
+
+namespace
+{
+    // The allocator of the task group the calling thread is waiting on.
+    thread_local b2StackAllocator* tls_waitAllocator = nullptr;
+}
+
+PhysicsExecutor::PhysicsExecutor( JobSystem& jobs )
+    : _jobs( jobs )
+    , _threadCount( b2Min( jobs.threadCount(), b2_maxThreadPoolThreads ) )
+    , _freeIds( (1u << _threadCount) - 1 )
+    , _allocators( new b2StackAllocator[ b2Max( _threadCount, 1 ) ] )
+{
+}
+
+int32 PhysicsExecutor::GetThreadCount() const
+{
+    return _threadCount;
+}
+
+void PhysicsExecutor::AddTasks( b2Task** tasks, int32 count )
+{
+    for ( int32 i = 0; i < count; ++i )
+    {
+        b2Task* task = tasks[ i ];
+        _jobs.run( [this, task] { _execute( task ); }, nullptr, JobPriority::HIGH );
+    }
+}
+
+void PhysicsExecutor::Wait( const b2TaskGroup& taskGroup, b2StackAllocator& allocator )
+{
+    b2StackAllocator* prevAllocator = tls_waitAllocator;
+    tls_waitAllocator = &allocator;
+
+    // Help with other physics tasks instead of sleeping; the step is on
+    // the critical path, so don't get caught up in cosmetic work.
+    while ( !IsFinished( taskGroup ) )
+    {
+        if ( !_jobs.helpOne( JobPriority::HIGH ) )
+            std::this_thread::yield();
+    }
+
+    tls_waitAllocator = prevAllocator;
+}
+
+void PhysicsExecutor::_execute( b2Task* task )
+{
+    // A waiting thread already has a thread id (0 if it's stepping the
+    // world), so it runs tasks with that id and the allocator it waits
+    // with, like b2ThreadPool does. Tasks which wait on their own tasks
+    // (e.g. large islands) would otherwise hold every id and deadlock.
+    if ( tls_waitAllocator )
+    {
+        ExecuteTask( task, *tls_waitAllocator );
+        return;
+    }
+
+    // Claim a free thread id. There are never fewer ids than workers
+    // unless the job system has more workers than Box2D supports, in
+    // which case the extra workers wait for a task to finish.
+    uint32 ids = _freeIds.load( std::memory_order_relaxed );
+    int32 id;
+
+    for ( ;; )
+    {
+        if ( ids == 0 )
+        {
+            std::this_thread::yield();
+            ids = _freeIds.load( std::memory_order_relaxed );
+            continue;
+        }
+
+        id = 0;
+        while ( !(ids & (1u << id)) )
+            ++id;
+
+        if ( _freeIds.compare_exchange_weak( ids, ids & ~(1u << id), std::memory_order_acquire ) )
+            break;
+    }
+
+    int32 prevThreadId = b2GetThreadId();
+    b2SetThreadId( id + 1 );
+
+    ExecuteTask( task, _allocators[ id ] );
+
+    b2SetThreadId( prevThreadId );
+    _freeIds.fetch_or( 1u << id, std::memory_order_release );
+}
+
+PhysicsExecutor& odin::physics_executor()
+{
+    static PhysicsExecutor executor( job_system() );
+    return executor;
+}
@@ -0,0 +1,53 @@
+// Andrew Meckling
+#pragma once
+
+#include <Box2D/Box2D.h>
+
+#include <atomic>
+#include <memory>
+
+#include "JobSystem.hpp"
+
+namespace odin
+{
+    // Runs Box2D's tasks on a JobSystem so physics and game jobs share one
+    // set of workers. Tasks are queued at high priority so they start
+    // before any pending cosmetic work.
+    // Box2D indexes its per thread data with b2GetThreadId, so each task
+    // borrows one of b2_maxThreadPoolThreads thread ids (and the stack
+    // allocator that goes with it) for as long as it executes. Tasks run
+    // by a thread that is waiting on a task group keep the waiting
+    // thread's id instead.
+    class PhysicsExecutor
+        : public b2TaskExecutor
+    {
+    public:
+
+        explicit PhysicsExecutor( JobSystem& jobs );
+
+        PhysicsExecutor( const PhysicsExecutor& ) = delete;
+        PhysicsExecutor& operator =( const PhysicsExecutor& ) = delete;
+
+        int32 GetThreadCount() const;
+
+    protected:
+
+        void AddTasks( b2Task** tasks, int32 count );
+
+        void Wait( const b2TaskGroup& taskGroup, b2StackAllocator& allocator );
+
+    private:
+
+        JobSystem& _jobs;
+        int32      _threadCount;
+
+        std::atomic< uint32 >                 _freeIds;    // Bit i is set if thread id i + 1 is free.
+        std::unique_ptr< b2StackAllocator[] > _allocators; // One per thread id.
+
+        void _execute( b2Task* task );
+    };
+
+    // The executor for odin::job_system(). Pass it to every b2World.
+    PhysicsExecutor& physics_executor();
+
+} // namespace odin
@@ -0,0 +1,561 @@
+// Andrew Meckling
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace odin
+{
+    // Identifies an entity in a Registry. Indices of destroyed entities
+    // are reused by later entities.
+    using EntityIndex = std::uint32_t;
+
+    static constexpr EntityIndex NULL_ENTITY = std::numeric_limits< EntityIndex >::max();
+
+    // Refers to one entity of a Registry for as long as it lives.
+    // The generation counts how many times the index has been destroyed,
+    // so a handle to a destroyed entity never matches the entity which
+    // reuses its index. Resolving a handle is an array lookup.
+    struct Handle
+    {
+        EntityIndex   index = NULL_ENTITY;
+        std::uint32_t generation = 0;
+    };
+
+    inline bool operator ==( const Handle& lhs, const Handle& rhs )
+    {
+        return lhs.index == rhs.index && lhs.generation == rhs.generation;
+    }
+
+    inline bool operator !=( const Handle& lhs, const Handle& rhs )
+    {
+        return !(lhs == rhs);
+    }
+
+    template< typename... Components >
+    class Archetype;
+
+    // Returns a small unique number for every component type, starting at 0.
+    inline size_t _nextComponentIndex()
+    {
+        // Types can be first seen on several job threads at once.
+        static std::atomic< size_t > next { 0 };
+        return next.fetch_add( 1 );
+    }
+
+    template< typename T >
+    size_t component_index()
+    {
+        static const size_t index = _nextComponentIndex();
+        return index;
+    }
+
+    // The set of entities which own a component of one type.
+    // The sparse array maps an entity to its slot in the dense array,
+    // and the dense array lists every entity in the set without gaps.
+    // Lookups, insertions and removals are O(1) and iterating the set
+    // never touches entities outside of it.
+    class SparseSet
+    {
+    public:
+
+        static constexpr std::uint32_t NO_SLOT = std::numeric_limits< std::uint32_t >::max();
+
+        virtual ~SparseSet() = default;
+
+        // Removes the entity (and its component) from the set.
+        // Returns true if the entity was in the set.
+        virtual bool remove( EntityIndex e ) = 0;
+
+        // Returns the number of entities in the set.
+        size_t size() const
+        {
+            return _dense.size();
+        }
+
+        bool empty() const
+        {
+            return _dense.empty();
+        }
+
+        bool contains( EntityIndex e ) const
+        {
+            return e < _sparse.size() && _sparse[ e ] != NO_SLOT;
+        }
+
+        // Returns the slot in the dense array holding the entity.
+        std::uint32_t slot( EntityIndex e ) const
+        {
+            return contains( e ) ? _sparse[ e ] : NO_SLOT;
+        }
+
+        // Returns the packed array of entities in the set.
+        const EntityIndex* entities() const
+        {
+            return _dense.data();
+        }
+
+    protected:
+
+        std::vector< std::uint32_t > _sparse; // Entity -> slot in _dense, or NO_SLOT.
+        std::vector< EntityIndex >   _dense;  // Slot -> entity.
+
+        // Adds the entity to the end of the dense array. Returns its slot.
+        std::uint32_t _push( EntityIndex e )
+        {
+            if ( e >= _sparse.size() )
+                _sparse.resize( e + 1, std::uint32_t( NO_SLOT ) );
+
+            _sparse[ e ] = std::uint32_t( _dense.size() );
+            _dense.push_back( e );
+            return _sparse[ e ];
+        }
+
+        // Moves the last entity into the slot of the removed entity.
+        void _pop( std::uint32_t slot )
+        {
+            EntityIndex last = _dense.back();
+            _sparse[ last ] = slot;
+            _sparse[ _dense[ slot ] ] = NO_SLOT;
+            _dense[ slot ] = last;
+            _dense.pop_back();
+        }
+
+        void _swap( std::uint32_t a, std::uint32_t b )
+        {
+            std::swap( _dense[ a ], _dense[ b ] );
+            _sparse[ _dense[ a ] ] = a;
+            _sparse[ _dense[ b ] ] = b;
+        }
+    };
+
+    // A sparse set which keeps the components of its entities packed in
+    // the same order as the entities themselves. Removing a component
+    // moves the last component into its slot, so the order isn't stable
+    // and pointers to components are invalidated by adds and removes.
+    template< typename T >
+    class ComponentPool
+        : public SparseSet
+    {
+    public:
+
+        using Type = T;
+
+        // Adds a component to the entity, or replaces the one it has.
+        template< typename... Args >
+        T& emplace( EntityIndex e, Args&&... args )
+        {
+            if ( T* existing = find( e ) )
+                return *existing = T( std::forward< Args >( args )... );
+
+            _push( e );
+            _components.emplace_back( std::forward< Args >( args )... );
+            return _components.back();
+        }
+
+        bool remove( EntityIndex e ) override
+        {
+            if ( !contains( e ) )
+                return false;
+
+            std::uint32_t slot = _sparse[ e ];
+            if ( slot != _components.size() - 1 )
+                _components[ slot ] = std::move( _components.back() );
+
+            _components.pop_back();
+            _pop( slot );
+            return true;
+        }
+
+        // Returns the entity's component, or nullptr if it has none.
+        T* find( EntityIndex e )
+        {
+            return contains( e ) ? &_components[ _sparse[ e ] ] : nullptr;
+        }
+
+        const T* find( EntityIndex e ) const
+        {
+            return contains( e ) ? &_components[ _sparse[ e ] ] : nullptr;
+        }
+
+        // Returns the entity's component. The entity must have one.
+        T& get( EntityIndex e )
+        {
+            return _components[ _sparse[ e ] ];
+        }
+
+        const T& get( EntityIndex e ) const
+        {
+            return _components[ _sparse[ e ] ];
+        }
+
+        // Returns the packed array of components; data()[ i ] belongs
+        // to entities()[ i ].
+        T* data()
+        {
+            return _components.data();
+        }
+
+        const T* data() const
+        {
+            return _components.data();
+        }
+
+        void reserve( size_t n )
+        {
+            _dense.reserve( n );
+            _components.reserve( n );
+        }
+
+        // Orders the entities and their components with an insertion sort.
+        // less( a, b ) compares two entities. Meant to be called every frame
+        // to keep an order that rarely changes; an already sorted pool is
+        // checked in a single pass.
+        template< typename Compare >
+        void sort( Compare less )
+        {
+            for ( std::uint32_t i = 1; i < _dense.size(); ++i )
+            {
+                for ( std::uint32_t j = i; j > 0 && less( _dense[ j ], _dense[ j - 1 ] ); --j )
+                {
+                    std::swap( _components[ j ], _components[ j - 1 ] );
+                    _swap( j, j - 1 );
+                }
+            }
+        }
+
+    private:
+
+        std::vector< T > _components;
+    };
+
+    class Registry;
+
+    // Refers to an entity's component by looking it up in the pool on
+    // every access. Unlike a pointer, it stays valid while components
+    // are added to and removed from the pool. It holds the entity's
+    // handle, so once the entity is destroyed it finds nothing, even
+    // after another entity reuses the index.
+    template< typename T >
+    class ComponentRef
+    {
+    public:
+
+        ComponentRef() = default;
+
+        ComponentRef( ComponentPool< T >& pool, const Registry& registry, Handle h )
+            : _pool( &pool )
+            , _registry( &registry )
+            , _handle( h )
+        {
+        }
+
+        EntityIndex entity() const
+        {
+            return _handle.index;
+        }
+
+        Handle handle() const
+        {
+            return _handle;
+        }
+
+        // Returns the component, or nullptr if the entity lost it or
+        // was destroyed.
+        T* get() const;
+
+        T* operator ->() const
+        {
+            return get();
+        }
+
+        T& operator *() const
+        {
+            return *get();
+        }
+
+        explicit operator bool() const
+        {
+            return get() != nullptr;
+        }
+
+    private:
+
+        ComponentPool< T >* _pool = nullptr;
+        const Registry*     _registry = nullptr;
+        Handle              _handle;
+    };
+
+    // Iterates the entities which have every one of the component types.
+    // The pool of the first type leads the iteration: its packed order is
+    // the order entities are visited in and the other pools are only
+    // queried, so list the rarest component first.
+    // Components of the viewed types must not be added or removed while
+    // iterating.
+    template< typename Lead, typename... Others >
+    class View
+    {
+    public:
+
+        View( ComponentPool< Lead >& lead, ComponentPool< Others >&... others )
+            : _lead( lead )
+            , _others( others... )
+        {
+        }
+
+        // Calls fn( entity, lead, others... ) for every entity in the view.
+        template< typename Fn >
+        void each( Fn&& fn )
+        {
+            _each( fn, std::index_sequence_for< Others... >{} );
+        }
+
+    private:
+
+        ComponentPool< Lead >&                       _lead;
+        std::tuple< ComponentPool< Others >&... >    _others;
+
+        template< typename Fn, size_t... I >
+        void _each( Fn& fn, std::index_sequence< I... > )
+        {
+            const EntityIndex* ents = _lead.entities();
+            Lead* comps = _lead.data();
+
+            for ( size_t i = 0; i < _lead.size(); ++i )
+            {
+                EntityIndex e = ents[ i ];
+
+                bool hasAll = true;
+                using expand = bool[];
+                (void) expand { true, (hasAll = hasAll && std::get< I >( _others ).contains( e ))... };
+
+                if ( hasAll )
+                    fn( e, comps[ i ], std::get< I >( _others ).get( e )... );
+            }
+        }
+    };
+
+    // Owns the entities of a scene and one ComponentPool per component type.
+    // Entities whose components are always used together can instead be
+    // stored as rows of an Archetype; the pool functions don't see those
+    // components, but destroy() removes the rows too.
+    // Entities are handed out as Handles. Functions taking a Handle check
+    // it against the entity's generation, in release builds too; those
+    // taking an EntityIndex (e.g. from a view) assume it's alive.
+    class Registry
+    {
+    public:
+
+        Registry() = default;
+
+        Registry( const Registry& ) = delete;
+        Registry& operator =( const Registry& ) = delete;
+
+        // Returns a new entity without any components.
+        Handle create()
+        {
+            EntityIndex e;
+            if ( !_free.empty() )
+            {
+                e = _free.back();
+                _free.pop_back();
+            }
+            else
+            {
+                e = _next++;
+                _generations.push_back( 0 );
+            }
+
+            return { e, _generations[ e ] };
+        }
+
+        // Returns true if the handle refers to a live entity.
+        bool valid( Handle h ) const
+        {
+            return h.index < _generations.size()
+                && _generations[ h.index ] == h.generation;
+        }
+
+        // Returns the handle of a live entity.
+        Handle handle( EntityIndex e ) const
+        {
+            return { e, _generations[ e ] };
+        }
+
+        // Removes every component of the entity and frees its index.
+        // Handles to the entity become stale. Returns false (and does
+        // nothing) if the handle already was.
+        bool destroy( Handle h )
+        {
+            if ( !valid( h ) )
+                return false;
+
+            for ( auto& pool : _pools )
+                if ( pool )
+                    pool->remove( h.index );
+
+            ++_generations[ h.index ];
+            _free.push_back( h.index );
+            return true;
+        }
+
+        // Returns the number of live entities.
+        size_t count() const
+        {
+            return _next - _free.size();
+        }
+
+        // Returns the pool holding every component of the given type.
+        // Creating a pool isn't thread safe; fetch pools before handing
+        // them to jobs.
+        template< typename T >
+        ComponentPool< T >& pool()
+        {
+            return _storage< ComponentPool< T > >();
+        }
+
+        // Returns the chunked storage of the entities which have exactly
+        // the listed components. Include Archetype.hpp to use it.
+        template< typename... Components >
+        Archetype< Components... >& archetype()
+        {
+            return _storage< Archetype< Components... > >();
+        }
+
+        template< typename T, typename... Args >
+        T& emplace( EntityIndex e, Args&&... args )
+        {
+            return pool< T >().emplace( e, std::forward< Args >( args )... );
+        }
+
+        template< typename T >
+        bool remove( EntityIndex e )
+        {
+            return pool< T >().remove( e );
+        }
+
+        template< typename T, typename... Args >
+        T& emplace( Handle h, Args&&... args )
+        {
+            return emplace< T >( _checked( h ), std::forward< Args >( args )... );
+        }
+
+        template< typename T >
+        bool remove( Handle h )
+        {
+            return valid( h ) && remove< T >( h.index );
+        }
+
+        template< typename T >
+        bool has( EntityIndex e )
+        {
+            return pool< T >().contains( e );
+        }
+
+        template< typename T >
+        bool has( Handle h )
+        {
+            return valid( h ) && has< T >( h.index );
+        }
+
+        template< typename T >
+        T* find( EntityIndex e )
+        {
+            return pool< T >().find( e );
+        }
+
+        // Returns nullptr if the handle is stale or the entity has no
+        // component of the type.
+        template< typename T >
+        T* find( Handle h )
+        {
+            return valid( h ) ? find< T >( h.index ) : nullptr;
+        }
+
+        template< typename T >
+        T& get( EntityIndex e )
+        {
+            return pool< T >().get( e );
+        }
+
+        template< typename T >
+        T& get( Handle h )
+        {
+            return get< T >( _checked( h ) );
+        }
+
+        template< typename T >
+        ComponentRef< T > ref( EntityIndex e )
+        {
+            return ComponentRef< T >( pool< T >(), *this, handle( e ) );
+        }
+
+        template< typename T >
+        ComponentRef< T > ref( Handle h )
+        {
+            _checked( h );
+            return ComponentRef< T >( pool< T >(), *this, h );
+        }
+
+        template< typename Lead, typename... Others >
+        View< Lead, Others... > view()
+        {
+            return View< Lead, Others... >( pool< Lead >(), pool< Others >()... );
+        }
+
+        // Removes every entity and component.
+        void clear()
+        {
+            // Keep the generations so handles from before stay stale.
+            _pools.clear();
+            _free.clear();
+            for ( EntityIndex e = _next; e-- > 0; )
+            {
+                ++_generations[ e ];
+                _free.push_back( e );
+            }
+        }
+
+    private:
+
+        std::vector< std::unique_ptr< SparseSet > > _pools;       // Indexed by component_index of the storage.
+        std::vector< std::uint32_t >                _generations; // Entity -> times destroyed.
+        std::vector< EntityIndex >                  _free;        // Indices of destroyed entities.
+        EntityIndex                                 _next = 0;
+
+        // Pools and archetypes are both keyed by their own type.
+        template< typename Storage >
+        Storage& _storage()
+        {
+            size_t index = component_index< Storage >();
+
+            if ( index >= _pools.size() )
+                _pools.resize( index + 1 );
+
+            if ( !_pools[ index ] )
+                _pools[ index ].reset( new Storage );
+
+            return static_cast< Storage& >( *_pools[ index ] );
+        }
+
+        EntityIndex _checked( Handle h ) const
+        {
+            if ( !valid( h ) )
+                throw "stale entity handle";
+
+            return h.index;
+        }
+    };
+
+    template< typename T >
+    T* ComponentRef< T >::get() const
+    {
+        return _pool && _registry->valid( _handle ) ? _pool->find( _handle.index ) : nullptr;
+    }
+
+} // namespace odin
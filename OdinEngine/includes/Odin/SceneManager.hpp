@@ -3,6 +3,9 @@
 #include "Scene.h"
 #include "AudioEngine.h"
 
+#include <utility>
+#include <vector>
+
 namespace odin
 {
 	class SceneManager
@@ -79,15 +82,19 @@ namespace odin
             //    else
             //        break;
 
-            std::vector< Scene* > tmpPendingScenes = pendingScenes;
-            pendingScenes.clear();
+            // Scenes pushed while these are applied wait for the next
+            // update. Swapping keeps both vectors' memory, so this doesn't
+            // allocate once they've grown.
+            std::swap( pendingScenes, _applyingScenes );
 
-            for ( Scene* scene : tmpPendingScenes )
+            for ( Scene* scene : _applyingScenes )
                 if ( scene == nullptr )
                     _popScene( ticks );
                 else
                     _pushScene( scene, ticks );
 
+            _applyingScenes.clear();
+
             Scene* top;
             while ( (top = topScene()) && top->expired )
                 _popScene( ticks );
@@ -110,6 +117,10 @@ namespace odin
                 delete s;*/
 		}
 
+    private:
+
+        std::vector< Scene* > _applyingScenes; // Pending scenes being applied by update.
+
 	};
 
 }
\ No newline at end of file
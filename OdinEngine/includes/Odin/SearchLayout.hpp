@@ -0,0 +1,269 @@
+// Andrew Meckling
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include <xmmintrin.h>
+
+// MSVC has no macro for SSE4.2; it's implied by /arch:AVX.
+#if defined( __AVX2__ )
+    #define ODIN_KEY_SCAN_AVX2
+    #include <immintrin.h>
+#elif defined( __SSE4_2__ ) || defined( __AVX__ )
+    #define ODIN_KEY_SCAN_SSE42
+    #include <nmmintrin.h>
+#endif
+
+namespace odin
+{
+    union EntityId;
+
+    // Describes keys which order like 64 bit integers, so they can be
+    // compared several at a time with SIMD. Keys are xor'ed with FLIP
+    // before a signed compare, which turns it into an unsigned one.
+    template< typename KeyType, typename = void >
+    struct ScanKey
+    {
+        static constexpr bool ENABLED = false;
+    };
+
+    template< typename KeyType >
+    struct ScanKey< KeyType, std::enable_if_t< std::is_integral< KeyType >::value && sizeof( KeyType ) == 8 > >
+    {
+        static constexpr bool          ENABLED = true;
+        static constexpr std::uint64_t FLIP = std::is_signed< KeyType >::value ? 0 : 1ull << 63;
+    };
+
+    // EntityIds order on their bit pattern.
+    template<>
+    struct ScanKey< EntityId >
+    {
+        static constexpr bool          ENABLED = true;
+        static constexpr std::uint64_t FLIP = 1ull << 63;
+    };
+
+    // Counts the keys less than key, one at a time, without branching
+    // on the comparison.
+    template< typename KeyType >
+    size_t _scanLowerBound( const KeyType* keys, size_t count, const KeyType& key, std::false_type )
+    {
+        size_t n = 0;
+        for ( size_t i = 0; i < count; ++i )
+            n += size_t( keys[ i ] < key );
+
+        return n;
+    }
+
+    // Compares four (AVX2) or two (SSE4.2) keys per instruction. Every
+    // key is compared; an early exit costs more in mispredicted branches
+    // than it saves on arrays this small.
+    template< typename KeyType >
+    size_t _scanLowerBound( const KeyType* keys, size_t count, const KeyType& key, std::true_type )
+    {
+        size_t i = 0;
+        size_t n = 0;
+
+    #if defined( ODIN_KEY_SCAN_AVX2 ) || defined( ODIN_KEY_SCAN_SSE42 )
+        std::uint64_t bits;
+        std::memcpy( &bits, &key, sizeof bits );
+        bits ^= ScanKey< KeyType >::FLIP;
+    #endif
+
+        // A true compare is all ones (-1), so subtracting it counts.
+    #if defined( ODIN_KEY_SCAN_AVX2 )
+        const __m256i flip = _mm256_set1_epi64x( (long long) ScanKey< KeyType >::FLIP );
+        const __m256i needle = _mm256_set1_epi64x( (long long) bits );
+        __m256i less = _mm256_setzero_si256();
+
+        for ( ; i + 4 <= count; i += 4 )
+        {
+            __m256i block = _mm256_xor_si256( _mm256_loadu_si256( (const __m256i*) (keys + i) ), flip );
+            less = _mm256_sub_epi64( less, _mm256_cmpgt_epi64( needle, block ) );
+        }
+
+        std::uint64_t lanes[ 4 ];
+        _mm256_storeu_si256( (__m256i*) lanes, less );
+        n = size_t( lanes[ 0 ] + lanes[ 1 ] + lanes[ 2 ] + lanes[ 3 ] );
+    #elif defined( ODIN_KEY_SCAN_SSE42 )
+        const __m128i flip = _mm_set1_epi64x( (long long) ScanKey< KeyType >::FLIP );
+        const __m128i needle = _mm_set1_epi64x( (long long) bits );
+        __m128i less = _mm_setzero_si128();
+
+        for ( ; i + 2 <= count; i += 2 )
+        {
+            __m128i block = _mm_xor_si128( _mm_loadu_si128( (const __m128i*) (keys + i) ), flip );
+            less = _mm_sub_epi64( less, _mm_cmpgt_epi64( needle, block ) );
+        }
+
+        std::uint64_t lanes[ 2 ];
+        _mm_storeu_si128( (__m128i*) lanes, less );
+        n = size_t( lanes[ 0 ] + lanes[ 1 ] );
+    #endif
+
+        return n + _scanLowerBound( keys + i, count - i, key, std::false_type {} );
+    }
+
+    // Up to this many keys a scan is faster than a binary search. Measured
+    // on 8 byte keys; the crossover is around 96 keys without AVX2 and
+    // past 128 keys with it.
+    #if defined( ODIN_KEY_SCAN_AVX2 )
+    static constexpr size_t KEY_SCAN_MAX = 128;
+    #else
+    static constexpr size_t KEY_SCAN_MAX = 64;
+    #endif
+
+    // Returns the position of the first of the sorted keys which is not
+    // less than key, by comparing key to every one of them. Beats a
+    // binary search on small arrays, since it never mispredicts a branch.
+    template< typename KeyType >
+    size_t scan_lower_bound( const KeyType* keys, size_t count, const KeyType& key )
+    {
+        return _scanLowerBound( keys, count, key,
+            std::integral_constant< bool, ScanKey< KeyType >::ENABLED > {} );
+    }
+    // Layout policies decide how BinarySearchMap finds a key in its
+    // sorted array of keys. A layout may keep an index on the side, but
+    // the map's own keys and values always stay sorted, so iteration
+    // order doesn't depend on the layout.
+    //
+    // A layout provides:
+    //     void   invalidate();   // The keys changed; drop the index.
+    //     void   swap( Layout& );
+    //     size_t lower_bound( const KeyType* keys, size_t count, const KeyType& key );
+    //     size_t lower_bound( const KeyType* keys, size_t count, const KeyType& key ) const;
+    // where lower_bound returns the position of the first key which is
+    // not less than key (count if there is none).
+
+    // Searches the sorted keys directly. Keeps no index.
+    // Maps of up to KEY_SCAN_MAX keys are scanned rather than binary searched.
+    template< typename KeyType >
+    class SortedLayout
+    {
+    public:
+
+        void invalidate()
+        {
+        }
+
+        void swap( SortedLayout& )
+        {
+        }
+
+        size_t lower_bound( const KeyType* keys, size_t count, const KeyType& key ) const
+        {
+            if ( count <= KEY_SCAN_MAX )
+                return scan_lower_bound( keys, count, key );
+
+            return std::lower_bound( keys, keys + count, key ) - keys;
+        }
+    };
+
+    // Keeps a copy of the keys in Eytzinger (breadth first) order: the
+    // children of node k are 2k and 2k + 1. A search walks down the
+    // array without branching on the comparison, and the nodes it visits
+    // a few levels ahead share cache lines, so they're prefetched.
+    // Lookups in large maps touch far fewer cache lines than a binary
+    // search does. The index is rebuilt in O(n) by the first non-const
+    // search after the keys change; until then const searches fall back
+    // to a binary search, so concurrent readers never write. Maps small
+    // enough to scan never build the index.
+    template< typename KeyType >
+    class EytzingerLayout
+    {
+    public:
+
+        void invalidate()
+        {
+            _built = false;
+        }
+
+        void swap( EytzingerLayout& other )
+        {
+            _tree.swap( other._tree );
+            _rank.swap( other._rank );
+            std::swap( _built, other._built );
+        }
+
+        size_t lower_bound( const KeyType* keys, size_t count, const KeyType& key )
+        {
+            if ( count <= KEY_SCAN_MAX )
+                return scan_lower_bound( keys, count, key );
+
+            if ( !_built )
+                _build( keys, count );
+
+            return _search( count, key );
+        }
+
+        size_t lower_bound( const KeyType* keys, size_t count, const KeyType& key ) const
+        {
+            if ( count <= KEY_SCAN_MAX )
+                return scan_lower_bound( keys, count, key );
+
+            if ( !_built )
+                return std::lower_bound( keys, keys + count, key ) - keys;
+
+            return _search( count, key );
+        }
+
+    private:
+
+        // Nodes per cache line. The descendants of k, log2( LINE_NODES )
+        // levels down, start at node k * LINE_NODES, so prefetching it
+        // fetches them: three levels down for 8 byte keys.
+        static constexpr size_t LINE_NODES = 64 / sizeof( KeyType ) > 0 ? 64 / sizeof( KeyType ) : 1;
+
+        std::vector< KeyType >       _tree; // 1-based; _tree[ 0 ] is unused.
+        std::vector< std::uint32_t > _rank; // Node -> position in the sorted keys.
+        bool                         _built = false;
+
+        void _build( const KeyType* keys, size_t count )
+        {
+            _tree.resize( count + 1 );
+            _rank.resize( count + 1 );
+
+            size_t i = 0;
+            _fill( keys, count, i, 1 );
+            _built = true;
+        }
+
+        // An in-order walk of the implicit tree visits the keys in order.
+        void _fill( const KeyType* keys, size_t count, size_t& i, size_t k )
+        {
+            if ( k > count )
+                return;
+
+            _fill( keys, count, i, 2 * k );
+            _tree[ k ] = keys[ i ];
+            _rank[ k ] = std::uint32_t( i++ );
+            _fill( keys, count, i, 2 * k + 1 );
+        }
+
+        size_t _search( size_t count, const KeyType& key ) const
+        {
+            const KeyType* tree = _tree.data();
+
+            size_t k = 1;
+            while ( k <= count )
+            {
+                // The last levels' descendants are past the end of the
+                // tree; even forming a pointer to them is undefined.
+                _mm_prefetch( (const char*) (tree + std::min( k * LINE_NODES, count )), _MM_HINT_T0 );
+                k = 2 * k + size_t( tree[ k ] < key );
+            }
+
+            // The lower bound is the last node the walk went left at; every
+            // step after it went right. Undo those steps and the left one.
+            while ( k & 1 )
+                k >>= 1;
+            k >>= 1;
+
+            return k == 0 ? count : _rank[ k ];
+        }
+    };
+
+} // namespace odin
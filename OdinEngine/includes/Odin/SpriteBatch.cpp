@@ -0,0 +1,103 @@
+// Andrew Meckling
+#include "SpriteBatch.hpp"
+
+#include "glhelp.h"
+
+using namespace odin;
+
+SpriteBatch::SpriteBatch( GLuint program, size_t capacity )
+    : _program( program )
+    , _uMatrix( glGetUniformLocation( program, "uMatrix" ) )
+    , _uTexture( glGetUniformLocation( program, "uTexture" ) )
+    , _quad( sizeof( Instance ), capacity )
+{
+    _instances.reserve( capacity );
+
+    _quad.bind();
+    for ( GLuint i = 0; i < 4; ++i )
+    {
+        glEnableVertexAttribArray( InstancedQuad::FIRST_INSTANCE_ATTRIB + i );
+        glVertexAttribDivisor( InstancedQuad::FIRST_INSTANCE_ATTRIB + i, 1 );
+    }
+    _bindInstances( 0 );
+    InstancedQuad::unbind();
+}
+
+void SpriteBatch::begin( const glm::mat4& cameraMatrix )
+{
+    _cameraMatrix = cameraMatrix;
+    _instances.clear();
+    _runs.clear();
+}
+
+void SpriteBatch::add( const GraphicalComponent& gfx,
+                       const AnimatorComponent*  anim,
+                       glm::vec2                 position,
+                       float                     rotation,
+                       const glm::vec4&          color )
+{
+    if ( !gfx.visible )
+        return;
+
+    Instance inst;
+    inst.transform = glm::vec4( position, rotation, float( gfx.direction ) );
+    inst.size = glm::vec4( gfx.size, gfx.texScale );
+    inst.color = color;
+
+    if ( anim )
+        inst.frame = glm::vec4( anim->currentFrame, anim->animState, anim->maxFrames, anim->totalAnim );
+    else
+        inst.frame = glm::vec4( 0, 0, 1, 1 );
+
+    GLsizei index = GLsizei( _instances.size() );
+    _instances.push_back( inst );
+
+    if ( _runs.empty() || _runs.back().texture != gfx.texture )
+        _runs.push_back( { gfx.texture, index, 1 } );
+    else
+        ++_runs.back().count;
+}
+
+void SpriteBatch::end()
+{
+    _drawnCount = _instances.size();
+    _drawCalls = 0;
+
+    if ( _instances.empty() )
+        return;
+
+    glUseProgram( _program );
+    glUniform( _uMatrix, _cameraMatrix );
+
+    _quad.bind();
+    _quad.upload( _instances );
+
+    for ( const Run& run : _runs )
+    {
+        // GL 3.3 has no base instance; re-point the attributes instead.
+        if ( run.first != 0 )
+            _bindInstances( run.first );
+
+        glUniform( _uTexture, run.texture );
+        _quad.draw( run.count );
+        ++_drawCalls;
+    }
+
+    if ( _runs.size() > 1 )
+        _bindInstances( 0 );
+
+    InstancedQuad::unbind();
+
+    _instances.clear();
+    _runs.clear();
+}
+
+void SpriteBatch::_bindInstances( GLsizei first )
+{
+    const char* base = (const char*) (sizeof( Instance ) * first);
+    for ( GLuint i = 0; i < 4; ++i )
+    {
+        glVertexAttribPointer( InstancedQuad::FIRST_INSTANCE_ATTRIB + i, 4, GL_FLOAT, GL_FALSE,
+                               sizeof( Instance ), base + sizeof( glm::vec4 ) * i );
+    }
+}
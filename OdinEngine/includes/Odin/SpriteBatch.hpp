@@ -0,0 +1,103 @@
+// Andrew Meckling
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "GraphicalComponent.hpp"
+#include "AnimatorComponent.hpp"
+#include "InstancedQuad.hpp"
+
+namespace odin
+{
+    // Collects the per-sprite state that used to be sent through uniforms
+    // (transform, color, facing direction and animation frame) into a
+    // single streamed instance buffer. Sprites are drawn with one instanced
+    // draw call per run of consecutive sprites sharing a texture unit, so
+    // the painter's order of the submitted sprites is preserved.
+    // Only rectangles made by GraphicalComponent::makeRect can be batched;
+    // the batch draws its own unit quad scaled by GraphicalComponent::size.
+    // The program must follow the attribute layout of vertexInstanced.glsl.
+    class SpriteBatch
+    {
+    public:
+
+        // Per-instance vertex data. Matches attribute locations 2 to 5.
+        struct Instance
+        {
+            glm::vec4 transform; // position.xy, rotation, facing direction
+            glm::vec4 size;      // width, height, texcoord scale.xy
+            glm::vec4 color;
+            glm::vec4 frame;     // current frame, anim state, max frames, total anims
+        };
+
+        explicit SpriteBatch( GLuint program, size_t capacity = 256 );
+
+        SpriteBatch( const SpriteBatch& ) = delete;
+        SpriteBatch& operator =( const SpriteBatch& ) = delete;
+
+        // Starts a new batch. Discards any sprites that were not drawn.
+        void begin( const glm::mat4& cameraMatrix );
+
+        // Queues a sprite. Invisible sprites are ignored.
+        void add( const GraphicalComponent& gfx,
+                  const AnimatorComponent*  anim,
+                  glm::vec2                 position,
+                  float                     rotation,
+                  const glm::vec4&          color );
+
+        // Queues a sprite using the drawable's own color.
+        void add( const GraphicalComponent& gfx,
+                  const AnimatorComponent*  anim,
+                  glm::vec2                 position,
+                  float                     rotation )
+        {
+            add( gfx, anim, position, rotation, gfx.color );
+        }
+
+        // Uploads the queued sprites and draws them.
+        void end();
+
+        // Number of sprites drawn by the last call to end().
+        size_t count() const
+        {
+            return _drawnCount;
+        }
+
+        // Number of draw calls issued by the last call to end().
+        size_t drawCalls() const
+        {
+            return _drawCalls;
+        }
+
+    private:
+
+        // A range of consecutive instances which share a texture unit.
+        struct Run
+        {
+            int     texture;
+            GLsizei first;
+            GLsizei count;
+        };
+
+        GLuint _program;
+        GLint  _uMatrix;
+        GLint  _uTexture;
+
+        InstancedQuad _quad;
+
+        glm::mat4 _cameraMatrix;
+
+        std::vector< Instance > _instances;
+        std::vector< Run >      _runs;
+
+        size_t _drawnCount = 0;
+        size_t _drawCalls = 0;
+
+        // Points the instance attributes at the instance with index first.
+        void _bindInstances( GLsizei first );
+    };
+
+} // namespace odin
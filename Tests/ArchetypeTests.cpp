@@ -0,0 +1,108 @@
+// Andrew Meckling
+// Checks that queued archetype changes don't outlive their entity.
+
+#include "Check.hpp"
+
+#include <Odin/Archetype.hpp>
+
+#include <string>
+
+using namespace odin;
+
+using Rows = Archetype< int, std::string >;
+
+// An entity destroyed while its row is queued doesn't get the row, even
+// when its index is reused by an entity which queues a row of its own.
+void destroyed_before_flush()
+{
+    Registry registry;
+    Rows& rows = registry.archetype< int, std::string >();
+
+    Handle first = registry.create();
+    rows.defer( first.index, 1, "first" );
+    registry.destroy( first );
+
+    Handle second = registry.create();
+    CHECK( second.index == first.index );
+    rows.defer( second.index, 2, "second" );
+    rows.flush();
+
+    CHECK( registry.count() == 1 );
+    CHECK( rows.size() == 1 );
+    CHECK( rows.get< int >( second.index ) == 2 );
+    CHECK( rows.get< std::string >( second.index ) == "second" );
+}
+
+// A removal queued for a destroyed entity doesn't remove the row of the
+// entity which reuses its index.
+void destroyed_with_queued_removal()
+{
+    Registry registry;
+    Rows& rows = registry.archetype< int, std::string >();
+
+    Handle first = registry.create();
+    rows.emplace( first.index, 1, "first" );
+    rows.deferRemove( first.index );
+    registry.destroy( first );
+    CHECK( rows.size() == 0 );
+
+    Handle second = registry.create();
+    rows.emplace( second.index, 2, "second" );
+    rows.flush();
+
+    CHECK( rows.size() == 1 );
+    CHECK( rows.contains( second.index ) );
+}
+
+// Removing then adding a live entity's row in one flush replaces the row.
+void replaced_in_one_flush()
+{
+    Registry registry;
+    Rows& rows = registry.archetype< int, std::string >();
+
+    Handle h = registry.create();
+    rows.emplace( h.index, 1, "old" );
+    rows.deferRemove( h.index );
+    rows.defer( h.index, 2, "new" );
+    rows.flush();
+
+    CHECK( rows.size() == 1 );
+    CHECK( rows.get< int >( h.index ) == 2 );
+    CHECK( rows.get< std::string >( h.index ) == "new" );
+}
+
+// Rows move when others are removed; every entity keeps its own row.
+void rows_follow_entities()
+{
+    Registry registry;
+    Rows& rows = registry.archetype< int, std::string >();
+
+    const int N = 3 * int( Rows::CHUNK_CAPACITY );
+    std::vector< Handle > handles;
+    for ( int i = 0; i < N; ++i )
+    {
+        handles.push_back( registry.create() );
+        rows.emplace( handles.back().index, i, std::to_string( i ) );
+    }
+
+    for ( int i = 0; i < N; i += 3 )
+        registry.destroy( handles[ i ] );
+
+    CHECK( rows.size() == size_t( N - N / 3 ) );
+
+    bool intact = true;
+    rows.each( [&]( EntityIndex e, int& value, std::string& name ) {
+        intact = intact && handles[ value ].index == e && name == std::to_string( value );
+    } );
+    CHECK( intact );
+}
+
+int main()
+{
+    destroyed_before_flush();
+    destroyed_with_queued_removal();
+    replaced_in_one_flush();
+    rows_follow_entities();
+
+    return check_result();
+}
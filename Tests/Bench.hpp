@@ -0,0 +1,35 @@
+// Andrew Meckling
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+// Benchmarks run their full sizes by default. Passed "quick" (as CTest
+// does) they run a token amount of work, which only checks they still
+// build and run.
+inline bool bench_quick( int argc, char** argv )
+{
+    return argc > 1 && std::strcmp( argv[ 1 ], "quick" ) == 0;
+}
+
+// Calls fn() reps times and returns the mean time per call in nanoseconds.
+template< typename Fn >
+double bench_ns( size_t reps, Fn&& fn )
+{
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point start = Clock::now();
+    for ( size_t i = 0; i < reps; ++i )
+        fn();
+
+    std::chrono::duration< double, std::nano > elapsed = Clock::now() - start;
+    return elapsed.count() / double( reps > 0 ? reps : 1 );
+}
+
+// Keeps the compiler from discarding a result which is never used.
+inline void bench_keep( size_t value )
+{
+    static volatile size_t sink;
+    sink = sink + value;
+}
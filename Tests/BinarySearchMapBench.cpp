@@ -0,0 +1,120 @@
+// Andrew Meckling
+// Times removing and adding k entries of an n entry map one at a time
+// against doing it in bulk, with values which aren't moved by memcpy.
+
+#include "Bench.hpp"
+
+#include <Odin/BinarySearchMap.hpp>
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+using odin::BinarySearchMap;
+using odin::MapEntry;
+
+// Stands in for Entity2: a few words and something which owns memory.
+struct Value
+{
+    std::string   name;
+    std::uint64_t payload[ 4 ];
+};
+
+using Key = std::uint64_t;
+using Map = BinarySearchMap< Key, Value >;
+using Entry = MapEntry< Key, Value >;
+
+Map make_map( size_t n )
+{
+    Map map( 2 * n );
+    for ( Key key = 0; key < n; ++key )
+        map.add( 2 * key, Value { "entity", { key } } );
+    return map;
+}
+
+// Every other key in the map, from a random place, sorted.
+std::vector< Key > some_keys( size_t n, size_t k, bool inMap )
+{
+    std::mt19937 rng( 8551 );
+    std::vector< Key > keys;
+    for ( size_t i = 0; i < k; ++i )
+        keys.push_back( 2 * (rng() % n) + (inMap ? 0 : 1) );
+
+    std::sort( keys.begin(), keys.end() );
+    keys.erase( std::unique( keys.begin(), keys.end() ), keys.end() );
+    return keys;
+}
+
+void run( size_t n, size_t k, size_t reps )
+{
+    std::vector< Key > dead = some_keys( n, k, true );
+    std::vector< Key > born = some_keys( n, k, false );
+
+    // Each rep copies a fresh map; time the copy alone to subtract it.
+    Map source = make_map( n );
+    double copy = bench_ns( reps, [&] { Map map = source; bench_keep( map.count() ); } );
+
+    double removeEach = bench_ns( reps, [&] {
+        Map map = source;
+        for ( Key key : dead )
+            map.remove( key );
+        bench_keep( map.count() );
+    } );
+
+    double erase = bench_ns( reps, [&] {
+        Map map = source;
+        map.erase( dead.begin(), dead.end() );
+        bench_keep( map.count() );
+    } );
+
+    double removeIf = bench_ns( reps, [&] {
+        Map map = source;
+        map.remove_if( [&]( Key key, const Value& ) {
+            return std::binary_search( dead.begin(), dead.end(), key );
+        } );
+        bench_keep( map.count() );
+    } );
+
+    double addEach = bench_ns( reps, [&] {
+        Map map = source;
+        for ( Key key : born )
+            map.add( key, Value { "entity", { key } } );
+        bench_keep( map.count() );
+    } );
+
+    double insertRange = bench_ns( reps, [&] {
+        Map map = source;
+        std::vector< Entry > entries;
+        entries.reserve( born.size() );
+        for ( Key key : born )
+            entries.push_back( Entry { key, Value { "entity", { key } } } );
+        map.insert_range( entries.begin(), entries.end() );
+        bench_keep( map.count() );
+    } );
+
+    std::printf( "%8zu %6zu | %10.1f %10.1f %10.1f | %10.1f %10.1f\n", n, dead.size(),
+                 (removeEach - copy) / 1000, (erase - copy) / 1000, (removeIf - copy) / 1000,
+                 (addEach - copy) / 1000, (insertRange - copy) / 1000 );
+}
+
+int main( int argc, char** argv )
+{
+    bool quick = bench_quick( argc, argv );
+
+    std::printf( "Microseconds to remove or add k entries of an n entry map.\n" );
+    std::printf( "%8s %6s | %10s %10s %10s | %10s %10s\n",
+                 "n", "k", "remove", "erase", "remove_if", "add", "insert" );
+
+    for ( size_t n : { 256, 1024, 4096, 16384 } )
+    {
+        if ( quick && n > 256 )
+            break;
+
+        size_t reps = quick ? 1 : std::max< size_t >( 2, (1 << 20) / n );
+        run( n, n / 32, reps );
+        run( n, n / 4, reps );
+    }
+
+    return 0;
+}
@@ -0,0 +1,429 @@
+// Andrew Meckling
+// Checks BinarySearchMap against std::map under random edits, checks
+// that the bulk edits move each entry a bounded number of times, and
+// checks growth from an empty map, Blk allocators and relocatable values.
+
+#include "Check.hpp"
+
+#include <Allocators.hpp>
+#include <Odin/BinarySearchMap.hpp>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+
+using odin::BinarySearchMap;
+using odin::MapEntry;
+
+// A value which counts its moves and the objects alive. Moving it isn't
+// trivial, so the map takes its element-wise paths rather than memcpy.
+struct Counted
+{
+    static size_t moves;
+    static long   alive;
+
+    int value;
+
+    Counted( int value = 0 ) : value( value ) { ++alive; }
+    Counted( const Counted& copy ) : value( copy.value ) { ++alive; }
+    Counted( Counted&& move ) : value( move.value ) { ++alive; ++moves; }
+    ~Counted() { --alive; }
+
+    Counted& operator =( const Counted& copy ) { value = copy.value; return *this; }
+    Counted& operator =( Counted&& move ) { value = move.value; ++moves; return *this; }
+};
+
+size_t Counted::moves = 0;
+long   Counted::alive = 0;
+
+using Key = std::uint64_t;
+using Entry = MapEntry< Key, Counted >;
+using Reference = std::map< Key, int >;
+
+template< typename Map >
+bool same( const Map& map, const Reference& ref )
+{
+    if ( map.count() != ref.size() )
+        return false;
+
+    auto r = ref.begin();
+    for ( auto entry : map )
+    {
+        if ( entry.key != r->first || entry.value.value != r->second )
+            return false;
+        ++r;
+    }
+    return true;
+}
+
+// Applies the same random edits to a map and to a std::map, comparing
+// them after every edit.
+template< template< typename > class Layout >
+void random_edits( unsigned seed )
+{
+    using Map = BinarySearchMap< Key, Counted, Layout >;
+
+    std::mt19937 rng( seed );
+    auto random = [&rng]( size_t n ) { return size_t( rng() % n ); };
+    const Key KEYS = 2048;
+
+    Map map;
+    Reference ref;
+
+    for ( int step = 0; step < 3000; ++step )
+    {
+        switch ( random( 7 ) )
+        {
+        case 0: case 1: // add
+        {
+            Key key = random( KEYS );
+            int value = int( rng() );
+            bool added = map.add( key, Counted( value ) ) != nullptr;
+            CHECK( added == ref.emplace( key, value ).second );
+            break;
+        }
+        case 2: // remove
+        {
+            Key key = random( KEYS );
+            CHECK( map.remove( key ) == (ref.erase( key ) == 1) );
+            break;
+        }
+        case 3: // remove_if
+        {
+            Key mod = 2 + random( 30 );
+            size_t removed = map.remove_if( [mod]( Key key, const Counted& ) {
+                return key % mod == 0;
+            } );
+
+            size_t expected = 0;
+            for ( auto it = ref.begin(); it != ref.end(); )
+            {
+                if ( it->first % mod == 0 )
+                    it = ref.erase( it ), ++expected;
+                else
+                    ++it;
+            }
+            CHECK( removed == expected );
+            break;
+        }
+        case 4: // erase, with keys both in and out of the map
+        {
+            std::vector< Key > keys( random( 64 ) );
+            for ( Key& key : keys )
+                key = random( KEYS );
+            std::sort( keys.begin(), keys.end() );
+
+            size_t expected = 0;
+            for ( size_t i = 0; i < keys.size(); ++i )
+                if ( i == 0 || keys[ i ] != keys[ i - 1 ] )
+                    expected += ref.erase( keys[ i ] );
+
+            CHECK( map.erase( keys.begin(), keys.end() ) == expected );
+            break;
+        }
+        case 5: // insert_range, with repeated keys
+        {
+            std::vector< Entry > entries;
+            size_t n = random( 256 );
+            for ( size_t i = 0; i < n; ++i )
+                entries.push_back( Entry { random( KEYS ), Counted( int( rng() ) ) } );
+            std::stable_sort( entries.begin(), entries.end(),
+                []( const Entry& a, const Entry& b ) { return a.key < b.key; } );
+
+            size_t expected = 0;
+            for ( const Entry& entry : entries )
+                expected += ref.emplace( entry.key, entry.value.value ).second;
+
+            CHECK( map.insert_range( entries.begin(), entries.end() ) == expected );
+            break;
+        }
+        case 6: // merge
+        {
+            Map other;
+            size_t expected = 0;
+            size_t n = random( 128 );
+            for ( size_t i = 0; i < n; ++i )
+            {
+                Key key = random( KEYS );
+                int value = int( rng() );
+                if ( other.add( key, Counted( value ) ) )
+                    expected += ref.emplace( key, value ).second;
+            }
+
+            CHECK( map.merge( std::move( other ) ) == expected );
+            CHECK( other.count() == 0 );
+            break;
+        }
+        }
+
+        CHECK( same( map, ref ) );
+
+        // Search both ways; a const search doesn't build the layout's index.
+        Key key = random( KEYS );
+        const Map& constMap = map;
+        bool found = ref.count( key ) == 1;
+        CHECK( bool( map.search( key ) ) == found );
+        CHECK( bool( constMap.search( key ) ) == found );
+        if ( found )
+            CHECK( map.search( key )->value == ref[ key ] );
+    }
+}
+
+// Removing or adding k entries in bulk must move each entry O(1) times,
+// where k single edits would move O(k * n) of them.
+void bulk_edit_moves()
+{
+    using Map = BinarySearchMap< Key, Counted >;
+    const size_t N = 4096;
+
+    auto fill = []( Map& map ) {
+        map.reallocate( 2 * N );
+        for ( Key key = 0; key < N; ++key )
+            map.add( 2 * key, Counted( int( key ) ) );
+    };
+
+    {
+        Map map;
+        fill( map );
+        Counted::moves = 0;
+        size_t removed = map.remove_if( []( Key key, const Counted& ) { return key % 4 == 0; } );
+        CHECK( removed == N / 2 );
+        CHECK( Counted::moves <= N );
+    }
+    {
+        Map map;
+        fill( map );
+        std::vector< Key > keys;
+        for ( Key key = 0; key < 2 * N; key += 4 )
+            keys.push_back( key );
+
+        Counted::moves = 0;
+        CHECK( map.erase( keys.begin(), keys.end() ) == N / 2 );
+        CHECK( Counted::moves <= N );
+    }
+    {
+        Map map;
+        fill( map );
+        std::vector< Entry > entries;
+        for ( Key key = 1; key < 2 * N; key += 4 )
+            entries.push_back( Entry { key, Counted( int( key ) ) } );
+
+        Counted::moves = 0;
+        CHECK( map.insert_range( entries.begin(), entries.end() ) == N / 2 );
+        // Each entry is moved into place once; new ones also pass
+        // through a temporary.
+        CHECK( Counted::moves <= 3 * (N + N / 2) );
+    }
+    {
+        Map map, other;
+        fill( map );
+        for ( Key key = 1; key < 2 * N; key += 4 )
+            other.add( key, Counted( int( key ) ) );
+
+        Counted::moves = 0;
+        CHECK( map.merge( std::move( other ) ) == N / 2 );
+        CHECK( Counted::moves <= 3 * (N + N / 2) );
+    }
+}
+
+// A map made with capacity 0 allocates nothing, then grows by half.
+void half_growth_from_empty()
+{
+    using Map = BinarySearchMap< Key, int, odin::EytzingerLayout, odin::NewAllocator, odin::HalfGrowth >;
+
+    Map map( 0 );
+    CHECK( map.capacity() == 0 );
+    CHECK( !map.search( 5 ) );
+    CHECK( !map.remove( 5 ) );
+
+    // Add to the front so every growth splits the entries.
+    size_t expected = 0;
+    for ( Key key = 100; key-- > 0; )
+    {
+        if ( map.count() == map.capacity() )
+            expected = odin::HalfGrowth::grow( expected, expected + 1 );
+
+        CHECK( map.add( key, int( key ) ) != nullptr );
+        CHECK( map.capacity() == expected );
+    }
+
+    CHECK( expected == 139 ); // 1, 2, 4, 7, 11, 17, 26, 40, 61, 92, 139
+    for ( Key key = 0; key < 100; ++key )
+        CHECK( map.search( key ) && *map.search( key ) == int( key ) );
+
+    // Merging into an empty map grows it once.
+    Map other( 0 );
+    CHECK( other.merge( std::move( map ) ) == 100 );
+    CHECK( other.capacity() == 100 );
+    CHECK( other.count() == 100 );
+
+    Map copy( map );
+    CHECK( copy.capacity() == map.capacity() );
+    copy = Map( 0 );
+    CHECK( copy.capacity() == 0 );
+}
+
+// Hands out Blks from malloc and keeps count of the ones outstanding.
+class CountingAllocator
+{
+public:
+
+    size_t blocks = 0;
+    size_t bytes = 0;
+
+    Blk allocate( size_t n )
+    {
+        ++blocks;
+        bytes += n;
+        return _malloc.allocate( n );
+    }
+
+    void deallocate( Blk b )
+    {
+        --blocks;
+        bytes -= b.size;
+        _malloc.deallocate( b );
+    }
+
+    bool owns( void* )
+    {
+        return true;
+    }
+
+private:
+
+    Mallocator _malloc;
+};
+
+// Maps sharing an allocator through AllocatorRef, the way LevelScene's
+// entity index uses its arena, give back every block they take, at the
+// size they took it.
+void blk_allocator_ref()
+{
+    using Map = BinarySearchMap< Key, Counted, odin::SortedLayout,
+                                 AllocatorRef< CountingAllocator >, odin::HalfGrowth >;
+
+    CountingAllocator allocator;
+    {
+        Map map( 0, allocator );
+        Map other( 4, allocator );
+        CHECK( allocator.blocks == 1 );
+
+        for ( Key key = 0; key < 1000; ++key )
+            map.add( (key * 7919) % 1000, Counted( int( key ) ) );
+        for ( Key key = 1000; key < 1100; ++key )
+            other.add( key, Counted( int( key ) ) );
+
+        CHECK( allocator.blocks == 2 );
+        CHECK( map.merge( std::move( other ) ) == 100 );
+        CHECK( map.remove_if( []( Key key, const Counted& ) { return key % 2 == 0; } ) == 550 );
+        map.reallocate( map.count() );
+        CHECK( map.capacity() == 550 );
+
+        Map copy( map );
+        CHECK( copy.count() == 550 );
+        CHECK( allocator.blocks == 3 );
+    }
+    CHECK( allocator.blocks == 0 );
+    CHECK( allocator.bytes == 0 );
+}
+
+// Like LevelScene's Entity2: a user-written move and a unique_ptr with a
+// custom deleter, declared trivially relocatable. The deleter records
+// every object it deletes; the move counts calls to itself.
+struct Owner
+{
+    struct Deleter
+    {
+        std::vector< int >* deleted = nullptr;
+
+        void operator ()( int* p ) const
+        {
+            ++(*deleted)[ *p ];
+            delete p;
+        }
+    };
+
+    static size_t moves;
+
+    std::unique_ptr< int, Deleter > ptr;
+
+    Owner( std::vector< int >& deleted, int id )
+        : ptr( new int( id ), Deleter { &deleted } )
+    {
+    }
+
+    Owner( Owner&& move ) : ptr( std::move( move.ptr ) ) { ++moves; }
+    Owner& operator =( Owner&& move ) { ptr = std::move( move.ptr ); ++moves; return *this; }
+};
+
+size_t Owner::moves = 0;
+
+namespace odin
+{
+    template<>
+    struct is_trivially_relocatable< Owner >
+        : std::true_type
+    {
+    };
+}
+
+// Relocatable entries are shifted and grown with memmove: adding to the
+// front of the map moves each entry a constant number of times, rather
+// than once per entry behind it, and every object is deleted once.
+void relocatable_memmove()
+{
+    using Map = BinarySearchMap< Key, Owner >;
+    static_assert( Map::RELOCATABLE, "Owner should be relocated with memmove" );
+
+    const int N = 2000;
+    std::vector< int > deleted( N );
+    {
+        Map map( 0 );
+        Owner::moves = 0;
+        for ( int id = N; id-- > 0; )
+            map.add( Key( id ), Owner( deleted, id ) );
+
+        // Passing a value in moves it a few times; shifting doesn't.
+        CHECK( Owner::moves <= 3 * size_t( N ) );
+
+        int id = 0;
+        for ( auto entry : map )
+            CHECK( entry.key == Key( id ) && *entry.value.ptr == id++ );
+
+        // Erase from the front half; memmove shifts the rest down.
+        Owner::moves = 0;
+        for ( Key key = 0; key < N / 2; key += 2 )
+            CHECK( map.remove( key ) );
+        CHECK( Owner::moves == 0 );
+
+        for ( Key key = 0; key < N; ++key )
+            CHECK( bool( map.search( key ) ) == (key >= N / 2 || key % 2 == 1) );
+    }
+
+    size_t wrong = 0;
+    for ( int count : deleted )
+        wrong += count != 1;
+    CHECK( wrong == 0 );
+}
+
+int main()
+{
+    for ( unsigned seed = 1; seed <= 4; ++seed )
+    {
+        random_edits< odin::SortedLayout >( seed );
+        random_edits< odin::EytzingerLayout >( seed );
+    }
+
+    bulk_edit_moves();
+    half_growth_from_empty();
+    blk_allocator_ref();
+    relocatable_memmove();
+
+    // Every value constructed was destroyed exactly once.
+    CHECK( Counted::alive == 0 );
+
+    return check_result();
+}
@@ -0,0 +1,161 @@
+// Andrew Meckling
+// Compares BitsetAllocator to the bit at a time one it replaced: the
+// time per allocate/deallocate under a random mix, and how full the
+// memory gets before an allocation fails once it's fragmented.
+// Every block is stamped and checked, so overlapping blocks would show.
+
+#include "Bench.hpp"
+#include "LegacyBitsetAllocator.hpp"
+
+#include <Allocators.hpp>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+struct Live
+{
+    Blk  blk;
+    byte stamp;
+};
+
+// Fills the ends of a block with its stamp.
+void stamp( const Live& live )
+{
+    byte* p = (byte*) live.blk.ptr;
+    p[ 0 ] = live.stamp;
+    p[ live.blk.size - 1 ] = live.stamp;
+}
+
+bool stamped( const Live& live )
+{
+    const byte* p = (const byte*) live.blk.ptr;
+    return p[ 0 ] == live.stamp && p[ live.blk.size - 1 ] == live.stamp;
+}
+
+struct Result
+{
+    double nsPerOp;
+    size_t failed;
+    size_t corrupt;
+};
+
+// Allocates and frees blocks of 8 to 256 bytes at random, keeping about
+// half of the memory in use.
+template< typename Allocator >
+Result throughput( Allocator& allocator, size_t ops )
+{
+    std::mt19937 rng( 8551 );
+    std::vector< Live > live;
+    size_t liveBytes = 0;
+    size_t failed = 0;
+    size_t corrupt = 0;
+
+    double ns = bench_ns( ops, [&] {
+        bool grow = live.empty() || (liveBytes < Allocator::SIZE / 2 && rng() % 4 != 0);
+        if ( grow )
+        {
+            size_t size = 8 + rng() % 249;
+            Blk blk = allocator.allocate( size );
+            if ( blk.ptr == nullptr )
+            {
+                ++failed;
+                return;
+            }
+
+            live.push_back( { blk, byte( rng() ) } );
+            stamp( live.back() );
+            liveBytes += size;
+        }
+        else
+        {
+            size_t i = rng() % live.size();
+            corrupt += !stamped( live[ i ] );
+            allocator.deallocate( live[ i ].blk );
+            liveBytes -= live[ i ].blk.size;
+            live[ i ] = live.back();
+            live.pop_back();
+        }
+    } );
+
+    for ( Live& l : live )
+        allocator.deallocate( l.blk );
+
+    return { ns, failed, corrupt };
+}
+
+// Fills the memory, frees a random half of the blocks, then fills it
+// again. Returns the percentage of the memory in use when the second
+// fill first fails.
+template< typename Allocator >
+double fragmentation( Allocator& allocator, size_t& corrupt )
+{
+    std::mt19937 rng( 8551 );
+    std::vector< Live > live;
+    size_t liveBytes = 0;
+
+    auto fill = [&] {
+        for ( ;; )
+        {
+            size_t size = 8 + rng() % 249;
+            Blk blk = allocator.allocate( size );
+            if ( blk.ptr == nullptr )
+                return;
+
+            live.push_back( { blk, byte( rng() ) } );
+            stamp( live.back() );
+            liveBytes += size;
+        }
+    };
+
+    fill();
+    std::shuffle( live.begin(), live.end(), rng );
+    for ( size_t i = live.size() / 2; i < live.size(); ++i )
+    {
+        corrupt += !stamped( live[ i ] );
+        allocator.deallocate( live[ i ].blk );
+        liveBytes -= live[ i ].blk.size;
+    }
+    live.resize( live.size() / 2 );
+
+    fill();
+    double used = 100.0 * liveBytes / Allocator::SIZE;
+
+    for ( Live& l : live )
+    {
+        corrupt += !stamped( l );
+        allocator.deallocate( l.blk );
+    }
+    return used;
+}
+
+template< typename Allocator >
+void run( const char* name, size_t ops )
+{
+    // Too big for the stack.
+    std::unique_ptr< Allocator > allocator( new Allocator );
+
+    Result r = throughput( *allocator, ops );
+    size_t corrupt = r.corrupt;
+    double used = fragmentation( *allocator, corrupt );
+
+    std::printf( "%-28s %8zu %10.1f %8zu %9.1f%% %8zu\n",
+                 name, Allocator::SIZE / 1024, r.nsPerOp, r.failed, used, corrupt );
+}
+
+int main( int argc, char** argv )
+{
+    size_t ops = bench_quick( argc, argv ) ? 1000 : 200000;
+
+    std::printf( "%-28s %8s %10s %8s %10s %8s\n",
+                 "allocator", "KiB", "ns/op", "failed", "fill", "corrupt" );
+
+    run< LegacyBitsetAllocator< 64 * 1024, 16 > >( "bit at a time", ops );
+    run< BitsetAllocator< 64 * 1024, 16 > >( "word at a time", ops );
+
+    run< LegacyBitsetAllocator< 1024 * 1024, 16 > >( "bit at a time", ops );
+    run< BitsetAllocator< 1024 * 1024, 16, false > >( "word at a time", ops );
+    run< BitsetAllocator< 1024 * 1024, 16, true > >( "word at a time, summary", ops );
+
+    return 0;
+}
@@ -0,0 +1,126 @@
+// Andrew Meckling
+#pragma once
+
+// Scenes shared by the Box2D tests and benchmarks.
+
+#include <Box2D/Box2D.h>
+
+#include <cmath>
+
+// A static edge along y = 0 from x0 to x1.
+inline void ground( b2World& world, float32 x0, float32 x1 )
+{
+    b2EdgeShape edge;
+    edge.Set( b2Vec2( x0, 0.0f ), b2Vec2( x1, 0.0f ) );
+
+    b2BodyDef def;
+    world.CreateBody( &def )->CreateFixture( &edge, 0.0f );
+}
+
+// Stacks a pyramid of boxes with the given base, its left corner at x.
+inline void pyramid( b2World& world, float32 x, int32 base )
+{
+    b2PolygonShape box;
+    box.SetAsBox( 0.5f, 0.5f );
+
+    b2BodyDef def;
+    def.type = b2_dynamicBody;
+
+    for ( int32 row = 0; row < base; ++row )
+    {
+        for ( int32 i = 0; i < base - row; ++i )
+        {
+            def.position.Set( x + 0.5f * row + 1.0f * i, 0.5f + 1.0f * row );
+            world.CreateBody( &def )->CreateFixture( &box, 5.0f );
+        }
+    }
+}
+
+// Stacks a wall of boxes, columns wide and rows high, its left corner at x.
+// Every box touches its neighbours, so the wall is one island.
+inline void wall( b2World& world, float32 x, int32 columns, int32 rows )
+{
+    b2PolygonShape box;
+    box.SetAsBox( 0.5f, 0.5f );
+
+    b2BodyDef def;
+    def.type = b2_dynamicBody;
+
+    for ( int32 row = 0; row < rows; ++row )
+    {
+        for ( int32 i = 0; i < columns; ++i )
+        {
+            def.position.Set( x + 0.5f + 1.0f * i, 0.5f + 1.0f * row );
+            world.CreateBody( &def )->CreateFixture( &box, 5.0f );
+        }
+    }
+}
+
+// Scatters count static unit boxes over a square of the given size
+// centred on the origin. Every third box's mask leaves out ignoredBits,
+// so fixtures with those category bits pass through it.
+inline void crates( b2World& world, int32 count, float32 size, uint16 ignoredBits )
+{
+    b2PolygonShape box;
+    box.SetAsBox( 0.5f, 0.5f );
+
+    b2FixtureDef fixture;
+    fixture.shape = &box;
+
+    b2BodyDef def;
+    uint32 seed = 12345;
+
+    for ( int32 i = 0; i < count; ++i )
+    {
+        // A small LCG keeps the layout the same on every platform.
+        seed = seed * 1664525u + 1013904223u;
+        float32 x = (seed >> 8) / float32( 1 << 24 );
+        seed = seed * 1664525u + 1013904223u;
+        float32 y = (seed >> 8) / float32( 1 << 24 );
+
+        def.position.Set( (x - 0.5f) * size, (y - 0.5f) * size );
+        fixture.filter.maskBits = i % 3 == 2 ? uint16( 0xFFFF & ~ignoredBits ) : uint16( 0xFFFF );
+        world.CreateBody( &def )->CreateFixture( &fixture );
+    }
+}
+
+// Fills inputs with rays of the given length starting anywhere in a
+// square of the given size centred on the origin, in any direction.
+inline void random_rays( b2RayCastInput* inputs, int32 count, float32 size, float32 length, uint32 seed )
+{
+    for ( int32 i = 0; i < count; ++i )
+    {
+        float32 r[ 3 ];
+        for ( float32& v : r )
+        {
+            seed = seed * 1664525u + 1013904223u;
+            v = (seed >> 8) / float32( 1 << 24 );
+        }
+
+        float32 angle = r[ 2 ] * 2.0f * b2_pi;
+        inputs[ i ].p1.Set( (r[ 0 ] - 0.5f) * size, (r[ 1 ] - 0.5f) * size );
+        inputs[ i ].p2 = inputs[ i ].p1 + length * b2Vec2( std::cos( angle ), std::sin( angle ) );
+        inputs[ i ].maxFraction = 1.0f;
+    }
+}
+
+// True if every body of a and b, in list order, has exactly the same
+// transform and velocity.
+inline bool same_bodies( b2World& a, b2World& b )
+{
+    if ( a.GetBodyCount() != b.GetBodyCount() )
+        return false;
+
+    for ( b2Body *p = a.GetBodyList(), *q = b.GetBodyList(); p && q; p = p->GetNext(), q = q->GetNext() )
+    {
+        if ( p->GetPosition().x != q->GetPosition().x
+             || p->GetPosition().y != q->GetPosition().y
+             || p->GetAngle() != q->GetAngle()
+             || p->GetLinearVelocity().x != q->GetLinearVelocity().x
+             || p->GetLinearVelocity().y != q->GetLinearVelocity().y
+             || p->GetAngularVelocity() != q->GetAngularVelocity() )
+            return false;
+    }
+
+    return true;
+}
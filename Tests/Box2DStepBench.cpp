@@ -0,0 +1,69 @@
+// Andrew Meckling
+// Times b2World::Step on about 2k boxes stacked into pyramids of four
+// sizes, so the island solve tasks vary in cost, with 1 to 8 threads.
+// Compares b2ThreadPool to the locked heap pool it replaced. With one
+// thread the world steps without an executor, so both columns match.
+
+#include "Bench.hpp"
+#include "Box2DScenes.hpp"
+#include "LegacyThreadPool.hpp"
+
+#include <memory>
+
+// 820 + 4 * 210 + 6 * 55 + 2 * 15 = 2020 boxes.
+void build( b2World& world )
+{
+    ground( world, -100.0f, 500.0f );
+
+    float32 x = -90.0f;
+    const int32 bases[] = { 40, 20, 20, 20, 20, 10, 10, 10, 10, 10, 10, 5, 5 };
+    for ( int32 base : bases )
+    {
+        pyramid( world, x, base );
+        x += base + 4.0f;
+    }
+}
+
+// Milliseconds per step; sums the final heights into checksum.
+double run( b2TaskExecutor* executor, int32 steps, float32& checksum )
+{
+    std::unique_ptr< b2World > world( new b2World( b2Vec2( 0.0f, -10.0f ), executor ) );
+    build( *world );
+
+    double ns = bench_ns( steps, [&] {
+        world->Step( 1.0f / 60.0f, 8, 3 );
+    } );
+
+    checksum = 0.0f;
+    for ( b2Body* b = world->GetBodyList(); b; b = b->GetNext() )
+        checksum += b->GetPosition().y;
+
+    return ns / 1e6;
+}
+
+int main( int argc, char** argv )
+{
+    int32 steps = bench_quick( argc, argv ) ? 3 : 300;
+
+    std::printf( "Milliseconds per step, and the sum of the boxes' heights after %d steps.\n", steps );
+    std::printf( "%8s %10s %10s %12s %12s\n", "threads", "locked", "stealing", "sum locked", "sum stealing" );
+
+    for ( int32 threads = 1; threads <= 8; threads *= 2 )
+    {
+        float32 lockedSum, stealingSum;
+        double locked, stealing;
+        {
+            LegacyThreadPool pool( threads - 1 );
+            locked = run( &pool, steps, lockedSum );
+        }
+        {
+            b2ThreadPool pool( threads - 1 );
+            stealing = run( &pool, steps, stealingSum );
+        }
+
+        std::printf( "%8d %10.2f %10.2f %12.2f %12.2f\n",
+                     threads, locked, stealing, lockedSum, stealingSum );
+    }
+
+    return 0;
+}
@@ -0,0 +1,31 @@
+// Andrew Meckling
+#pragma once
+
+#include <cstdio>
+
+// Just enough of a test framework for these tests. A failed CHECK prints
+// itself and the test carries on; main returns check_result().
+
+inline int& check_failures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK( cond ) \
+    do { \
+        if ( !(cond) ) { \
+            std::printf( "%s(%d): CHECK failed: %s\n", __FILE__, __LINE__, #cond ); \
+            ++check_failures(); \
+        } \
+    } while ( 0 )
+
+inline int check_result()
+{
+    if ( check_failures() == 0 )
+        std::printf( "All checks passed.\n" );
+    else
+        std::printf( "%d checks failed.\n", check_failures() );
+
+    return check_failures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,59 @@
+// Andrew Meckling
+// Times b2World::Step on a single 1000-box wall, one island, with 1 to 8
+// threads and contact coloring on and off. Without coloring the island's
+// contacts are solved by one thread whatever the thread count. The wide
+// column colors the contacts too and solves their velocities with the
+// wide solver. Each column shows the whole step, then the part of it
+// spent solving velocities.
+
+#include "Bench.hpp"
+#include "Box2DScenes.hpp"
+
+#include <memory>
+
+struct StepTimes
+{
+    double step;     // Milliseconds per step.
+    double velocity; // Milliseconds per step solving velocity constraints.
+};
+
+StepTimes run( b2TaskExecutor* executor, bool coloring, bool wide, int32 steps )
+{
+    std::unique_ptr< b2World > world( new b2World( b2Vec2( 0.0f, -10.0f ), executor ) );
+    world->SetContactColoring( coloring );
+    world->SetWideContactSolver( wide );
+
+    ground( *world, -50.0f, 50.0f );
+    wall( *world, -12.5f, 25, 40 );
+
+    double velocityMs = 0.0;
+    double ns = bench_ns( steps, [&] {
+        world->Step( 1.0f / 60.0f, 8, 3 );
+        velocityMs += world->GetProfile().solveVelocity;
+    } );
+
+    return { ns / 1e6, velocityMs / steps };
+}
+
+int main( int argc, char** argv )
+{
+    int32 steps = bench_quick( argc, argv ) ? 3 : 300;
+
+    std::printf( "Milliseconds per step (solving velocities) of a 1000-box wall over %d steps.\n", steps );
+    std::printf( "%8s %16s %16s %16s\n", "threads", "wide", "colored", "uncolored" );
+
+    for ( int32 threads = 1; threads <= 8; threads *= 2 )
+    {
+        b2ThreadPool pool( threads - 1 );
+        StepTimes wide = run( &pool, true, true, steps );
+        StepTimes colored = run( &pool, true, false, steps );
+        StepTimes uncolored = run( &pool, false, false, steps );
+
+        std::printf( "%8d %7.2f (%6.2f) %7.2f (%6.2f) %7.2f (%6.2f)\n", threads,
+                     wide.step, wide.velocity,
+                     colored.step, colored.velocity,
+                     uncolored.step, uncolored.velocity );
+    }
+
+    return 0;
+}
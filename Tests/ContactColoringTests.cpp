@@ -0,0 +1,90 @@
+// Andrew Meckling
+// Steps the same scene with 2, 4 and 8 threads and checks every body
+// ends up with exactly the same transform and velocity. The wall and the
+// big pyramid are islands large enough to have their contacts colored
+// and split across the threads; the small pyramids aren't.
+//
+// A world without worker threads finds new contacts in broadphase order
+// rather than sorting them, so it only has to match other worlds without
+// workers.
+
+#include "Check.hpp"
+#include "Box2DScenes.hpp"
+
+#include <memory>
+
+std::unique_ptr< b2World > step_scene( b2TaskExecutor* executor, bool wide )
+{
+    std::unique_ptr< b2World > world( new b2World( b2Vec2( 0.0f, -10.0f ), executor ) );
+    world->SetWideContactSolver( wide );
+
+    ground( *world, -50.0f, 150.0f );
+    wall( *world, -40.0f, 20, 25 );
+    pyramid( *world, -10.0f, 30 );
+    pyramid( *world, 30.0f, 10 );
+    pyramid( *world, 45.0f, 5 );
+
+    for ( int32 i = 0; i < 120; ++i )
+        world->Step( 1.0f / 60.0f, 8, 3 );
+
+    return world;
+}
+
+void same_for_any_thread_count( bool wide )
+{
+    b2ThreadPool two( 1 );
+    std::unique_ptr< b2World > expected = step_scene( &two, wide );
+
+    for ( int32 threads = 4; threads <= 8; threads *= 2 )
+    {
+        b2ThreadPool pool( threads - 1 );
+        std::unique_ptr< b2World > world = step_scene( &pool, wide );
+        CHECK( same_bodies( *expected, *world ) );
+    }
+
+    // An executor without workers matches no executor at all.
+    b2ThreadPool single( 0 );
+    std::unique_ptr< b2World > alone = step_scene( &single, wide );
+    std::unique_ptr< b2World > world = step_scene( nullptr, wide );
+    CHECK( same_bodies( *alone, *world ) );
+}
+
+// A single island large enough to be colored with either solver.
+std::unique_ptr< b2World > step_wall( b2TaskExecutor* executor, bool wide )
+{
+    std::unique_ptr< b2World > world( new b2World( b2Vec2( 0.0f, -10.0f ), executor ) );
+    world->SetWideContactSolver( wide );
+
+    ground( *world, -50.0f, 50.0f );
+    wall( *world, -15.0f, 30, 30 );
+
+    for ( int32 i = 0; i < 120; ++i )
+        world->Step( 1.0f / 60.0f, 8, 3 );
+
+    return world;
+}
+
+// The wide solver packs the contacts of each color four at a time, but
+// solves every contact exactly as the scalar colored solve does. Smaller
+// islands aren't compared: the wide solver colors them and the scalar
+// solver doesn't, so their contacts are solved in another order.
+void wide_matches_scalar()
+{
+    b2ThreadPool pool( 3 );
+    std::unique_ptr< b2World > scalar = step_wall( &pool, false );
+    std::unique_ptr< b2World > wide = step_wall( &pool, true );
+    CHECK( same_bodies( *scalar, *wide ) );
+
+    scalar = step_wall( nullptr, false );
+    wide = step_wall( nullptr, true );
+    CHECK( same_bodies( *scalar, *wide ) );
+}
+
+int main()
+{
+    same_for_any_thread_count( false );
+    same_for_any_thread_count( true );
+    wide_matches_scalar();
+
+    return check_result();
+}
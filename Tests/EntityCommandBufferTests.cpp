@@ -0,0 +1,63 @@
+// Andrew Meckling
+// Checks the order EntityCommandBuffer::sort() leaves the commands in.
+
+#include "Check.hpp"
+
+#include <Odin/EntityCommandBuffer.hpp>
+
+#include <cstdint>
+
+using namespace odin;
+
+using Buffer = EntityCommandBuffer< std::uint64_t, int >;
+
+// Creates are sorted on their names, and repeats are kept in the order
+// they were recorded, so the scene can keep the first and destroy the
+// entities of the rest.
+void repeated_creates_are_kept()
+{
+    Buffer buffer;
+    buffer.create( 7, 1 );
+    buffer.create( 3, 2 );
+    buffer.create( 7, 3 );
+
+    Buffer other;
+    other.create( 7, 4 );
+    other.create( 1, 5 );
+    buffer.append( other );
+    CHECK( other.empty() );
+
+    buffer.sort();
+
+    const auto& created = buffer.created();
+    CHECK( created.size() == 5 );
+    const std::uint64_t keys[] = { 1, 3, 7, 7, 7 };
+    const int values[] = { 5, 2, 1, 3, 4 };
+    for ( size_t i = 0; i < created.size() && i < 5; ++i )
+    {
+        CHECK( created[ i ].key == keys[ i ] );
+        CHECK( created[ i ].value == values[ i ] );
+    }
+}
+
+// Destroying a name twice destroys it once.
+void repeated_destroys_are_dropped()
+{
+    Buffer buffer;
+    buffer.destroy( std::uint64_t( 9 ) );
+    buffer.destroy( std::uint64_t( 2 ) );
+    buffer.destroy( std::uint64_t( 9 ) );
+    buffer.sort();
+
+    const auto& names = buffer.destroyedNames();
+    CHECK( names.size() == 2 );
+    CHECK( names.size() == 2 && names[ 0 ] == 2 && names[ 1 ] == 9 );
+}
+
+int main()
+{
+    repeated_creates_are_kept();
+    repeated_destroys_are_dropped();
+
+    return check_result();
+}
@@ -0,0 +1,98 @@
+// Andrew Meckling
+// Checks at compile time that the constexpr EntityId constructors lay out
+// tags the way the memcpy constructors they replaced did, that hasTag and
+// _eid are constants, and that a bit pattern can be a template argument.
+// main repeats the layout checks against memcpy itself.
+
+#include "Check.hpp"
+
+#include <Odin/EntityId.hpp>
+
+#include <cstring>
+
+using namespace odin;
+using namespace odin::literals;
+
+// The bit pattern of the eight bytes b0 to b7 in memory, on a little
+// endian machine.
+constexpr std::uint64_t bytes( unsigned char b0, unsigned char b1, unsigned char b2, unsigned char b3,
+                               unsigned char b4, unsigned char b5, unsigned char b6, unsigned char b7 )
+{
+    return std::uint64_t( b0 )       | std::uint64_t( b1 ) << 8
+         | std::uint64_t( b2 ) << 16 | std::uint64_t( b3 ) << 24
+         | std::uint64_t( b4 ) << 32 | std::uint64_t( b5 ) << 40
+         | std::uint64_t( b6 ) << 48 | std::uint64_t( b7 ) << 56;
+}
+
+// Tags of 1 to 6 characters were copied into name, after the number.
+static_assert( EntityId( "a" )._bitPattern == bytes( 0, 0, 'a', 0, 0, 0, 0, 0 ), "" );
+static_assert( EntityId( "ab", 0x1234 )._bitPattern == bytes( 0x34, 0x12, 'a', 'b', 0, 0, 0, 0 ), "" );
+static_assert( EntityId( "abc", 7 )._bitPattern == bytes( 7, 0, 'a', 'b', 'c', 0, 0, 0 ), "" );
+static_assert( EntityId( "door", 3 )._bitPattern == bytes( 3, 0, 'd', 'o', 'o', 'r', 0, 0 ), "" );
+static_assert( EntityId( "coins", 65535 )._bitPattern == bytes( 0xff, 0xff, 'c', 'o', 'i', 'n', 's', 0 ), "" );
+static_assert( EntityId( "wintex" )._bitPattern == bytes( 0, 0, 'w', 'i', 'n', 't', 'e', 'x' ), "" );
+
+// Tags of 7 characters started at the second byte and 8 at the first.
+static_assert( EntityId( "abcdefg" )._bitPattern == bytes( 0, 'a', 'b', 'c', 'd', 'e', 'f', 'g' ), "" );
+static_assert( EntityId( "abcdefgh" )._bitPattern == bytes( 'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h' ), "" );
+
+// Characters above 127 aren't sign extended into the other bytes.
+static_assert( EntityId( "\xff", 1 )._bitPattern == bytes( 1, 0, 0xff, 0, 0, 0, 0, 0 ), "" );
+
+// _eid gives the same ids as the constructors, with a number of 0.
+static_assert( "a"_eid == EntityId( "a" ), "" );
+static_assert( "wintex"_eid == EntityId( "wintex", 0 ), "" );
+static_assert( "abcdefg"_eid == EntityId( "abcdefg" ), "" );
+static_assert( "abcdefgh"_eid == EntityId( "abcdefgh" ), "" );
+
+// hasTag folds to a constant, so it can be a template argument.
+template< bool B >
+struct Constant
+{
+    static constexpr bool value = B;
+};
+
+static_assert( Constant< EntityId( "door", 3 ).hasTag( "door" ) >::value, "" );
+static_assert( Constant< EntityId( "door", 65535 ).hasTag( "door" ) >::value, "" );
+static_assert( !Constant< EntityId( "doors", 3 ).hasTag( "door" ) >::value, "" );
+static_assert( !Constant< EntityId( "dor", 3 ).hasTag( "door" ) >::value, "" );
+
+// A bit pattern is a non-type template argument, e.g. to switch on ids.
+template< std::uint64_t Id >
+struct Tagged
+{
+    static constexpr std::uint64_t id = Id;
+};
+
+static_assert( Tagged< EntityId( "wintex" )._bitPattern >::id == "wintex"_eid._bitPattern, "" );
+static_assert( std::is_same< Tagged< EntityId( "wintex" )._bitPattern >,
+                             Tagged< "wintex"_eid._bitPattern > >::value, "" );
+
+// The memcpy constructors the constexpr ones replaced.
+template< std::size_t N >
+EntityId memcpy_id( const char (&tag)[ N ], std::uint16_t num = 0 )
+{
+    EntityId eid( num );
+    if ( N <= 7 )
+        std::memcpy( eid.name, tag, N - 1 );
+    else
+        std::memcpy( &eid._bytes[ 9 - N ], tag, N - 1 );
+    return eid;
+}
+
+int main()
+{
+    CHECK( EntityId( "a", 1 ) == memcpy_id( "a", 1 ) );
+    CHECK( EntityId( "ab", 0x1234 ) == memcpy_id( "ab", 0x1234 ) );
+    CHECK( EntityId( "abc" ) == memcpy_id( "abc" ) );
+    CHECK( EntityId( "door", 3 ) == memcpy_id( "door", 3 ) );
+    CHECK( EntityId( "coins", 65535 ) == memcpy_id( "coins", 65535 ) );
+    CHECK( EntityId( "wintex", 2 ) == memcpy_id( "wintex", 2 ) );
+    CHECK( EntityId( "abcdefg" ) == memcpy_id( "abcdefg" ) );
+    CHECK( EntityId( "abcdefgh" ) == memcpy_id( "abcdefgh" ) );
+
+    CHECK( EntityId( "wintex", 2 ).index == 2 );
+    CHECK( std::memcmp( EntityId( "wintex", 2 ).name, "wintex", 6 ) == 0 );
+
+    return check_result();
+}
@@ -0,0 +1,104 @@
+// Andrew Meckling
+// Checks that the command buffer merges LevelScene makes every frame fit
+// in its frame arena: with the arena on top of the context allocator
+// stack, a warmed up frame of merges passes nothing to malloc.
+
+#include "Check.hpp"
+
+#include <ContextAllocator.hpp>
+#include <Odin/EntityCommandBuffer.hpp>
+
+#include <cstdint>
+#include <memory>
+
+using namespace odin;
+
+// LevelScene::FrameMemory.
+using Frame = FrameArena< 256 * 1024 >;
+
+// Like Entity2: a handle, flags and an owning pointer.
+struct Spawn
+{
+    Handle                 handle;
+    unsigned               flags = 0;
+    std::unique_ptr< int > base;
+};
+
+using Commands = ThreadCommandBuffers< std::uint64_t, Spawn >;
+
+// Records a frame's commands from jobs, spread over the workers the way
+// LevelScene's update jobs record them.
+void record( JobSystem& jobs, Commands& commands, int jobCount, std::uint64_t frame )
+{
+    JobCounter counter;
+    for ( int j = 0; j < jobCount; ++j )
+    {
+        jobs.run( [&commands, j, frame] {
+            Commands::Buffer& buffer = commands.local();
+            for ( std::uint64_t i = 0; i < 8; ++i )
+            {
+                std::uint64_t name = (frame * 1000 + j * 8 + i) * 7919 % 100000;
+                buffer.create( name, Spawn { Handle { EntityIndex( i ), 0 }, 0, nullptr } );
+                buffer.destroy( name + 1 );
+                buffer.destroy( Handle { EntityIndex( j ), std::uint32_t( frame ) } );
+                buffer.add< int >( name, int( i ) );
+            }
+        }, &counter );
+    }
+    jobs.wait( counter );
+}
+
+// One frame of LevelScene::update: flip the arena, record, then merge the
+// commands into a batch allocated from the context. Returns the mallocs
+// of the frame before.
+size_t frame( Frame& arena, JobSystem& jobs, Commands& commands, int jobCount, std::uint64_t n )
+{
+    size_t mallocs = arena.flip();
+
+    record( jobs, commands, jobCount, n );
+
+    auto batch = commands.merge( ContextStlAllocator< Spawn >() );
+    CHECK( batch.created().size() == size_t( jobCount * 8 ) );
+    CHECK( batch.destroyedHandles().size() == size_t( jobCount * 8 ) );
+    CHECK( batch.added().size() == size_t( jobCount * 8 ) );
+
+    // Small batches come from the arena itself.
+    if ( jobCount <= 32 )
+        CHECK( arena.owns( batch.created().data() ) );
+
+    return mallocs;
+}
+
+void merges_fit_after_warm_up()
+{
+    std::unique_ptr< Frame > arena( new Frame );
+    PolymorphicAllocator< AllocatorRef< Frame > > context { *arena };
+    context_allocator::push( context );
+
+    JobSystem jobs( 3 );
+    Commands commands( jobs );
+
+    // The first frames size the threads' own buffers.
+    std::uint64_t n = 0;
+    for ( ; n < 3; ++n )
+        frame( *arena, jobs, commands, 32, n );
+
+    for ( ; n < 60; ++n )
+        CHECK( frame( *arena, jobs, commands, 32, n ) == 0 );
+
+    // A frame too big for the arena is counted once it's over, and the
+    // frames after it fit again.
+    frame( *arena, jobs, commands, 4096, n++ );
+    CHECK( frame( *arena, jobs, commands, 32, n++ ) > 0 );
+    CHECK( frame( *arena, jobs, commands, 32, n++ ) == 0 );
+    CHECK( arena->flip() == 0 );
+
+    context_allocator::pop();
+}
+
+int main()
+{
+    merges_fit_after_warm_up();
+
+    return check_result();
+}
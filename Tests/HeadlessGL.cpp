@@ -0,0 +1,208 @@
+// Andrew Meckling
+#include "HeadlessGL.hpp"
+
+#define EGL_NO_X11
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <cstdio>
+
+// The GLEW entry points the engine's renderers and load_shaders use.
+#define HEADLESS_GL_FUNCTIONS( X ) \
+    X( PFNGLACTIVETEXTUREPROC,            ActiveTexture ) \
+    X( PFNGLATTACHSHADERPROC,             AttachShader ) \
+    X( PFNGLBINDBUFFERPROC,               BindBuffer ) \
+    X( PFNGLBINDFRAMEBUFFERPROC,          BindFramebuffer ) \
+    X( PFNGLBINDRENDERBUFFERPROC,         BindRenderbuffer ) \
+    X( PFNGLBINDVERTEXARRAYPROC,          BindVertexArray ) \
+    X( PFNGLBUFFERDATAPROC,               BufferData ) \
+    X( PFNGLBUFFERSUBDATAPROC,            BufferSubData ) \
+    X( PFNGLCHECKFRAMEBUFFERSTATUSPROC,   CheckFramebufferStatus ) \
+    X( PFNGLCOMPILESHADERPROC,            CompileShader ) \
+    X( PFNGLCREATEPROGRAMPROC,            CreateProgram ) \
+    X( PFNGLCREATESHADERPROC,             CreateShader ) \
+    X( PFNGLDELETEBUFFERSPROC,            DeleteBuffers ) \
+    X( PFNGLDELETESHADERPROC,             DeleteShader ) \
+    X( PFNGLDELETEVERTEXARRAYSPROC,       DeleteVertexArrays ) \
+    X( PFNGLDETACHSHADERPROC,             DetachShader ) \
+    X( PFNGLDRAWARRAYSINSTANCEDPROC,      DrawArraysInstanced ) \
+    X( PFNGLENABLEVERTEXATTRIBARRAYPROC,  EnableVertexAttribArray ) \
+    X( PFNGLFRAMEBUFFERRENDERBUFFERPROC,  FramebufferRenderbuffer ) \
+    X( PFNGLGENBUFFERSPROC,               GenBuffers ) \
+    X( PFNGLGENFRAMEBUFFERSPROC,          GenFramebuffers ) \
+    X( PFNGLGENRENDERBUFFERSPROC,         GenRenderbuffers ) \
+    X( PFNGLGENVERTEXARRAYSPROC,          GenVertexArrays ) \
+    X( PFNGLGETPROGRAMINFOLOGPROC,        GetProgramInfoLog ) \
+    X( PFNGLGETPROGRAMIVPROC,             GetProgramiv ) \
+    X( PFNGLGETSHADERINFOLOGPROC,         GetShaderInfoLog ) \
+    X( PFNGLGETSHADERIVPROC,              GetShaderiv ) \
+    X( PFNGLGETUNIFORMLOCATIONPROC,       GetUniformLocation ) \
+    X( PFNGLLINKPROGRAMPROC,              LinkProgram ) \
+    X( PFNGLRENDERBUFFERSTORAGEPROC,      RenderbufferStorage ) \
+    X( PFNGLSHADERSOURCEPROC,             ShaderSource ) \
+    X( PFNGLUNIFORM1FPROC,                Uniform1f ) \
+    X( PFNGLUNIFORM1IPROC,                Uniform1i ) \
+    X( PFNGLUNIFORM2FVPROC,               Uniform2fv ) \
+    X( PFNGLUNIFORM3FVPROC,               Uniform3fv ) \
+    X( PFNGLUNIFORM4FVPROC,               Uniform4fv ) \
+    X( PFNGLUNIFORMMATRIX4FVPROC,         UniformMatrix4fv ) \
+    X( PFNGLUSEPROGRAMPROC,               UseProgram ) \
+    X( PFNGLVERTEXATTRIBDIVISORPROC,      VertexAttribDivisor ) \
+    X( PFNGLVERTEXATTRIBPOINTERPROC,      VertexAttribPointer )
+
+// Definitions of the pointers glew.h declares.
+extern "C" {
+#define HEADLESS_GL_DEFINE( Type, Name ) Type __glew##Name = nullptr;
+HEADLESS_GL_FUNCTIONS( HEADLESS_GL_DEFINE )
+#undef HEADLESS_GL_DEFINE
+}
+
+namespace
+{
+    GLCounters g_counters;
+
+    // The driver's functions behind the counted ones.
+    PFNGLBUFFERDATAPROC          g_bufferData;
+    PFNGLBUFFERSUBDATAPROC       g_bufferSubData;
+    PFNGLDRAWARRAYSINSTANCEDPROC g_drawArraysInstanced;
+
+    void GLAPIENTRY counted_buffer_data( GLenum target, GLsizeiptr size, const void* data, GLenum usage )
+    {
+        if ( data != nullptr )
+        {
+            ++g_counters.uploads;
+            g_counters.uploadedBytes += size_t( size );
+        }
+        g_bufferData( target, size, data, usage );
+    }
+
+    void GLAPIENTRY counted_buffer_sub_data( GLenum target, GLintptr offset, GLsizeiptr size, const void* data )
+    {
+        ++g_counters.uploads;
+        g_counters.uploadedBytes += size_t( size );
+        g_bufferSubData( target, offset, size, data );
+    }
+
+    void GLAPIENTRY counted_draw_arrays_instanced( GLenum mode, GLint first, GLsizei count, GLsizei instances )
+    {
+        ++g_counters.drawCalls;
+        g_drawArraysInstanced( mode, first, count, instances );
+    }
+
+    bool load_functions()
+    {
+        bool loaded = true;
+
+#define HEADLESS_GL_LOAD( Type, Name ) \
+        __glew##Name = (Type) eglGetProcAddress( "gl" #Name ); \
+        if ( __glew##Name == nullptr ) \
+        { \
+            std::printf( "No gl" #Name ".\n" ); \
+            loaded = false; \
+        }
+        HEADLESS_GL_FUNCTIONS( HEADLESS_GL_LOAD )
+#undef HEADLESS_GL_LOAD
+
+        g_bufferData = __glewBufferData;
+        g_bufferSubData = __glewBufferSubData;
+        g_drawArraysInstanced = __glewDrawArraysInstanced;
+        __glewBufferData = counted_buffer_data;
+        __glewBufferSubData = counted_buffer_sub_data;
+        __glewDrawArraysInstanced = counted_draw_arrays_instanced;
+
+        return loaded;
+    }
+
+    EGLDisplay surfaceless_display()
+    {
+        auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)
+            eglGetProcAddress( "eglGetPlatformDisplayEXT" );
+
+        if ( getPlatformDisplay != nullptr )
+        {
+            EGLDisplay display = getPlatformDisplay( EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr );
+            if ( display != EGL_NO_DISPLAY )
+                return display;
+        }
+        return eglGetDisplay( EGL_DEFAULT_DISPLAY );
+    }
+}
+
+bool headless_gl( int width, int height )
+{
+    EGLDisplay display = surfaceless_display();
+    if ( display == EGL_NO_DISPLAY || !eglInitialize( display, nullptr, nullptr ) )
+    {
+        std::printf( "No EGL display.\n" );
+        return false;
+    }
+
+    if ( !eglBindAPI( EGL_OPENGL_API ) )
+    {
+        std::printf( "EGL can't make OpenGL contexts.\n" );
+        return false;
+    }
+
+    const EGLint attribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+
+    // Without a surface the context needs no config.
+    EGLContext context = eglCreateContext( display, EGLConfig( nullptr ), EGL_NO_CONTEXT, attribs );
+    if ( context == EGL_NO_CONTEXT
+         || !eglMakeCurrent( display, EGL_NO_SURFACE, EGL_NO_SURFACE, context ) )
+    {
+        std::printf( "No OpenGL 3.3 context (EGL error 0x%x).\n", unsigned( eglGetError() ) );
+        return false;
+    }
+
+    if ( !load_functions() )
+        return false;
+
+    GLuint color;
+    glGenRenderbuffers( 1, &color );
+    glBindRenderbuffer( GL_RENDERBUFFER, color );
+    glRenderbufferStorage( GL_RENDERBUFFER, GL_RGBA8, width, height );
+
+    GLuint framebuffer;
+    glGenFramebuffers( 1, &framebuffer );
+    glBindFramebuffer( GL_FRAMEBUFFER, framebuffer );
+    glFramebufferRenderbuffer( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color );
+
+    if ( glCheckFramebufferStatus( GL_FRAMEBUFFER ) != GL_FRAMEBUFFER_COMPLETE )
+    {
+        std::printf( "Incomplete framebuffer.\n" );
+        return false;
+    }
+
+    glViewport( 0, 0, width, height );
+    glEnable( GL_BLEND );
+    glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+
+    reset_gl_counters();
+    return true;
+}
+
+const char* headless_gl_renderer()
+{
+    return (const char*) glGetString( GL_RENDERER );
+}
+
+GLCounters& gl_counters()
+{
+    return g_counters;
+}
+
+void reset_gl_counters()
+{
+    g_counters = GLCounters {};
+}
+
+void counted_draw_arrays( GLenum mode, GLint first, GLsizei count )
+{
+    ++g_counters.drawCalls;
+    glDrawArrays( mode, first, count );
+}
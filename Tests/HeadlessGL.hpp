@@ -0,0 +1,38 @@
+// Andrew Meckling
+#pragma once
+
+// An OpenGL 3.3 core context without a window, for benchmarks of the
+// renderers. It's made with EGL on a surfaceless display, so under Mesa
+// it runs on llvmpipe. Drawing goes to an offscreen framebuffer of the
+// requested size. The engine calls GL through GLEW; the entry points it
+// uses are loaded here instead, so GLEW itself isn't needed.
+
+#include <GL/glew.h>
+
+#include <cstddef>
+
+// Benchmarks return this when there's no GL; CTest reports them skipped.
+const int GL_SKIPPED = 77;
+
+// Makes the context current and binds a width by height framebuffer.
+// Returns false, having printed why, if no context could be made.
+bool headless_gl( int width, int height );
+
+// The GL_RENDERER string of the context.
+const char* headless_gl_renderer();
+
+// Calls counted since the last reset_gl_counters().
+struct GLCounters
+{
+    size_t drawCalls;     // glDrawArraysInstanced and counted_draw_arrays.
+    size_t uploads;       // glBufferData and glBufferSubData with data.
+    size_t uploadedBytes;
+};
+
+GLCounters& gl_counters();
+
+void reset_gl_counters();
+
+// glDrawArrays is a GL 1.1 function, so calls to it can't be counted
+// the way the loaded ones are; the old per-sprite paths call this.
+void counted_draw_arrays( GLenum mode, GLint first, GLsizei count );
@@ -0,0 +1,64 @@
+// Andrew Meckling
+// Times JobSystem::parallel_for over a million items with 1 to 8 threads
+// (the calling thread plus 0 to 7 workers). One workload costs the same
+// per item; in the other the cost grows along the range, so the chunks
+// left to steal decide how evenly it spreads.
+
+#include "Bench.hpp"
+
+#include <Odin/JobSystem.hpp>
+
+#include <cmath>
+#include <vector>
+
+const size_t ITEMS = 1 << 20;
+const size_t GRAIN = 1024;
+
+// Milliseconds per parallel_for over the items; work( i ) is the number of
+// square roots item i takes.
+template< typename WorkFn >
+double run( odin::JobSystem& jobs, std::vector< float >& out, size_t reps, WorkFn work )
+{
+    double ns = bench_ns( reps, [&] {
+        jobs.parallel_for( out.size(), GRAIN, [&]( size_t first, size_t last ) {
+            for ( size_t i = first; i < last; ++i )
+            {
+                float x = float( i );
+                for ( size_t k = work( i ); k > 0; --k )
+                    x = std::sqrt( x + 1.0f );
+                out[ i ] = x;
+            }
+        } );
+    } );
+
+    bench_keep( size_t( out[ out.size() / 2 ] ) );
+    return ns / 1e6;
+}
+
+int main( int argc, char** argv )
+{
+    bool quick = bench_quick( argc, argv );
+    size_t reps = quick ? 1 : 20;
+
+    std::vector< float > out( quick ? ITEMS / 64 : ITEMS );
+    const size_t n = out.size();
+
+    std::printf( "Milliseconds per parallel_for of %zu items.\n", n );
+    std::printf( "%8s %10s %10s\n", "threads", "even", "uneven" );
+
+    for ( int threads = 1; threads <= 8; threads *= 2 )
+    {
+        odin::JobSystem jobs( threads - 1 );
+
+        double even = run( jobs, out, reps, []( size_t ) {
+            return size_t( 4 );
+        } );
+        double uneven = run( jobs, out, reps, [n]( size_t i ) {
+            return 1 + 8 * i / n;
+        } );
+
+        std::printf( "%8d %10.2f %10.2f\n", threads, even, uneven );
+    }
+
+    return 0;
+}
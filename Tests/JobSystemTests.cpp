@@ -0,0 +1,192 @@
+// Andrew Meckling
+// Checks JobCounter, runAfter, priorities and jobs which wait on other
+// jobs, with no workers (the waiting thread runs everything) and with some.
+
+#include "Check.hpp"
+
+#include <Odin/JobSystem.hpp>
+
+#include <atomic>
+#include <vector>
+
+using namespace odin;
+
+// A counter is done once every job submitted against it has run.
+void counter_tracks_its_jobs( int threads )
+{
+    JobSystem jobs( threads );
+
+    JobCounter counter;
+    CHECK( counter.done() );
+
+    std::atomic< int > ran { 0 };
+    for ( int i = 0; i < 100; ++i )
+        jobs.run( [&] { ran.fetch_add( 1 ); }, &counter );
+
+    jobs.wait( counter );
+    CHECK( counter.done() );
+    CHECK( ran == 100 );
+
+    // Jobs without a counter still run.
+    JobCounter last;
+    jobs.run( [&] { ran.fetch_add( 1 ); } );
+    jobs.run( [&] { ran.fetch_add( 1 ); }, &last );
+    while ( ran < 102 )
+        jobs.helpOne();
+    jobs.wait( last );
+    CHECK( ran == 102 );
+}
+
+// Continuations start after their dependency is done, or at once if it
+// already is.
+void run_after_waits_for_the_dependency( int threads )
+{
+    JobSystem jobs( threads );
+
+    JobCounter first, second;
+    std::atomic< int > firstRan { 0 };
+    std::atomic< bool > sawAll { false };
+
+    for ( int i = 0; i < 10; ++i )
+        jobs.run( [&] { firstRan.fetch_add( 1 ); }, &first );
+
+    jobs.runAfter( first, [&] { sawAll = firstRan == 10; }, &second );
+    jobs.wait( second );
+    CHECK( first.done() );
+    CHECK( sawAll );
+
+    JobCounter third;
+    bool ran = false;
+    jobs.runAfter( first, [&] { ran = true; }, &third );
+    jobs.wait( third );
+    CHECK( ran );
+}
+
+// Jobs wait on counters of the jobs they submit, three levels deep, and
+// parallel_for is called from inside jobs.
+void nested_waits_finish( int threads )
+{
+    JobSystem jobs( threads );
+
+    std::vector< int > hits( 8 * 8 * 64, 0 );
+    JobCounter outer;
+
+    for ( size_t i = 0; i < 8; ++i )
+    {
+        jobs.run( [&, i] {
+            JobCounter middle;
+            for ( size_t j = 0; j < 8; ++j )
+            {
+                jobs.run( [&, i, j] {
+                    size_t base = (i * 8 + j) * 64;
+                    jobs.parallel_for( 64, 4, [&, base]( size_t first, size_t last ) {
+                        for ( size_t k = first; k < last; ++k )
+                            ++hits[ base + k ];
+                    } );
+                }, &middle );
+            }
+            jobs.wait( middle );
+        }, &outer );
+    }
+
+    jobs.wait( outer );
+
+    bool once = true;
+    for ( int h : hits )
+        once = once && h == 1;
+    CHECK( once );
+}
+
+// parallel_for covers the range exactly once, in chunks of at least grain.
+void parallel_for_covers_the_range( int threads )
+{
+    JobSystem jobs( threads );
+
+    const size_t count = 1001;
+    std::vector< int > hits( count, 0 );
+    std::atomic< bool > smallChunk { false };
+
+    JobCounter counter;
+    jobs.parallel_for( count, 10, [&]( size_t first, size_t last ) {
+        if ( last - first < 10 )
+            smallChunk = true;
+        for ( size_t i = first; i < last; ++i )
+            ++hits[ i ];
+    }, counter );
+    jobs.wait( counter );
+
+    bool once = true;
+    for ( int h : hits )
+        once = once && h == 1;
+    CHECK( once );
+    CHECK( !smallChunk );
+
+    // Nothing to do is done at once.
+    JobCounter empty;
+    jobs.parallel_for( 0, 10, []( size_t, size_t ) {}, empty );
+    CHECK( empty.done() );
+}
+
+// Without workers nothing runs until this thread helps, so the order
+// helpOne picks jobs in can be seen.
+void high_priority_runs_first()
+{
+    JobSystem jobs( 0 );
+    CHECK( jobs.threadIndex() == 0 );
+
+    std::vector< int > order;
+    JobCounter counter;
+    jobs.run( [&] { order.push_back( 1 ); }, &counter, JobPriority::NORMAL );
+    jobs.run( [&] { order.push_back( 2 ); }, &counter, JobPriority::HIGH );
+
+    // Only the high priority job is eligible.
+    CHECK( jobs.helpOne( JobPriority::HIGH ) );
+    CHECK( !jobs.helpOne( JobPriority::HIGH ) );
+    CHECK( !counter.done() );
+
+    jobs.wait( counter );
+    CHECK( order.size() == 2 && order[ 0 ] == 2 && order[ 1 ] == 1 );
+
+    JobStats stats = jobs.endFrame();
+    CHECK( stats.jobsRun == 2 );
+    CHECK( stats.utilisation == 0.0 );
+    CHECK( jobs.endFrame().jobsRun == 0 );
+}
+
+// Workers see their own index; other threads see 0.
+void workers_know_their_index()
+{
+    JobSystem jobs( 3 );
+    CHECK( jobs.threadCount() == 3 );
+
+    std::atomic< bool > inRange { true };
+    JobCounter counter;
+    for ( int i = 0; i < 50; ++i )
+    {
+        jobs.run( [&] {
+            size_t index = jobs.threadIndex();
+            if ( index > 3 )
+                inRange = false;
+        }, &counter );
+    }
+    jobs.wait( counter );
+    CHECK( inRange );
+    CHECK( jobs.threadIndex() == 0 );
+}
+
+int main()
+{
+    const int threads[] = { 0, 1, 3 };
+    for ( int n : threads )
+    {
+        counter_tracks_its_jobs( n );
+        run_after_waits_for_the_dependency( n );
+        nested_waits_finish( n );
+        parallel_for_covers_the_range( n );
+    }
+
+    high_priority_runs_first();
+    workers_know_their_index();
+
+    return check_result();
+}
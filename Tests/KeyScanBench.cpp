@@ -0,0 +1,68 @@
+// Andrew Meckling
+// Finds the number of keys up to which scan_lower_bound beats a binary
+// search, to tune KEY_SCAN_MAX. The scan compiled in depends on the
+// target: build with AVX2 or SSE4.2 enabled to time the SIMD scans.
+
+#include "Bench.hpp"
+
+#include <Odin/SearchLayout.hpp>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using Key = std::uint64_t;
+
+int main( int argc, char** argv )
+{
+    bool quick = bench_quick( argc, argv );
+    size_t lookups = quick ? 1000 : 1000000;
+
+#if defined( ODIN_KEY_SCAN_AVX2 )
+    const char* scan = "AVX2";
+#elif defined( ODIN_KEY_SCAN_SSE42 )
+    const char* scan = "SSE4.2";
+#else
+    const char* scan = "scalar";
+#endif
+
+    std::printf( "Nanoseconds per lower bound of a random key (%s scan).\n", scan );
+    std::printf( "%8s %10s %10s\n", "keys", "scan", "binary" );
+
+    std::mt19937_64 rng( 8551 );
+    size_t crossover = 0;
+
+    for ( size_t n : { 4, 8, 16, 24, 32, 48, 64, 96, 128, 160, 192, 256, 384, 512 } )
+    {
+        std::vector< Key > keys( n );
+        for ( Key& key : keys )
+            key = rng();
+        std::sort( keys.begin(), keys.end() );
+
+        // Hit and miss alike, so the binary search's branches are random.
+        std::vector< Key > queries( lookups );
+        for ( Key& key : queries )
+            key = rng() % 2 ? keys[ rng() % n ] : rng();
+
+        size_t q = 0;
+        size_t sum = 0;
+        double scanNs = bench_ns( lookups, [&] {
+            sum += odin::scan_lower_bound( keys.data(), n, queries[ q++ ] );
+        } );
+
+        q = 0;
+        double binaryNs = bench_ns( lookups, [&] {
+            sum += std::lower_bound( keys.data(), keys.data() + n, queries[ q++ ] ) - keys.data();
+        } );
+        bench_keep( sum );
+
+        if ( scanNs <= binaryNs )
+            crossover = n;
+
+        std::printf( "%8zu %10.1f %10.1f\n", n, scanNs, binaryNs );
+    }
+
+    std::printf( "The scan is faster up to %zu keys; KEY_SCAN_MAX is %zu.\n",
+                 crossover, odin::KEY_SCAN_MAX );
+    return 0;
+}
@@ -0,0 +1,165 @@
+// Andrew Meckling
+#pragma once
+
+// BitsetAllocator as it was before its search went a word at a time,
+// kept so BitsetAllocatorBench can compare the two. Renamed, and
+// std::min takes a copy of BITS_PER_WORD; otherwise unchanged.
+
+#include <Allocators.hpp>
+
+// Allocates memory from this object to its users. Maps individual allocation
+// units of length Align to bits in a bitset. The overhead cost of this type
+// in bytes is (Bytes / Align / 8) or O(n/8).
+template< size_t Bytes, size_t Align = sizeof( int ) >
+class LegacyBitsetAllocator
+{
+public:
+
+    using Word = std::uint64_t;
+
+    static constexpr size_t SIZE = Bytes;
+    static constexpr size_t ALIGNMENT = Align;
+    static constexpr size_t BITS_PER_WORD = 8 * sizeof( Word );
+
+    static_assert( SIZE % ALIGNMENT == 0, "" );
+
+    Word bitset[ SIZE / ALIGNMENT / BITS_PER_WORD + 1 ] = { 0 };
+    byte memory[ SIZE ];
+
+    Blk allocate( size_t size ) noexcept
+    {
+        size_t rounded_size = _round_to_aligned( size );
+        size_t bitlen = rounded_size / ALIGNMENT;
+
+        for ( size_t pos = 0; pos < SIZE - rounded_size; )
+        {
+            if ( _checkRange( pos, bitlen, false, &pos ) )
+            {
+                _setRange( pos, bitlen, true );
+                #ifdef _DEBUG
+                std::memset( memory + pos, 0xbb, size );
+                #endif
+                return { memory + pos, size };
+            }
+        }
+        return { nullptr, size };
+    }
+
+    void deallocate( Blk blk ) noexcept
+    {
+        if ( blk.ptr == nullptr )
+            return;
+
+        assert( owns( blk.ptr ) );
+        #ifdef _DEBUG
+        blk.set( 0xdd );
+        #endif
+        size_t pos = (byte*) blk.ptr - memory;
+        size_t bitlen = _round_to_aligned( blk.size ) / ALIGNMENT;
+        //assert( _checkRange( pos, bitlen, true ) );
+        _setRange( pos, bitlen, false );
+    }
+
+    constexpr bool owns( void* ptr )
+    {
+        return memory <= ptr && ptr < memory + SIZE;
+    }
+
+private:
+
+    // Sets a range in the bitset to bit.
+    void _setRange( size_t pos, size_t len, bool bit ) noexcept
+    {
+        Word* pWord0 = &bitset[ pos / BITS_PER_WORD ];
+        size_t idx0 = pos % BITS_PER_WORD;
+
+        Word* pWord1 = &bitset[ (pos + len) / BITS_PER_WORD ];
+        size_t idx1 = BITS_PER_WORD - (pos + len) % BITS_PER_WORD;
+
+        for ( Word* pWord = pWord0; pWord <= pWord1; ++pWord )
+        {
+            Word mask = ~0;
+
+            if ( pWord == pWord0 )
+                mask = mask >> idx0 << idx0;
+
+            if ( pWord == pWord1 )
+                mask = mask << idx1 >> idx1;
+
+            if ( bit )
+                *pWord |= mask;
+            else
+                *pWord &= ~mask;
+        }
+    }
+
+    // Returns true if all bits in the range in bitset are equal to bit.
+    // Otherwise, sets outpos to the index of the first failing bit and
+    // returns false.
+    bool _checkRange( size_t pos, size_t len, bool bit,
+                      size_t* outpos = nullptr ) const noexcept
+    {
+        const Word* pWord0 = &bitset[ pos / BITS_PER_WORD ];
+        size_t idx0 = pos % BITS_PER_WORD;
+
+        const Word* pWord1 = &bitset[ (pos + len) / BITS_PER_WORD ];
+        size_t idx1 = BITS_PER_WORD - (pos + len) % BITS_PER_WORD;
+
+        for ( const Word* pWord = pWord0; pWord <= pWord1; ++pWord )
+        {
+            Word mask = ~0;
+
+            if ( pWord == pWord0 )
+                mask = mask >> idx0 << idx0;
+
+            if ( pWord == pWord1 )
+                mask = mask << idx1 >> idx1;
+
+            if ( (*pWord & mask) != (bit ? mask : 0) )
+            {
+                if ( outpos != nullptr )
+                {
+                    size_t offset = _skip( *pWord, mask, bit ) * ALIGNMENT;
+                    size_t chunk = (pWord - bitset) * BITS_PER_WORD;
+                    *outpos = _round_to_aligned( chunk + offset );
+                }
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static size_t _skip( Word word, Word mask, bool bit )
+    {
+        size_t offset;
+        if ( bit ) {
+            offset =  _first_0( word & mask );    // Skip 1s
+            offset += _first_1( word >> offset ); // Skip 0s
+        } else {
+            offset =  _first_1( word & mask );    // Skip 0s
+            offset += _first_0( word >> offset ); // Skip 1s
+        }
+        return std::min( offset, size_t( BITS_PER_WORD ) );
+    }
+
+    static size_t _first_1( Word word )
+    {
+        size_t pos = 0;
+        while ( !(word & 1) && ++pos < BITS_PER_WORD )
+            word >>= 1;
+        return pos;
+    }
+
+    static size_t _first_0( Word word )
+    {
+        size_t pos = 0;
+        while ( (word & 1) && ++pos < BITS_PER_WORD )
+            word >>= 1;
+        return pos;
+    }
+
+    static constexpr size_t _round_to_aligned( size_t size )
+    {
+        return round_to_alignment( size, ALIGNMENT );
+    }
+};
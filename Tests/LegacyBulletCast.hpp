@@ -0,0 +1,49 @@
+// Andrew Meckling
+#pragma once
+
+// LevelScene::resolveBulletCollision's search as it was before it went
+// through the broadphase, kept so RaycastBench can compare the two. It
+// returns the fixture instead of its entity; otherwise unchanged.
+
+#include <Box2D/Box2D.h>
+
+struct LegacyBulletHit
+{
+    b2Fixture* fixture = nullptr;
+    b2Vec2     normal = { 0, 0 };
+    float32    fraction = 1;
+};
+
+// Ray casts every fixture of every body and keeps the closest one past
+// delta which collides with bullets.
+inline LegacyBulletHit legacy_bullet_cast( b2World& world, b2Vec2 p1, b2Vec2 p2, uint16 bulletBits, float32 delta = 0.001f )
+{
+    b2RayCastInput input;
+    input.p1 = p1;
+    input.p2 = p2;
+    input.maxFraction = 1;
+
+    LegacyBulletHit hit;
+
+    for ( b2Body* body = world.GetBodyList(); body; body = body->GetNext() )
+    {
+        for ( b2Fixture* f = body->GetFixtureList(); f; f = f->GetNext() )
+        {
+            b2RayCastOutput output;
+            if ( !f->RayCast( &output, input, 0 ) )
+                continue;
+
+            if ( !(f->GetFilterData().maskBits & bulletBits) )
+                continue;
+
+            if ( output.fraction < hit.fraction && output.fraction > delta )
+            {
+                hit.fraction = output.fraction;
+                hit.normal = output.normal;
+                hit.fixture = f;
+            }
+        }
+    }
+
+    return hit;
+}
@@ -0,0 +1,111 @@
+// Andrew Meckling
+#pragma once
+
+// LevelScene's entities as they were before the registry, kept so
+// RegistryBench can compare the two: a map from names to entities which
+// point at their components in TypedAllocator slabs. The EntityBase is
+// left out, and the update and draw-prep loops are collected into
+// functions. Fading entities aren't destroyed, and drawing goes into a
+// SpriteBatch as it did just before the registry; otherwise unchanged.
+
+#include <TypedAllocator.hpp>
+
+#include <Box2D/Box2D.h>
+#include <Odin/BinarySearchMap.hpp>
+#include <Odin/EntityId.hpp>
+#include <Odin/SpriteBatch.hpp>
+
+#include <glm/glm.hpp>
+
+#include <utility>
+
+struct LegacyEntity
+{
+    glm::vec2 position = { 0, 0 };
+    float     rotation = 0;
+    unsigned  flags = 0;
+
+    b2Body*                   pBody = nullptr;
+    odin::GraphicalComponent* pDrawable = nullptr;
+    odin::AnimatorComponent*  pAnimator = nullptr;
+
+    LegacyEntity() = default;
+
+    LegacyEntity( LegacyEntity&& move )
+        : position( move.position )
+        , rotation( move.rotation )
+        , flags( move.flags )
+        , pBody( move.pBody )
+        , pDrawable( move.pDrawable )
+        , pAnimator( move.pAnimator )
+    {
+        move.pBody = nullptr;
+        move.pDrawable = nullptr;
+        move.pAnimator = nullptr;
+    }
+
+    LegacyEntity& operator =( LegacyEntity&& move )
+    {
+        position = move.position;
+        rotation = move.rotation;
+        flags = move.flags;
+        std::swap( pBody, move.pBody );
+        std::swap( pDrawable, move.pDrawable );
+        std::swap( pAnimator, move.pAnimator );
+        return *this;
+    }
+};
+
+using LegacyEntityMap = odin::BinarySearchMap< odin::EntityId, LegacyEntity >;
+
+// Copies body transforms into their entities.
+inline void legacy_sync_transforms( LegacyEntityMap& entities )
+{
+    for ( auto x : entities )
+    {
+        LegacyEntity& ntt = x.value;
+        if ( auto body = ntt.pBody )
+        {
+            b2Vec2 pos = body->GetPosition();
+            ntt.position = glm::round( glm::vec2( pos.x, pos.y ) * 10.0f );
+            ntt.rotation = body->GetAngle();
+        }
+    }
+}
+
+// Advances every animator by one frame and fades out the fading ones.
+inline void legacy_tick_animators( LegacyEntityMap& entities )
+{
+    for ( auto x : entities )
+        if ( auto animator = x.value.pAnimator )
+            animator->incrementFrame();
+
+    for ( auto x : entities )
+    {
+        LegacyEntity& ntt = x.value;
+        if ( auto animator = ntt.pAnimator )
+        {
+            if ( animator->type == odin::AnimationType::FADEOUT
+                 && animator->currentFrame != animator->maxFrames - 1 )
+            {
+                ntt.pDrawable->color.a = 1.f - (float) animator->currentFrame / (float) animator->maxFrames;
+            }
+        }
+    }
+}
+
+// Queues every visible drawable, in name order.
+inline void legacy_draw_prep( LegacyEntityMap& entities, odin::SpriteBatch& batch )
+{
+    for ( auto x : entities )
+    {
+        LegacyEntity& ntt = x.value;
+        if ( auto drawable = ntt.pDrawable )
+        {
+            if ( !drawable->visible )
+                continue;
+
+            batch.add( *drawable, ntt.pAnimator, ntt.position, ntt.rotation, drawable->color );
+        }
+    }
+}
@@ -0,0 +1,75 @@
+// Andrew Meckling
+#pragma once
+
+// The array-of-structures particles ParticleEmitter kept before
+// ParticleStore, kept so ParticleStoreBench can compare the two. The
+// OpenCL vector types are glm's here, and spawning is left out since it
+// hasn't changed; the update is otherwise unchanged.
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+struct LegacyParticle
+{
+    float     lifetime;
+    glm::vec4 color = { 1, 1, 1, 1 };
+    glm::vec2 position = { 0, 0 };
+    glm::vec2 velocity = { 0, 0 };
+
+    LegacyParticle() = default;
+
+    LegacyParticle( float lifetime, glm::vec4 color,
+                    glm::vec2 pos, glm::vec2 vel )
+        : lifetime( lifetime )
+        , color( color )
+        , position( pos )
+        , velocity( vel )
+    {
+    }
+
+    bool isExpired() const
+    {
+        return lifetime <= 0;
+    }
+
+    static void default_update( LegacyParticle& p, float step )
+    {
+        p.lifetime -= step;
+        p.position.x += p.velocity.x * step;
+        p.position.y += p.velocity.y * step;
+    }
+};
+
+class LegacyParticleEmitter
+{
+public:
+
+    std::vector< LegacyParticle > particles;
+
+    std::function< void( LegacyParticle&, float ) > fnUpdate;
+
+    void update( float timeStep )
+    {
+        for ( LegacyParticle& p : particles )
+        {
+            p.velocity.y += -100 * timeStep;
+            LegacyParticle::default_update( p, timeStep );
+        }
+
+        auto split = std::remove_if( particles.begin(), particles.end(),
+            []( LegacyParticle& p ) {
+                return p.isExpired();
+            } );
+
+        if ( fnUpdate )
+            std::for_each( particles.begin(), split,
+                [this, timeStep]( LegacyParticle& p ) {
+                    fnUpdate( p, timeStep );
+                } );
+
+        particles.erase( split, particles.end() );
+    }
+};
@@ -0,0 +1,218 @@
+// Andrew Meckling
+#pragma once
+
+// b2ThreadPool as it was before it moved to work-stealing deques, kept so
+// Box2DStepBench can compare the two. Renamed, made a header, and built
+// on the b2TaskExecutor interface; otherwise unchanged.
+
+#include <Box2D/Common/b2StackAllocator.h>
+#include <Box2D/Common/b2Threading.h>
+#include <Box2D/Common/b2Math.h>
+#include <algorithm>
+#include <new>
+
+/// Executes tasks from one cost-sorted heap guarded by a mutex.
+class LegacyThreadPool : public b2TaskExecutor
+{
+public:
+	LegacyThreadPool(int32 threadCount = -1)
+	: m_pendingTasks(256)
+	{
+		b2Assert(threadCount <= b2_maxThreadPoolThreads);
+		b2Assert(threadCount >= -1);
+
+		if (threadCount == -1)
+		{
+			// Match the number of cores, minus one for the user thread.
+			threadCount = (int32)std::thread::hardware_concurrency() - 1;
+		}
+
+		// Don't exceed the max.
+		threadCount = b2Min(threadCount, b2_maxThreadPoolThreads);
+
+		// Account for invalid input, single core processors, or hardware_concurrency not being well defined.
+		threadCount = b2Max(threadCount, 0);
+
+		// Mark the pool as running.
+		m_signalShutdown = false;
+
+		// Set the thread count.
+		m_threadCount = threadCount;
+		m_threads = NULL;
+
+		// Construct worker threads.
+		if (threadCount > 0)
+		{
+			m_threads = (std::thread*)b2Alloc(threadCount * sizeof(std::thread));
+			for (int32 i = 0; i < threadCount; ++i)
+			{
+				new(&m_threads[i]) std::thread(&LegacyThreadPool::WorkerMain, this, 1 + i);
+			}
+		}
+	}
+
+	~LegacyThreadPool()
+	{
+		// Wake up the threads.
+		{
+			std::unique_lock<std::mutex> lk(m_taskMut);
+			m_signalShutdown = true;
+		}
+		m_taskAddedCond.notify_all();
+
+		// Wait for them to finish.
+		for (int32 i = 0; i < m_threadCount; ++i)
+		{
+			m_threads[i].join();
+			m_threads[i].~thread();
+		}
+		b2Free(m_threads);
+	}
+
+	int32 GetThreadCount() const
+	{
+		return m_threadCount;
+	}
+
+protected:
+	void AddTasks(b2Task** tasks, int32 count)
+	{
+		{
+			std::unique_lock<std::mutex> lk(m_taskMut);
+			for (int32 i = 0; i < count; ++i)
+			{
+				m_pendingTasks.Push(tasks[i]);
+				std::push_heap(m_pendingTasks.Data(), m_pendingTasks.Data() + m_pendingTasks.GetCount(), LessThan);
+			}
+		}
+
+		m_taskAddedCond.notify_all();
+	}
+
+	void AddTask(b2Task* task)
+	{
+		{
+			std::unique_lock<std::mutex> lk(m_taskMut);
+			m_pendingTasks.Push(task);
+			std::push_heap(m_pendingTasks.Data(), m_pendingTasks.Data() + m_pendingTasks.GetCount(), LessThan);
+		}
+
+		m_taskAddedCond.notify_one();
+	}
+
+	void Wait(const b2TaskGroup& taskGroup, b2StackAllocator& allocator)
+	{
+		while (!IsFinished(taskGroup))
+		{
+			b2Task* task = NULL;
+
+			// Try to execute a task
+			{
+				std::lock(m_taskMut, m_taskGroupMut);
+				std::lock_guard<std::mutex> lk1(m_taskMut, std::adopt_lock);
+				std::lock_guard<std::mutex> lk2(m_taskGroupMut, std::adopt_lock);
+
+				// Make sure our group didn't finish between the last check and acquiring the locks.
+				if (IsFinished(taskGroup))
+				{
+					return;
+				}
+
+				// Consume a task.
+				if (m_pendingTasks.GetCount() > 0)
+				{
+					std::pop_heap(m_pendingTasks.Data(), m_pendingTasks.Data() + m_pendingTasks.GetCount(), LessThan);
+					task = m_pendingTasks.Pop();
+				}
+			}
+
+			if (task == NULL)
+			{
+				// No more tasks to execute.
+				std::unique_lock<std::mutex> lk(m_taskGroupMut);
+				m_taskGroupFinishedCond.wait(lk, [&taskGroup]() -> bool
+				{
+					return IsFinished(taskGroup);
+				});
+
+				return;
+			}
+
+			// Execute the task, and if it was the last task in its group, let waiting threads know.
+			if (ExecuteTask(task, allocator))
+			{
+				NotifyGroupFinished();
+			}
+		}
+	}
+
+private:
+	static bool LessThan(const b2Task* l, const b2Task* r)
+	{
+		return l->GetCost() < r->GetCost();
+	}
+
+	void WorkerMain(int32 threadId)
+	{
+		b2SetThreadId(threadId);
+
+		b2StackAllocator allocator;
+
+		for (;;)
+		{
+			b2Task* task = NULL;
+
+			{
+				std::unique_lock<std::mutex> lk(m_taskMut);
+
+				// Wait for tasks to be added, or for the pool to shutdown.
+				m_taskAddedCond.wait(lk, [this]() -> bool
+				{
+					return m_signalShutdown || m_pendingTasks.GetCount() > 0;
+				});
+
+				// Is the pool shutting down?
+				if (m_signalShutdown)
+				{
+					// Shutting down in the middle of processing tasks is not supported.
+					b2Assert(m_pendingTasks.GetCount() == 0);
+
+					return;
+				}
+
+				// Consume a task.
+				std::pop_heap(m_pendingTasks.Data(), m_pendingTasks.Data() + m_pendingTasks.GetCount(), LessThan);
+				task = m_pendingTasks.Pop();
+			}
+
+			// Execute the task, and if it was the last task in its group, let waiting threads know.
+			if (ExecuteTask(task, allocator))
+			{
+				NotifyGroupFinished();
+			}
+		}
+	}
+
+	void NotifyGroupFinished()
+	{
+		// Sync with the waiting thread to ensure it reads '0' from the group's remaining tasks count.
+		{
+			std::unique_lock<std::mutex> lk(m_taskGroupMut);
+		}
+
+		m_taskGroupFinishedCond.notify_all();
+	}
+
+	b2GrowableArray<b2Task*> m_pendingTasks;
+
+	std::mutex m_taskMut;
+	std::condition_variable m_taskAddedCond;
+
+	std::mutex m_taskGroupMut;
+	std::condition_variable m_taskGroupFinishedCond;
+
+	std::thread* m_threads;
+	int32 m_threadCount;
+
+	bool m_signalShutdown;
+};
@@ -0,0 +1,174 @@
+// Andrew Meckling
+// Draws N particles a frame into a 1280x720 offscreen framebuffer, the way
+// TestScene::draw did before ParticleBatch (a matrix, a color and a draw
+// call per particle) and with ParticleBatch, and counts the draw calls and
+// buffer uploads of each. Particles sit in emitters of 500, filled from
+// ParticleStore like TestScene does. Runs on whatever EGL gives, which is
+// llvmpipe under Mesa; skipped where there's no GL.
+
+#include "Bench.hpp"
+#include "HeadlessGL.hpp"
+
+#include <Odin/ParticleBatch.hpp>
+#include <Odin/GraphicalComponent.hpp>
+
+#include <ParticleStore.hpp>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <random>
+#include <vector>
+
+const int WIDTH = 1280;
+const int HEIGHT = 720;
+const size_t PER_EMITTER = 500;
+
+std::vector< ParticleStore > make_emitters( size_t n )
+{
+    std::mt19937 rng( 8551 );
+    std::uniform_real_distribution< float > x( 0, WIDTH ), y( 0, HEIGHT ), unit( 0, 1 );
+
+    std::vector< ParticleStore > emitters( (n + PER_EMITTER - 1) / PER_EMITTER );
+    for ( size_t i = 0; i < n; ++i )
+    {
+        glm::vec4 color = { unit( rng ), unit( rng ), unit( rng ), 1 };
+        emitters[ i / PER_EMITTER ].push( 1, color, { x( rng ), y( rng ) }, { 0, 0 } );
+    }
+    return emitters;
+}
+
+// A white texel on unit 0, like NULL_TEXTURE.
+void make_texture()
+{
+    const GLuint white = 0xffffffff;
+
+    GLuint texture;
+    glGenTextures( 1, &texture );
+    glActiveTexture( GL_TEXTURE0 );
+    glBindTexture( GL_TEXTURE_2D, texture );
+    glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, &white );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+}
+
+// TestScene::draw before ParticleBatch.
+class PerParticleDraw
+{
+public:
+
+    PerParticleDraw()
+        : program( load_shaders( ODIN_SHADERS "vertexAnim.glsl", ODIN_SHADERS "fragmentShader.glsl" ) )
+        , gfx( odin::GraphicalComponent::makeRect( 1, 1 ) )
+        , uMatrix( glGetUniformLocation( program, "uMatrix" ) )
+        , uColor( glGetUniformLocation( program, "uColor" ) )
+    {
+    }
+
+    void draw( const glm::mat4& cameraMatrix, const std::vector< ParticleStore >& emitters )
+    {
+        using namespace glm;
+
+        glUseProgram( program );
+        glUniform( glGetUniformLocation( program, "uTexture" ), 0 );
+        glUniform( glGetUniformLocation( program, "uFacingDirection" ), 1 );
+        glUniform( glGetUniformLocation( program, "uCurrentAnim" ), 0.0f );
+        glUniform( glGetUniformLocation( program, "uCurrentFrame" ), 0.0f );
+        glUniform( glGetUniformLocation( program, "uMaxFrames" ), 1.0f );
+        glUniform( glGetUniformLocation( program, "uTotalAnim" ), 1.0f );
+
+        glBindVertexArray( gfx.vertexArray );
+
+        for ( const ParticleStore& ps : emitters )
+        {
+            for ( size_t i = 0; i < ps.size(); ++i )
+            {
+                glUniform( uMatrix, cameraMatrix * translate( mat4( 1 ), vec3( ps.px[ i ], ps.py[ i ], 0 ) ) );
+                glUniform( uColor, vec4( ps.r[ i ], ps.g[ i ], ps.b[ i ], ps.a[ i ] ) );
+                counted_draw_arrays( GL_TRIANGLES, 0, gfx.count );
+            }
+        }
+    }
+
+private:
+
+    GLuint                   program;
+    odin::GraphicalComponent gfx;
+    GLint                    uMatrix, uColor;
+};
+
+struct Frames
+{
+    double ms;
+    double drawCalls;
+    double uploads;
+};
+
+// Times frames including the GL work, so glFinish ends each one.
+template< typename DrawFn >
+Frames time_frames( size_t frames, DrawFn&& draw )
+{
+    draw(); // Warm up the driver's buffers and shader variants.
+    glFinish();
+
+    reset_gl_counters();
+    double ns = bench_ns( frames, [&] {
+        glClear( GL_COLOR_BUFFER_BIT );
+        draw();
+        glFinish();
+    } );
+
+    return { ns / 1e6, double( gl_counters().drawCalls ) / frames,
+             double( gl_counters().uploads ) / frames };
+}
+
+int main( int argc, char** argv )
+{
+    bool quick = bench_quick( argc, argv );
+
+    if ( !headless_gl( WIDTH, HEIGHT ) )
+        return GL_SKIPPED;
+
+    make_texture();
+
+    const glm::mat4 camera = glm::ortho( 0.0f, float( WIDTH ), 0.0f, float( HEIGHT ) );
+    PerParticleDraw perParticle;
+    odin::ParticleBatch batch( load_shaders( ODIN_SHADERS "vertexParticle.glsl", ODIN_SHADERS "fragmentInstanced.glsl" ), 2048 );
+
+    std::printf( "\n%s, %dx%d. Per frame:\n", headless_gl_renderer(), WIDTH, HEIGHT );
+    std::printf( "%9s | %12s %8s %8s | %10s %8s %8s\n",
+                 "particles", "per particle", "draws", "uploads", "batch", "draws", "uploads" );
+
+    const size_t counts[] = { 10000, 100000 };
+    for ( size_t n : counts )
+    {
+        if ( quick )
+            n /= 10;
+
+        std::vector< ParticleStore > emitters = make_emitters( n );
+        size_t frames = quick ? 1 : 10;
+
+        Frames old = time_frames( frames, [&] {
+            perParticle.draw( camera, emitters );
+        } );
+
+        Frames batched = time_frames( frames, [&] {
+            batch.begin( camera );
+            for ( const ParticleStore& ps : emitters )
+            {
+                auto* out = batch.append( ps.size() );
+                for ( size_t i = 0; i < ps.size(); ++i )
+                {
+                    out[ i ].position = { ps.px[ i ], ps.py[ i ] };
+                    out[ i ].color = { ps.r[ i ], ps.g[ i ], ps.b[ i ], ps.a[ i ] };
+                }
+            }
+            batch.end( 0 );
+        } );
+
+        std::printf( "%9zu | %10.2fms %8.0f %8.0f | %8.2fms %8.0f %8.0f\n", n,
+                     old.ms, old.drawCalls, old.uploads,
+                     batched.ms, batched.drawCalls, batched.uploads );
+    }
+
+    return 0;
+}
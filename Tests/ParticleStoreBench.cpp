@@ -0,0 +1,92 @@
+// Andrew Meckling
+// Times a frame of particle updates, from 1k to 1M particles, with the
+// old array-of-structures emitter (remove_if and a std::function fade)
+// and with ParticleStore (SSE integrate and swap-remove compact). Both
+// start from the same particles, with lifetimes spread so some expire
+// every frame, and should keep the same number alive.
+
+#include "Bench.hpp"
+#include "LegacyParticleEmitter.hpp"
+
+#include <ParticleStore.hpp>
+
+#include <random>
+
+const float TIME_STEP = 1.0f / 60.0f;
+const float GRAVITY = -100;
+const float FADE_RATE = 1.0f / 3;
+
+struct Result
+{
+    double us;
+    size_t alive;
+};
+
+Result run_legacy( const std::vector< LegacyParticle >& start, size_t frames )
+{
+    LegacyParticleEmitter emitter;
+    emitter.particles = start;
+    emitter.fnUpdate = []( LegacyParticle& p, float timeStep ) {
+        p.color.w -= timeStep * FADE_RATE;
+    };
+
+    double ns = bench_ns( frames, [&] {
+        emitter.update( TIME_STEP );
+    } );
+
+    return { ns / 1e3, emitter.particles.size() };
+}
+
+Result run_store( const std::vector< LegacyParticle >& start, size_t frames )
+{
+    ParticleStore store;
+    store.reserve( start.size() );
+    for ( const LegacyParticle& p : start )
+        store.push( p.lifetime, p.color, p.position, p.velocity );
+
+    double ns = bench_ns( frames, [&] {
+        store.integrate( TIME_STEP, GRAVITY, FADE_RATE );
+        store.compact();
+    } );
+
+    return { ns / 1e3, store.size() };
+}
+
+int main( int argc, char** argv )
+{
+    bool quick = bench_quick( argc, argv );
+    size_t frames = quick ? 2 : 60;
+
+    std::printf( "Microseconds per frame over %zu frames, and the particles left alive.\n", frames );
+    std::printf( "%9s %12s %12s %9s %9s\n", "particles", "AoS", "SoA", "AoS left", "SoA left" );
+
+    const size_t counts[] = { 1000, 10000, 100000, 1000000 };
+    for ( size_t n : counts )
+    {
+        if ( quick )
+            n /= 100;
+
+        std::mt19937 rng( 8551 );
+        std::uniform_real_distribution< float > life( 0, 2 ), pos( 0, 100 ), vel( -50, 50 );
+
+        std::vector< LegacyParticle > start;
+        start.reserve( n );
+        for ( size_t i = 0; i < n; ++i )
+            start.emplace_back( life( rng ), glm::vec4( 1 ),
+                                glm::vec2( pos( rng ), pos( rng ) ),
+                                glm::vec2( vel( rng ), vel( rng ) ) );
+
+        Result aos = run_legacy( start, frames );
+        Result soa = run_store( start, frames );
+
+        std::printf( "%9zu %10.1fus %10.1fus %9zu %9zu\n", n, aos.us, soa.us, aos.alive, soa.alive );
+
+        if ( aos.alive != soa.alive )
+        {
+            std::printf( "The two updates disagree on how many particles expired.\n" );
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,213 @@
+// Andrew Meckling
+// Checks that PhysicsExecutor hands every executing task a thread id no
+// other thread is using at the same time, including tasks which wait on
+// tasks of their own, that its tasks run before queued NORMAL jobs, and
+// that a world stepped with it matches one stepped with a b2ThreadPool.
+
+#include "Check.hpp"
+#include "Box2DScenes.hpp"
+
+#include <Odin/PhysicsExecutor.hpp>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+using namespace odin;
+
+// Tracks which thread holds each Box2D thread id.
+struct IdOwners
+{
+    std::atomic< std::thread::id > owner[ b2_maxThreads ];
+    std::atomic< bool >            shared { false };
+    std::atomic< bool >            outOfRange { false };
+    std::atomic< int >             ran { 0 };
+
+    IdOwners()
+    {
+        for ( auto& o : owner )
+            o.store( std::thread::id() );
+    }
+};
+
+// Holds its thread id for a while. Tasks with children submit them to
+// the same executor and wait for them, which runs some of them on this
+// thread with this id.
+class IdTask
+    : public b2Task
+{
+public:
+
+    IdOwners*       owners = nullptr;
+    b2TaskExecutor* executor = nullptr;
+    int32           children = 0;
+
+    void Execute( b2StackAllocator& allocator ) override
+    {
+        int32 id = b2GetThreadId();
+        if ( id < 0 || id > executor->GetThreadCount() )
+        {
+            owners->outOfRange = true;
+            return;
+        }
+
+        // A thread may hold its id again while running its own children.
+        std::thread::id self = std::this_thread::get_id();
+        std::thread::id none;
+        bool claimed = owners->owner[ id ].compare_exchange_strong( none, self );
+        if ( !claimed && none != self )
+            owners->shared = true;
+
+        std::this_thread::sleep_for( std::chrono::microseconds( 50 ) );
+
+        if ( children > 0 )
+        {
+            std::unique_ptr< IdTask[] > tasks( new IdTask[ children ] );
+            b2TaskGroup group( *executor );
+            for ( int32 i = 0; i < children; ++i )
+            {
+                tasks[ i ].owners = owners;
+                tasks[ i ].executor = executor;
+                group.SubmitTask( &tasks[ i ] );
+            }
+            group.Wait( allocator );
+        }
+
+        if ( claimed )
+            owners->owner[ id ].store( none );
+
+        owners->ran.fetch_add( 1 );
+    }
+};
+
+// 16 tasks with 8 children each, on more workers than there are ids, so
+// workers queue up for ids and waiting threads run the children.
+void tasks_see_distinct_ids( b2TaskExecutor& executor )
+{
+    IdOwners owners;
+    IdTask tasks[ 16 ];
+    b2StackAllocator allocator;
+
+    b2TaskGroup group( executor );
+    for ( IdTask& task : tasks )
+    {
+        task.owners = &owners;
+        task.executor = &executor;
+        task.children = 8;
+        group.SubmitTask( &task );
+    }
+    group.Wait( allocator );
+
+    CHECK( owners.ran == 16 * 9 );
+    CHECK( !owners.shared );
+    CHECK( !owners.outOfRange );
+    CHECK( b2GetThreadId() == 0 );
+}
+
+// The only worker is busy, so this thread runs the physics tasks itself
+// and must not pick up the NORMAL jobs queued before them.
+void high_runs_before_normal()
+{
+    JobSystem jobs( 1 );
+    PhysicsExecutor executor( jobs );
+
+    std::atomic< bool > release { false };
+    std::atomic< bool > blocking { false };
+    std::atomic< int > normalRan { 0 };
+    JobCounter counter;
+
+    jobs.run( [&] {
+        blocking = true;
+        while ( !release )
+            std::this_thread::yield();
+    }, &counter );
+
+    while ( !blocking )
+        std::this_thread::yield();
+
+    for ( int i = 0; i < 20; ++i )
+        jobs.run( [&] { normalRan.fetch_add( 1 ); }, &counter );
+
+    IdOwners owners;
+    IdTask tasks[ 4 ];
+    b2StackAllocator allocator;
+    b2TaskGroup group( executor );
+    for ( IdTask& task : tasks )
+    {
+        task.owners = &owners;
+        task.executor = &executor;
+        group.SubmitTask( &task );
+    }
+    group.Wait( allocator );
+
+    CHECK( owners.ran == 4 );
+    CHECK( normalRan == 0 );
+
+    release = true;
+    jobs.wait( counter );
+    CHECK( normalRan == 20 );
+
+    // Both threads ran jobs; the worker was busy for part of the frame.
+    JobStats stats = jobs.endFrame();
+    CHECK( stats.jobsRun == 1 + 20 + 4 );
+    CHECK( stats.utilisation > 0.0 && stats.utilisation <= 1.0 );
+    CHECK( jobs.endFrame().jobsRun == 0 );
+}
+
+std::unique_ptr< b2World > step_scene( b2TaskExecutor* executor )
+{
+    std::unique_ptr< b2World > world( new b2World( b2Vec2( 0.0f, -10.0f ), executor ) );
+
+    ground( *world, -50.0f, 150.0f );
+    wall( *world, -40.0f, 20, 25 );
+    pyramid( *world, -10.0f, 20 );
+
+    for ( int32 i = 0; i < 30; ++i )
+        world->Step( 1.0f / 60.0f, 8, 3 );
+
+    return world;
+}
+
+// Stepping while cosmetic jobs are queued gives the same bodies as a
+// thread pool with as many threads.
+void step_matches_thread_pool( PhysicsExecutor& executor, JobSystem& jobs )
+{
+    std::atomic< int > normalRan { 0 };
+    JobCounter counter;
+    for ( int i = 0; i < 200; ++i )
+    {
+        jobs.run( [&] {
+            std::this_thread::sleep_for( std::chrono::microseconds( 20 ) );
+            normalRan.fetch_add( 1 );
+        }, &counter );
+    }
+
+    std::unique_ptr< b2World > world = step_scene( &executor );
+
+    jobs.wait( counter );
+    CHECK( normalRan == 200 );
+
+    b2ThreadPool pool( executor.GetThreadCount() );
+    std::unique_ptr< b2World > expected = step_scene( &pool );
+    CHECK( same_bodies( *expected, *world ) );
+}
+
+int main()
+{
+    {
+        JobSystem jobs( b2_maxThreadPoolThreads + 2 );
+        PhysicsExecutor executor( jobs );
+        CHECK( executor.GetThreadCount() == b2_maxThreadPoolThreads );
+
+        tasks_see_distinct_ids( executor );
+        step_matches_thread_pool( executor, jobs );
+    }
+
+    high_runs_before_normal();
+
+    // The shared executor has as many threads as the machine has cores.
+    tasks_see_distinct_ids( physics_executor() );
+    step_matches_thread_pool( physics_executor(), job_system() );
+
+    return check_result();
+}
@@ -0,0 +1,138 @@
+// Andrew Meckling
+// Times PoolAllocator against malloc and a SlabAllocator behind a mutex,
+// with 1 to 8 threads. Each thread allocates batches of blocks, frees
+// most of them itself and passes a quarter to the next thread, which
+// frees them there.
+
+#include "Bench.hpp"
+
+#include <PoolAllocator.hpp>
+
+#include <mutex>
+#include <thread>
+#include <vector>
+
+const size_t BLOCKS = 1 << 15;
+
+// Any allocator made thread safe with one lock.
+template< typename Allocator >
+class Locked
+    : protected Allocator
+{
+public:
+
+    Blk allocate( size_t size )
+    {
+        std::lock_guard< std::mutex > guard( _lock );
+        return Allocator::allocate( size );
+    }
+
+    void deallocate( Blk blk )
+    {
+        std::lock_guard< std::mutex > guard( _lock );
+        Allocator::deallocate( blk );
+    }
+
+private:
+
+    std::mutex _lock;
+};
+
+using Malloc = Mallocator;
+using Slab   = Locked< SlabAllocator< 64, BLOCKS > >;
+using Pool   = PoolAllocator< 64, BLOCKS >;
+
+// Static, since the pool is aligned to cache lines, which new only
+// honours from C++17 on.
+Malloc g_malloc;
+Slab   g_slab;
+Pool   g_pool;
+
+// Threads give their cached blocks back to the pool before they exit.
+template< typename Allocator >
+void release( Allocator& )
+{
+}
+
+void release( Pool& pool )
+{
+    pool.release();
+}
+
+struct Handoff
+{
+    std::mutex         lock;
+    std::vector< Blk > blocks;
+};
+
+template< typename Allocator >
+double run( Allocator& allocator, size_t threads, size_t rounds )
+{
+    std::vector< Handoff > handoffs( threads );
+
+    auto worker = [&]( size_t self ) {
+        std::vector< Blk > batch;
+        std::vector< Blk > received;
+        Handoff& next = handoffs[ (self + 1) % threads ];
+
+        for ( size_t round = 0; round < rounds; ++round )
+        {
+            for ( size_t i = 0; i < 64; ++i )
+                batch.push_back( allocator.allocate( 64 ) );
+
+            {
+                std::lock_guard< std::mutex > guard( next.lock );
+                next.blocks.insert( next.blocks.end(), batch.end() - 16, batch.end() );
+            }
+            batch.resize( batch.size() - 16 );
+
+            for ( Blk blk : batch )
+                allocator.deallocate( blk );
+            batch.clear();
+
+            {
+                std::lock_guard< std::mutex > guard( handoffs[ self ].lock );
+                received.swap( handoffs[ self ].blocks );
+            }
+            for ( Blk blk : received )
+                allocator.deallocate( blk );
+            received.clear();
+        }
+
+        release( allocator );
+    };
+
+    double ns = bench_ns( 1, [&] {
+        std::vector< std::thread > workers;
+        for ( size_t t = 0; t < threads; ++t )
+            workers.emplace_back( worker, t );
+        for ( std::thread& t : workers )
+            t.join();
+    } );
+
+    // Blocks passed on after their receiver finished.
+    for ( Handoff& h : handoffs )
+        for ( Blk blk : h.blocks )
+            allocator.deallocate( blk );
+
+    // Nanoseconds per allocate and deallocate pair, across all threads.
+    return ns / double( threads * rounds * 64 );
+}
+
+int main( int argc, char** argv )
+{
+    size_t rounds = bench_quick( argc, argv ) ? 10 : 20000;
+
+    std::printf( "Wall time in nanoseconds per allocate and deallocate pair.\n" );
+    std::printf( "%8s %10s %10s %10s\n", "threads", "malloc", "slab+lock", "pool" );
+
+    for ( size_t threads = 1; threads <= 8; threads *= 2 )
+    {
+        std::printf( "%8zu %10.1f %10.1f %10.1f\n", threads,
+                     run( g_malloc, threads, rounds ),
+                     run( g_slab, threads, rounds ),
+                     run( g_pool, threads, rounds ) );
+    }
+
+    return 0;
+}
@@ -0,0 +1,215 @@
+// Andrew Meckling
+// Stress tests PoolAllocator: threads allocate blocks, fill them, and
+// hand them to other threads, which check the contents and free them.
+// A block handed out twice, or reused while live, fails the check.
+
+#include "Check.hpp"
+
+#include <PoolAllocator.hpp>
+
+#include <atomic>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+using Pool = PoolAllocator< 48, 8192 >;
+
+// A fresh pool for each test. Pools are aligned to cache lines, which
+// new only honours from C++17 on.
+Pool g_pools[ 4 ];
+
+// Senders free a block themselves rather than post it to an inbox this
+// full, so the blocks in flight stay well below the pool's count.
+const size_t INBOX_MAX = 256;
+
+// A block as it's handed between threads.
+struct Parcel
+{
+    Blk           blk;
+    std::uint32_t stamp;
+};
+
+void fill( const Parcel& p )
+{
+    std::uint32_t* words = (std::uint32_t*) p.blk.ptr;
+    for ( size_t i = 0; i < Pool::SIZE / 4; ++i )
+        words[ i ] = p.stamp + std::uint32_t( i );
+}
+
+bool filled( const Parcel& p )
+{
+    const std::uint32_t* words = (const std::uint32_t*) p.blk.ptr;
+    for ( size_t i = 0; i < Pool::SIZE / 4; ++i )
+        if ( words[ i ] != p.stamp + std::uint32_t( i ) )
+            return false;
+    return true;
+}
+
+// One thread's mailbox of blocks from the others.
+struct Inbox
+{
+    std::mutex            lock;
+    std::vector< Parcel > parcels;
+};
+
+// Each thread keeps some blocks of its own and posts the rest to random
+// threads, and checks and frees whatever it's sent.
+void handoff( Pool& pool, size_t threads, size_t rounds )
+{
+    std::vector< Inbox > inboxes( threads );
+    std::atomic< size_t > bad { 0 };
+    std::atomic< size_t > failed { 0 };
+    std::atomic< size_t > done { 0 };
+
+    auto worker = [&]( size_t self ) {
+        std::mt19937 rng( unsigned( 8551 + self ) );
+        std::vector< Parcel > kept;
+        std::vector< Parcel > mail;
+        std::uint32_t next = std::uint32_t( self << 24 );
+
+        auto check_and_free = [&]( const Parcel& p ) {
+            bad += !filled( p );
+            pool.deallocate( p.blk );
+        };
+
+        auto read_mail = [&] {
+            {
+                std::lock_guard< std::mutex > guard( inboxes[ self ].lock );
+                mail.swap( inboxes[ self ].parcels );
+            }
+            for ( const Parcel& p : mail )
+                check_and_free( p );
+            mail.clear();
+        };
+
+        for ( size_t round = 0; round < rounds; ++round )
+        {
+            for ( size_t n = 1 + rng() % 32; n > 0; --n )
+            {
+                Parcel p { pool.allocate( 1 + rng() % Pool::SIZE ), next++ };
+                if ( p.blk.ptr == nullptr )
+                {
+                    ++failed;
+                    continue;
+                }
+                fill( p );
+
+                if ( rng() % 2 == 0 )
+                {
+                    kept.push_back( p );
+                    continue;
+                }
+
+                Inbox& to = inboxes[ rng() % threads ];
+                std::unique_lock< std::mutex > guard( to.lock );
+                if ( to.parcels.size() < INBOX_MAX )
+                {
+                    to.parcels.push_back( p );
+                }
+                else
+                {
+                    guard.unlock();
+                    check_and_free( p );
+                }
+            }
+
+            while ( kept.size() > 64 )
+            {
+                check_and_free( kept.back() );
+                kept.pop_back();
+            }
+
+            read_mail();
+        }
+
+        for ( const Parcel& p : kept )
+            check_and_free( p );
+
+        // Keep reading mail until every thread has stopped posting.
+        ++done;
+        while ( done < threads )
+            read_mail();
+        read_mail();
+
+        pool.release();
+    };
+
+    std::vector< std::thread > pool_threads;
+    for ( size_t t = 0; t < threads; ++t )
+        pool_threads.emplace_back( worker, t );
+    for ( std::thread& t : pool_threads )
+        t.join();
+
+    CHECK( bad == 0 );
+    CHECK( failed == 0 );
+
+    // Every block is back, whichever thread freed it.
+    std::vector< Blk > all;
+    for ( size_t i = 0; i < Pool::COUNT; ++i )
+        all.push_back( pool.allocate( Pool::SIZE ) );
+
+    size_t got = 0;
+    for ( Blk blk : all )
+        got += blk.ptr != nullptr;
+    CHECK( got == Pool::COUNT );
+    CHECK( pool.allocate( 1 ).ptr == nullptr );
+
+    for ( Blk blk : all )
+        pool.deallocate( blk );
+}
+
+// Blocks freed to a thread which has exited wait on its remote-free list,
+// and are reclaimed once the rest of the pool is used up.
+void owner_exited( Pool& pool )
+{
+    std::vector< Blk > blocks;
+
+    std::thread owner( [&] {
+        for ( size_t i = 0; i < Pool::COUNT; ++i )
+            blocks.push_back( pool.allocate( Pool::SIZE ) );
+    } );
+    owner.join();
+
+    CHECK( blocks.size() == Pool::COUNT && blocks.back().ptr != nullptr );
+
+    // Freed here, so every block goes to the exited owner.
+    for ( Blk blk : blocks )
+        pool.deallocate( blk );
+
+    size_t got = 0;
+    for ( size_t i = 0; i < Pool::COUNT; ++i )
+        got += pool.allocate( Pool::SIZE ).ptr != nullptr;
+    CHECK( got == Pool::COUNT );
+}
+
+// A thread which releases the pool before it exits leaves no blocks
+// behind in its magazine.
+void released_before_exit( Pool& pool )
+{
+
+    std::thread user( [&] {
+        std::vector< Blk > blocks;
+        for ( size_t i = 0; i < 100; ++i )
+            blocks.push_back( pool.allocate( Pool::SIZE ) );
+        for ( Blk blk : blocks )
+            pool.deallocate( blk );
+        pool.release();
+    } );
+    user.join();
+
+    size_t got = 0;
+    for ( size_t i = 0; i < Pool::COUNT; ++i )
+        got += pool.allocate( Pool::SIZE ).ptr != nullptr;
+    CHECK( got == Pool::COUNT );
+}
+
+int main()
+{
+    handoff( g_pools[ 0 ], 2, 2000 );
+    handoff( g_pools[ 1 ], 8, 1000 );
+    owner_exited( g_pools[ 2 ] );
+    released_before_exit( g_pools[ 3 ] );
+
+    return check_result();
+}
@@ -0,0 +1,74 @@
+// Andrew Meckling
+// Times a bullet's ray cast among 10k static boxes, a third of which
+// bullets pass through, two ways: the old loop over every fixture of
+// every body, and a cast through the broadphase with the bullet's filter,
+// one ray at a time and batched with b2World::RayCastBatch. Fails if they
+// find different fixtures.
+
+#include "Bench.hpp"
+#include "Box2DScenes.hpp"
+#include "LegacyBulletCast.hpp"
+
+#include <Odin/PhysicalComponent.hpp>
+
+#include <vector>
+
+// EntityFactory.h's category for bullets.
+const uint16 BULLET = 1 << 3;
+
+int main( int argc, char** argv )
+{
+    bool quick = bench_quick( argc, argv );
+    int32 rayCount = quick ? 20 : 2000;
+
+    b2World world( b2Vec2( 0.0f, -10.0f ) );
+    crates( world, 10000, 500.0f, BULLET );
+
+    std::vector< b2RayCastInput > rays( rayCount );
+    random_rays( rays.data(), rayCount, 500.0f, 100.0f, 3 );
+
+    std::vector< b2Fixture* > legacyHits( rayCount ), hits( rayCount );
+
+    size_t i = 0;
+    double legacyNs = bench_ns( rayCount, [&] {
+        const b2RayCastInput& ray = rays[ i ];
+        legacyHits[ i++ ] = legacy_bullet_cast( world, ray.p1, ray.p2, BULLET ).fixture;
+    } );
+
+    b2Filter bulletFilter;
+    bulletFilter.categoryBits = BULLET;
+    bulletFilter.maskBits = 0xFFFF;
+
+    i = 0;
+    double filteredNs = bench_ns( rayCount, [&] {
+        const b2RayCastInput& ray = rays[ i ];
+        odin::ClosestRayHit closest;
+        closest.minFraction = 0.001f;
+        world.RayCast( &closest, ray.p1, ray.p2, bulletFilter );
+        hits[ i++ ] = closest.fixture;
+    } );
+
+    std::vector< b2RayCastResult > results( rayCount );
+    double batchNs = bench_ns( 10, [&] {
+        world.RayCastBatch( rays.data(), results.data(), rayCount, &bulletFilter );
+    } ) / rayCount;
+
+    // The batch also keeps hits at the very start of a ray, which the
+    // game skips; only the other rays are compared.
+    bool batchSame = true;
+    for ( int32 r = 0; r < rayCount; ++r )
+        if ( results[ r ].fraction > 0.001f )
+            batchSame = batchSame && results[ r ].fixture == legacyHits[ r ];
+
+    std::printf( "Microseconds per bullet among 10k static boxes over %d rays.\n", rayCount );
+    std::printf( "%12s %12s %12s\n", "every body", "filtered", "batched" );
+    std::printf( "%12.2f %12.2f %12.2f\n", legacyNs / 1e3, filteredNs / 1e3, batchNs / 1e3 );
+
+    if ( hits != legacyHits || !batchSame )
+    {
+        std::printf( "The casts hit different fixtures.\n" );
+        return 1;
+    }
+
+    return 0;
+}
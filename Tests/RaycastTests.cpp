@@ -0,0 +1,269 @@
+// Andrew Meckling
+// Checks that casting a bullet through the broadphase with a filter finds
+// the same closest fixture as the old loop over every fixture, among
+// static boxes some of which bullets pass through. Also checks that
+// batched ray casts, with a partial last packet and split across threads,
+// find what casting one ray at a time does.
+
+#include "Check.hpp"
+#include "Box2DScenes.hpp"
+#include "LegacyBulletCast.hpp"
+
+#include <Odin/PhysicalComponent.hpp>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+// EntityFactory.h's category for bullets.
+const uint16 BULLET = 1 << 3;
+
+// The cast LevelScene::resolveBulletCollision makes.
+odin::ClosestRayHit bullet_cast( b2World& world, b2Vec2 p1, b2Vec2 p2 )
+{
+    odin::ClosestRayHit closest;
+    closest.minFraction = 0.001f;
+
+    b2Filter bulletFilter;
+    bulletFilter.categoryBits = BULLET;
+    bulletFilter.maskBits = 0xFFFF;
+
+    world.RayCast( &closest, p1, p2, bulletFilter );
+    return closest;
+}
+
+void filtered_cast_matches_the_old_loop()
+{
+    b2World world( b2Vec2( 0.0f, -10.0f ) );
+    crates( world, 2000, 200.0f, BULLET );
+
+    std::vector< b2RayCastInput > rays( 1000 );
+    random_rays( rays.data(), int32( rays.size() ), 220.0f, 40.0f, 7 );
+
+    int32 hits = 0, passedThrough = 0;
+    bool same = true;
+
+    for ( const b2RayCastInput& ray : rays )
+    {
+        LegacyBulletHit expected = legacy_bullet_cast( world, ray.p1, ray.p2, BULLET );
+        odin::ClosestRayHit hit = bullet_cast( world, ray.p1, ray.p2 );
+
+        same = same && hit.fixture == expected.fixture
+            && hit.fraction == expected.fraction
+            && hit.normal.x == expected.normal.x && hit.normal.y == expected.normal.y;
+
+        if ( hit.fixture )
+            ++hits;
+
+        // Without the filter the ray would have stopped sooner.
+        odin::ClosestRayHit unfiltered;
+        unfiltered.minFraction = 0.001f;
+        world.RayCast( &unfiltered, ray.p1, ray.p2 );
+        if ( unfiltered.fixture != hit.fixture )
+        {
+            CHECK( !(unfiltered.fixture->GetFilterData().maskBits & BULLET) );
+            CHECK( unfiltered.fraction < hit.fraction );
+            ++passedThrough;
+        }
+    }
+
+    CHECK( same );
+
+    // The scene exercises both hits and misses, and bullets passing
+    // through boxes.
+    CHECK( hits > 100 && hits < int32( rays.size() ) );
+    CHECK( passedThrough > 10 );
+}
+
+// Decides what a tree callback returns for a proxy: sometimes ignore it,
+// clip the ray, or stop the ray, so the batch has to handle all of them.
+float32 tree_answer( const b2RayCastInput& input, int32 proxyId )
+{
+    if ( proxyId % 11 == 0 )
+        return 0.0f;
+    if ( proxyId % 5 == 0 )
+        return -1.0f;
+    if ( proxyId % 3 == 0 )
+        return 0.9f * input.maxFraction;
+    return input.maxFraction;
+}
+
+// Records the proxies one ray visits.
+struct TreeRayCallback
+{
+    std::vector< std::pair< int32, float32 > > visits;
+
+    float32 RayCastCallback( const b2RayCastInput& input, int32 proxyId )
+    {
+        visits.emplace_back( proxyId, input.maxFraction );
+        return tree_answer( input, proxyId );
+    }
+};
+
+// Records the proxies every ray of a batch visits.
+struct TreeBatchCallback
+{
+    std::vector< std::vector< std::pair< int32, float32 > > > visits;
+
+    float32 RayCastCallback( const b2RayCastInput& input, int32 proxyId, int32 rayIndex )
+    {
+        visits[ rayIndex ].emplace_back( proxyId, input.maxFraction );
+        return tree_answer( input, proxyId );
+    }
+};
+
+// Each ray of a batch sees the same proxies, in the same order and with
+// the same clipping, as the ray cast on its own.
+void tree_batch_matches_single_rays()
+{
+    b2DynamicTree tree;
+
+    uint32 seed = 99;
+    for ( int32 i = 0; i < 3000; ++i )
+    {
+        float32 r[ 2 ];
+        for ( float32& v : r )
+        {
+            seed = seed * 1664525u + 1013904223u;
+            v = (seed >> 8) / float32( 1 << 24 );
+        }
+
+        b2AABB aabb;
+        aabb.lowerBound.Set( (r[ 0 ] - 0.5f) * 200.0f, (r[ 1 ] - 0.5f) * 200.0f );
+        aabb.upperBound = aabb.lowerBound + b2Vec2( 1.0f, 1.5f );
+        tree.CreateProxy( aabb, nullptr );
+    }
+
+    const int32 count = 4 * 250 + 3; // The last packet has 3 rays.
+    std::vector< b2RayCastInput > rays( count );
+    random_rays( rays.data(), count, 220.0f, 40.0f, 5 );
+
+    TreeBatchCallback batch;
+    batch.visits.resize( count );
+    tree.RayCastBatch( &batch, rays.data(), count );
+
+    bool same = true;
+    size_t visits = 0;
+    for ( int32 i = 0; i < count; ++i )
+    {
+        TreeRayCallback single;
+        tree.RayCast( &single, rays[ i ] );
+        same = same && single.visits == batch.visits[ i ];
+        visits += single.visits.size();
+    }
+
+    CHECK( same );
+    CHECK( visits > size_t( count ) );
+}
+
+bool same_results( const b2RayCastResult& a, const b2RayCastResult& b )
+{
+    return a.fixture == b.fixture && a.fraction == b.fraction
+        && a.point.x == b.point.x && a.point.y == b.point.y
+        && a.normal.x == b.normal.x && a.normal.y == b.normal.y;
+}
+
+// Casts a range of a batch; the ranges are cast in parallel.
+class RayCastBatchTask
+    : public b2RangedTask
+{
+public:
+
+    const b2World*        world;
+    const b2RayCastInput* inputs;
+    b2RayCastResult*      results;
+    const b2Filter*       filter;
+
+    void Execute( b2StackAllocator& ) override
+    {
+        world->RayCastBatch( inputs + m_beginIndex, results + m_beginIndex,
+                             m_endIndex - m_beginIndex, filter );
+    }
+};
+
+// The world's batches find the closest fixture b2World::RayCast does,
+// with and without a filter, whether cast at once or split across threads.
+void world_batch_matches_single_rays( const b2Filter* filter )
+{
+    b2World world( b2Vec2( 0.0f, -10.0f ) );
+    crates( world, 2000, 200.0f, BULLET );
+
+    const int32 count = 1001;
+    std::vector< b2RayCastInput > rays( count );
+    random_rays( rays.data(), count, 220.0f, 40.0f, 11 );
+
+    // Some rays are cut short.
+    for ( int32 i = 0; i < count; i += 7 )
+        rays[ i ].maxFraction = 0.5f;
+
+    std::vector< b2RayCastResult > results( count );
+    world.RayCastBatch( rays.data(), results.data(), count, filter );
+
+    bool same = true;
+    int32 hits = 0;
+    for ( int32 i = 0; i < count; ++i )
+    {
+        b2Vec2 end = rays[ i ].p1 + rays[ i ].maxFraction * (rays[ i ].p2 - rays[ i ].p1);
+
+        odin::ClosestRayHit closest;
+        if ( filter )
+            world.RayCast( &closest, rays[ i ].p1, end, *filter );
+        else
+            world.RayCast( &closest, rays[ i ].p1, end );
+
+        // The single cast's fraction is along the shortened ray.
+        same = same && results[ i ].fixture == closest.fixture;
+        if ( closest.fixture )
+        {
+            float32 error = results[ i ].fraction - closest.fraction * rays[ i ].maxFraction;
+            same = same && std::abs( error ) < 1e-5f
+                && results[ i ].normal.x == closest.normal.x
+                && results[ i ].normal.y == closest.normal.y;
+            ++hits;
+        }
+        else
+        {
+            same = same && results[ i ].fraction == rays[ i ].maxFraction;
+        }
+    }
+
+    CHECK( same );
+    CHECK( hits > 100 && hits < count );
+
+    // Split across threads into uneven ranges, most with partial packets.
+    b2ThreadPool pool( 3 );
+    b2StackAllocator allocator;
+    std::vector< b2RayCastResult > parallel( count );
+
+    RayCastBatchTask tasks[ 7 ];
+    for ( RayCastBatchTask& task : tasks )
+    {
+        task.world = &world;
+        task.inputs = rays.data();
+        task.results = parallel.data();
+        task.filter = filter;
+    }
+
+    b2TaskGroup group( pool );
+    group.SubmitRangedTasks( tasks, 7, count, allocator );
+    group.Wait( allocator );
+
+    bool sameParallel = true;
+    for ( int32 i = 0; i < count; ++i )
+        sameParallel = sameParallel && same_results( results[ i ], parallel[ i ] );
+    CHECK( sameParallel );
+}
+
+int main()
+{
+    filtered_cast_matches_the_old_loop();
+    tree_batch_matches_single_rays();
+
+    b2Filter bulletFilter;
+    bulletFilter.categoryBits = BULLET;
+    bulletFilter.maskBits = 0xFFFF;
+    world_batch_matches_single_rays( nullptr );
+    world_batch_matches_single_rays( &bulletFilter );
+
+    return check_result();
+}
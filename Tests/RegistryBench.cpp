@@ -0,0 +1,196 @@
+// Andrew Meckling
+// Times LevelScene's per-frame entity passes over 10k entities two ways:
+// the old map of names to entities pointing into TypedAllocator slabs,
+// and the registry's packed pools and views. A frame copies body
+// transforms, ticks animators, fades the fading ones, and queues every
+// drawable into a SpriteBatch in name order; the batch isn't drawn.
+// Every entity has a drawable, every second one an animator (one in ten
+// of those fading) and every fourth one a body. Both passes run on one
+// thread. Skipped where there's no GL, which the drawables need.
+
+#include "Bench.hpp"
+#include "HeadlessGL.hpp"
+#include "LegacyEntity.hpp"
+
+#include <Odin/Registry.hpp>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+const size_t ENTITIES = 10000;
+
+// LevelScene's Transform.
+struct Transform
+{
+    glm::vec2 position = { 0, 0 };
+    float     rotation = 0;
+};
+
+struct Scene
+{
+    b2World world { b2Vec2( 0.0f, -10.0f ) };
+
+    // Old entities.
+    LegacyEntityMap                                                  entities;
+    std::unique_ptr< TypedAllocator< odin::GraphicalComponent, ENTITIES > > graphics { new TypedAllocator< odin::GraphicalComponent, ENTITIES > };
+    std::unique_ptr< TypedAllocator< odin::AnimatorComponent, ENTITIES > >  animations { new TypedAllocator< odin::AnimatorComponent, ENTITIES > };
+
+    odin::Registry registry;
+};
+
+odin::GraphicalComponent make_drawable( size_t i )
+{
+    odin::GraphicalComponent gfx;
+    gfx.size = { 16, 16 };
+    gfx.texture = int( i / 64 % 4 );
+    return gfx;
+}
+
+odin::AnimatorComponent make_animator( size_t i )
+{
+    return i % 20 == 0
+        ? odin::AnimatorComponent( { 1000 }, odin::FADEOUT )
+        : odin::AnimatorComponent( { 4, 4, 2 } );
+}
+
+// Creates the same entities both ways, named in a shuffled order like
+// the game's mix of tiles, players and bullets.
+void populate( Scene& scene, size_t count )
+{
+    std::mt19937 rng( 8551 );
+    std::uniform_real_distribution< float > coord( -100.0f, 100.0f );
+
+    std::vector< odin::EntityId > names;
+    for ( size_t i = 0; i < count; ++i )
+    {
+        if ( i % 2 )
+            names.push_back( odin::EntityId( "tile", std::uint16_t( i ) ) );
+        else
+            names.push_back( odin::EntityId( "crate", std::uint16_t( i ) ) );
+    }
+    std::shuffle( names.begin(), names.end(), rng );
+
+    b2BodyDef def;
+
+    for ( size_t i = 0; i < count; ++i )
+    {
+        b2Body* body = nullptr;
+        if ( i % 4 == 0 )
+        {
+            def.position.Set( coord( rng ), coord( rng ) );
+            def.angle = coord( rng );
+            body = scene.world.CreateBody( &def );
+        }
+
+        LegacyEntity& ntt = scene.entities[ names[ i ] ];
+        ntt.pBody = body;
+        ntt.pDrawable = ALLOC( *scene.graphics, odin::GraphicalComponent )( make_drawable( i ) );
+        if ( i % 2 == 0 )
+            ntt.pAnimator = ALLOC( *scene.animations, odin::AnimatorComponent )( make_animator( i ) );
+
+        odin::EntityIndex e = scene.registry.create().index;
+        scene.registry.emplace< odin::EntityId >( e, names[ i ] );
+        scene.registry.emplace< Transform >( e );
+        if ( body )
+            scene.registry.emplace< b2Body* >( e, body );
+        scene.registry.emplace< odin::GraphicalComponent >( e, make_drawable( i ) );
+        if ( i % 2 == 0 )
+            scene.registry.emplace< odin::AnimatorComponent >( e, make_animator( i ) );
+    }
+}
+
+// LevelScene's update and draw passes, one thread.
+void registry_frame( odin::Registry& registry, odin::SpriteBatch& batch )
+{
+    // syncTransforms
+    auto& bodies = registry.pool< b2Body* >();
+    auto& transforms = registry.pool< Transform >();
+    const odin::EntityIndex* ents = bodies.entities();
+    b2Body* const* body = bodies.data();
+    for ( size_t i = 0; i < bodies.size(); ++i )
+    {
+        Transform& tf = transforms.get( ents[ i ] );
+        b2Vec2 pos = body[ i ]->GetPosition();
+        tf.position = glm::round( glm::vec2( pos.x, pos.y ) * 10.0f );
+        tf.rotation = body[ i ]->GetAngle();
+    }
+
+    // tickAnimators
+    auto& animators = registry.pool< odin::AnimatorComponent >();
+    odin::AnimatorComponent* anims = animators.data();
+    for ( size_t i = 0; i < animators.size(); ++i )
+        anims[ i ].incrementFrame();
+
+    // The fade pass of update.
+    registry.view< odin::AnimatorComponent, odin::GraphicalComponent >().each(
+        []( odin::EntityIndex, odin::AnimatorComponent& animator, odin::GraphicalComponent& drawable ) {
+            if ( animator.type == odin::AnimationType::FADEOUT
+                 && animator.currentFrame != animator.maxFrames - 1 )
+            {
+                drawable.color.a = 1.f - (float) animator.currentFrame / (float) animator.maxFrames;
+            }
+        } );
+
+    // draw
+    auto& names = registry.pool< odin::EntityId >();
+    registry.pool< odin::GraphicalComponent >().sort(
+        [&names]( odin::EntityIndex a, odin::EntityIndex b ) {
+            return names.get( a ) < names.get( b );
+        } );
+
+    registry.view< odin::GraphicalComponent, Transform >().each(
+        [&]( odin::EntityIndex e, odin::GraphicalComponent& drawable, Transform& tf ) {
+            if ( drawable.visible )
+                batch.add( drawable, animators.find( e ), tf.position, tf.rotation, drawable.color );
+        } );
+}
+
+void legacy_frame( LegacyEntityMap& entities, odin::SpriteBatch& batch )
+{
+    legacy_sync_transforms( entities );
+    legacy_tick_animators( entities );
+    legacy_draw_prep( entities, batch );
+}
+
+int main( int argc, char** argv )
+{
+    bool quick = bench_quick( argc, argv );
+
+    if ( !headless_gl( 64, 64 ) )
+        return GL_SKIPPED;
+
+    size_t count = quick ? ENTITIES / 10 : ENTITIES;
+    size_t frames = quick ? 2 : 200;
+
+    std::unique_ptr< Scene > scene( new Scene );
+    populate( *scene, count );
+
+    const glm::mat4 camera = glm::ortho( 0.0f, 64.0f, 0.0f, 64.0f );
+    odin::SpriteBatch batch( 0, count );
+
+    // The first frame sorts the drawables by name; later frames only
+    // check that they still are, which is what's timed.
+    batch.begin( camera );
+    legacy_frame( scene->entities, batch );
+    batch.begin( camera );
+    registry_frame( scene->registry, batch );
+
+    double legacyNs = bench_ns( frames, [&] {
+        batch.begin( camera );
+        legacy_frame( scene->entities, batch );
+    } );
+
+    double registryNs = bench_ns( frames, [&] {
+        batch.begin( camera );
+        registry_frame( scene->registry, batch );
+    } );
+
+    std::printf( "Microseconds per frame of update and draw-prep, %zu entities, %zu frames.\n", count, frames );
+    std::printf( "%14s %14s\n", "map + slabs", "registry" );
+    std::printf( "%14.1f %14.1f\n", legacyNs / 1e3, registryNs / 1e3 );
+
+    return 0;
+}
@@ -0,0 +1,144 @@
+// Andrew Meckling
+// Checks that handles, component refs and body user data of a destroyed
+// entity stay stale after its index is reused.
+
+#include "Check.hpp"
+
+#include <Odin/PhysicalComponent.hpp>
+#include <Odin/Registry.hpp>
+
+#include <string>
+
+using namespace odin;
+
+// A stale handle isn't valid, finds nothing and can't be destroyed again,
+// even though a live entity now has its index.
+void stale_handle()
+{
+    Registry registry;
+
+    Handle first = registry.create();
+    registry.emplace< int >( first, 1 );
+    CHECK( registry.valid( first ) );
+    CHECK( registry.destroy( first ) );
+
+    Handle second = registry.create();
+    CHECK( second.index == first.index );
+    CHECK( second != first );
+    registry.emplace< int >( second, 2 );
+
+    CHECK( !registry.valid( first ) );
+    CHECK( registry.valid( second ) );
+    CHECK( registry.find< int >( first ) == nullptr );
+    CHECK( !registry.has< int >( first ) );
+    CHECK( !registry.remove< int >( first ) );
+    CHECK( !registry.destroy( first ) );
+
+    // The stale calls left the new entity alone.
+    CHECK( registry.count() == 1 );
+    CHECK( registry.find< int >( second ) && *registry.find< int >( second ) == 2 );
+
+    bool threw = false;
+    try
+    {
+        registry.get< int >( first );
+    }
+    catch ( const char* )
+    {
+        threw = true;
+    }
+    CHECK( threw );
+}
+
+// A ref made before its entity was destroyed doesn't find the component
+// of the entity which reuses the index, whether the ref was made from a
+// handle or from an index.
+void ref_to_reused_index()
+{
+    Registry registry;
+
+    Handle first = registry.create();
+    registry.emplace< std::string >( first, "first" );
+    ComponentRef< std::string > byHandle = registry.ref< std::string >( first );
+    ComponentRef< std::string > byIndex = registry.ref< std::string >( first.index );
+    CHECK( byHandle && *byHandle == "first" );
+    CHECK( byIndex && *byIndex == "first" );
+    CHECK( byIndex.handle() == first );
+
+    registry.destroy( first );
+    Handle second = registry.create();
+    registry.emplace< std::string >( second, "second" );
+    CHECK( second.index == first.index );
+
+    CHECK( !byHandle );
+    CHECK( !byIndex );
+    CHECK( byHandle.get() == nullptr );
+
+    ComponentRef< std::string > fresh = registry.ref< std::string >( second );
+    CHECK( fresh && *fresh == "second" );
+
+    registry.clear();
+    CHECK( !fresh );
+}
+
+// A ref follows its component while the pool moves components around.
+void ref_survives_pool_changes()
+{
+    Registry registry;
+
+    Handle a = registry.create();
+    Handle b = registry.create();
+    registry.emplace< int >( a, 1 );
+    registry.emplace< int >( b, 2 );
+    ComponentRef< int > ref = registry.ref< int >( b );
+
+    // b's component moves into a's slot.
+    registry.remove< int >( a );
+    CHECK( ref && *ref == 2 );
+
+    registry.remove< int >( b );
+    CHECK( !ref );
+
+    registry.emplace< int >( b, 3 );
+    CHECK( ref && *ref == 3 );
+
+    CHECK( !ComponentRef< int >() );
+}
+
+// The user data of a destroyed entity's body doesn't resolve to the
+// entity which reuses the index.
+void body_of_reused_index()
+{
+    Registry registry;
+    b2World world( b2Vec2( 0.0f, -10.0f ) );
+
+    b2BodyDef def;
+    b2Body* none = world.CreateBody( &def );
+    CHECK( body_entity( none, registry ) == Handle {} );
+
+    registry.create();
+    Handle first = registry.create();
+    def.userData = body_user_data( first );
+    b2Body* body = world.CreateBody( &def );
+    CHECK( body_entity( body, registry ) == first );
+
+    registry.destroy( first );
+    CHECK( !registry.valid( body_entity( body, registry ) ) );
+
+    Handle second = registry.create();
+    CHECK( second.index == first.index );
+    CHECK( !registry.valid( body_entity( body, registry ) ) );
+
+    def.userData = body_user_data( second );
+    CHECK( body_entity( world.CreateBody( &def ), registry ) == second );
+}
+
+int main()
+{
+    stale_handle();
+    ref_to_reused_index();
+    ref_survives_pool_changes();
+    body_of_reused_index();
+
+    return check_result();
+}
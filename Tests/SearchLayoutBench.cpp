@@ -0,0 +1,69 @@
+// Andrew Meckling
+// Times BinarySearchMap lookups of random keys with each layout, from
+// maps small enough to scan up to a million keys.
+
+#include "Bench.hpp"
+
+#include <Odin/BinarySearchMap.hpp>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using odin::BinarySearchMap;
+using odin::MapEntry;
+
+using Key = std::uint64_t;
+
+template< template< typename > class Layout >
+double lookup_ns( const std::vector< MapEntry< Key, std::uint32_t > >& entries,
+                  const std::vector< Key >& queries )
+{
+    using Map = BinarySearchMap< Key, std::uint32_t, Layout >;
+
+    std::vector< MapEntry< Key, std::uint32_t > > copy = entries;
+    Map map( entries.size() );
+    map.insert_range( copy.begin(), copy.end() );
+
+    // Build the layout's index outside of the timing.
+    bench_keep( size_t( map.search( queries[ 0 ] ) != nullptr ) );
+
+    size_t q = 0;
+    size_t found = 0;
+    double ns = bench_ns( queries.size(), [&] {
+        found += *map.search( queries[ q++ ] );
+    } );
+    bench_keep( found );
+    return ns;
+}
+
+int main( int argc, char** argv )
+{
+    bool quick = bench_quick( argc, argv );
+    size_t lookups = quick ? 1000 : 2000000;
+
+    std::printf( "Nanoseconds per lookup of a random key in the map.\n" );
+    std::printf( "%8s %10s %10s\n", "keys", "sorted", "eytzinger" );
+
+    std::mt19937_64 rng( 8551 );
+    for ( size_t n = 64; n <= (quick ? 1024 : 1024 * 1024); n *= 4 )
+    {
+        std::vector< MapEntry< Key, std::uint32_t > > entries( n );
+        for ( size_t i = 0; i < n; ++i )
+            entries[ i ] = { rng(), std::uint32_t( i ) };
+        std::sort( entries.begin(), entries.end(),
+            []( const MapEntry< Key, std::uint32_t >& a, const MapEntry< Key, std::uint32_t >& b ) {
+                return a.key < b.key;
+            } );
+
+        std::vector< Key > queries( lookups );
+        for ( Key& key : queries )
+            key = entries[ rng() % n ].key;
+
+        std::printf( "%8zu %10.1f %10.1f\n", n,
+                     lookup_ns< odin::SortedLayout >( entries, queries ),
+                     lookup_ns< odin::EytzingerLayout >( entries, queries ) );
+    }
+
+    return 0;
+}
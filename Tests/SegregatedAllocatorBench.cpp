@@ -0,0 +1,131 @@
+// Andrew Meckling
+// Replays an allocation trace shaped like a LevelScene match through the
+// scene's allocators. Each frame fires a few bullets, whose bases live
+// until they hit something; records component commands which die at the
+// end of the frame; builds sound event strings which die the next frame;
+// and grows particle buffers on hits. The game itself needs Windows to
+// run, so the trace is generated rather than recorded.
+
+#include "Bench.hpp"
+
+#include <Allocators.hpp>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+struct Op
+{
+    bool   allocate;
+    size_t id;   // Allocation the op refers to.
+    size_t size;
+};
+
+std::vector< Op > make_trace( size_t frames, size_t& allocations )
+{
+    std::mt19937 rng( 8551 );
+    std::vector< Op > trace;
+    std::vector< std::vector< size_t > > dies( frames + 128 ); // Frame -> ids freed then.
+    size_t next = 0;
+
+    auto allocate = [&]( size_t size, size_t frame, size_t lifetime ) {
+        trace.push_back( { true, next, size } );
+        dies[ frame + lifetime ].push_back( next++ );
+    };
+
+    for ( size_t frame = 0; frame < frames; ++frame )
+    {
+        size_t bullets = rng() % 4;
+        for ( size_t b = 0; b < bullets; ++b )
+        {
+            allocate( 24, frame, 20 + rng() % 70 );  // EntityBullet base.
+            for ( int c = 0; c < 3; ++c )            // Component commands.
+                allocate( 24 + 8 * (rng() % 6), frame, 0 );
+        }
+
+        for ( size_t s = rng() % 4; s > 0; --s )     // Sound event strings.
+            allocate( 22 + rng() % 24, frame, 1 );
+
+        if ( rng() % 8 == 0 )                        // Particle burst on a hit.
+        {
+            for ( size_t size = 64; size <= 4096; size *= 2 )
+                allocate( size, frame, 30 );
+        }
+
+        for ( size_t id : dies[ frame ] )
+            trace.push_back( { false, id, 0 } );
+    }
+
+    for ( size_t frame = frames; frame < dies.size(); ++frame )
+        for ( size_t id : dies[ frame ] )
+            trace.push_back( { false, id, 0 } );
+
+    allocations = next;
+    return trace;
+}
+
+template< typename Allocator >
+void replay( const char* name, const std::vector< Op >& trace, size_t allocations, size_t reps )
+{
+    std::unique_ptr< Allocator > allocator( new Allocator );
+    std::vector< Blk > blocks( allocations );
+    size_t failed = 0;
+
+    double ns = bench_ns( reps, [&] {
+        for ( const Op& op : trace )
+        {
+            if ( op.allocate )
+            {
+                blocks[ op.id ] = allocator->allocate( op.size );
+                failed += blocks[ op.id ].ptr == nullptr;
+            }
+            else
+            {
+                allocator->deallocate( blocks[ op.id ] );
+            }
+        }
+    } );
+
+    std::printf( "%-24s %10.1f %8zu\n", name, ns / trace.size(), failed );
+}
+
+// The two tier allocator LevelScene had commented out.
+using OldLocalAllocator =
+    ThresholdAllocator< 4,
+        BitsetAllocator< 1024 * 2, 4 >,
+        ThresholdAllocator< 128,
+            BitsetAllocator< 1024 * 1024, 8 >,
+            Mallocator
+        >
+    >;
+
+// LevelScene's allocator for entity bases.
+using LocalAllocator = SegregatedAllocator<
+    SlabAllocator< 32, 1024 >
+>;
+
+// With classes for the commands and strings too.
+using WideAllocator = SegregatedAllocator<
+    SlabAllocator< 32, 1024 >,
+    SlabAllocator< 64, 1024 >,
+    SlabAllocator< 128, 256 >
+>;
+
+int main( int argc, char** argv )
+{
+    bool quick = bench_quick( argc, argv );
+
+    size_t allocations;
+    std::vector< Op > trace = make_trace( quick ? 60 : 6000, allocations );
+    size_t reps = quick ? 1 : 100;
+
+    std::printf( "%zu allocations; nanoseconds per allocate or deallocate.\n", allocations );
+    std::printf( "%-24s %10s %8s\n", "allocator", "ns/op", "failed" );
+
+    replay< Mallocator >( "malloc", trace, allocations, reps );
+    replay< OldLocalAllocator >( "threshold + bitsets", trace, allocations, reps );
+    replay< LocalAllocator >( "segregated, 32", trace, allocations, reps );
+    replay< WideAllocator >( "segregated, 32-128", trace, allocations, reps );
+
+    return 0;
+}
@@ -0,0 +1,190 @@
+// Andrew Meckling
+// Draws N sprites a frame into a 1280x720 offscreen framebuffer, the way
+// LevelScene::draw did before SpriteBatch (about ten uniforms and a draw
+// call per sprite) and with SpriteBatch, and counts the draw calls and
+// buffer uploads of each. Sprites come in runs of 64 sharing one of four
+// texture units, like tiles and HUD coins. Runs on whatever EGL gives,
+// which is llvmpipe under Mesa; skipped where there's no GL.
+
+#include "Bench.hpp"
+#include "HeadlessGL.hpp"
+
+#include <Odin/SpriteBatch.hpp>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <random>
+#include <vector>
+
+const int WIDTH = 1280;
+const int HEIGHT = 720;
+const int TEXTURES = 4;
+
+struct Sprite
+{
+    odin::GraphicalComponent gfx;
+    odin::AnimatorComponent  anim;
+    glm::vec2                position;
+    float                    rotation;
+};
+
+std::vector< Sprite > make_sprites( size_t n )
+{
+    std::mt19937 rng( 8551 );
+    std::uniform_real_distribution< float > x( 0, WIDTH ), y( 0, HEIGHT ), angle( 0, 6.28f );
+
+    std::vector< Sprite > sprites;
+    sprites.reserve( n );
+    for ( size_t i = 0; i < n; ++i )
+    {
+        Sprite s { odin::GraphicalComponent::makeRect( 16, 16 ), { 4, 4, 2 }, { x( rng ), y( rng ) }, angle( rng ) };
+        s.gfx.texture = int( i / 64 % TEXTURES );
+        s.gfx.direction = i % 2 ? odin::RIGHT : odin::LEFT;
+        s.anim.currentFrame = int( i % 4 );
+        sprites.push_back( std::move( s ) );
+    }
+    return sprites;
+}
+
+// Small checkered textures on units 0 to TEXTURES - 1.
+void make_textures()
+{
+    std::vector< GLuint > pixels( 32 * 32 );
+    for ( size_t i = 0; i < pixels.size(); ++i )
+        pixels[ i ] = (i / 32 + i) % 2 ? 0xffffffff : 0x80404040;
+
+    for ( int unit = 0; unit < TEXTURES; ++unit )
+    {
+        GLuint texture;
+        glGenTextures( 1, &texture );
+        glActiveTexture( GL_TEXTURE0 + unit );
+        glBindTexture( GL_TEXTURE_2D, texture );
+        glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA8, 32, 32, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data() );
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+    }
+}
+
+// LevelScene::draw before SpriteBatch.
+class PerSpriteDraw
+{
+public:
+
+    PerSpriteDraw()
+        : program( load_shaders( ODIN_SHADERS "vertexAnim.glsl", ODIN_SHADERS "fragmentShader.glsl" ) )
+        , uMatrix( glGetUniformLocation( program, "uMatrix" ) )
+        , uColor( glGetUniformLocation( program, "uColor" ) )
+        , uTexture( glGetUniformLocation( program, "uTexture" ) )
+        , uFacingDirection( glGetUniformLocation( program, "uFacingDirection" ) )
+        , uCurrentFrame( glGetUniformLocation( program, "uCurrentFrame" ) )
+        , uCurrentAnim( glGetUniformLocation( program, "uCurrentAnim" ) )
+        , uMaxFrame( glGetUniformLocation( program, "uMaxFrames" ) )
+        , uMaxAnim( glGetUniformLocation( program, "uTotalAnim" ) )
+        , uSilhoutte( glGetUniformLocation( program, "uSilhoutte" ) )
+        , uInteractive( glGetUniformLocation( program, "uInteractive" ) )
+    {
+    }
+
+    void draw( const glm::mat4& cameraMatrix, const std::vector< Sprite >& sprites )
+    {
+        using namespace glm;
+
+        glUseProgram( program );
+        glUniform( uSilhoutte, 1.0f );
+
+        for ( const Sprite& s : sprites )
+        {
+            mat4 mtx = cameraMatrix * translate( mat4( 1 ), vec3( s.position, 0 ) );
+            mtx = rotate( mtx, s.rotation, vec3( 0, 0, 1 ) );
+
+            glUniform( uMatrix, mtx );
+            glUniform( uColor, s.gfx.color );
+            glUniform( uTexture, s.gfx.texture );
+            glUniform( uFacingDirection, int( s.gfx.direction ) );
+            glUniform( uInteractive, int( s.gfx.interactive ) );
+            glUniform( uCurrentAnim, (float) s.anim.animState );
+            glUniform( uCurrentFrame, (float) s.anim.currentFrame );
+            glUniform( uMaxFrame, (float) s.anim.maxFrames );
+            glUniform( uMaxAnim, (float) s.anim.totalAnim );
+
+            glBindVertexArray( s.gfx.vertexArray );
+            counted_draw_arrays( GL_TRIANGLES, 0, s.gfx.count );
+        }
+    }
+
+private:
+
+    GLuint program;
+    GLint  uMatrix, uColor, uTexture, uFacingDirection, uCurrentFrame,
+           uCurrentAnim, uMaxFrame, uMaxAnim, uSilhoutte, uInteractive;
+};
+
+struct Frames
+{
+    double ms;
+    double drawCalls;
+    double uploads;
+};
+
+// Times frames including the GL work, so glFinish ends each one.
+template< typename DrawFn >
+Frames time_frames( size_t frames, DrawFn&& draw )
+{
+    draw(); // Warm up the driver's buffers and shader variants.
+    glFinish();
+
+    reset_gl_counters();
+    double ns = bench_ns( frames, [&] {
+        glClear( GL_COLOR_BUFFER_BIT );
+        draw();
+        glFinish();
+    } );
+
+    return { ns / 1e6, double( gl_counters().drawCalls ) / frames,
+             double( gl_counters().uploads ) / frames };
+}
+
+int main( int argc, char** argv )
+{
+    bool quick = bench_quick( argc, argv );
+
+    if ( !headless_gl( WIDTH, HEIGHT ) )
+        return GL_SKIPPED;
+
+    make_textures();
+
+    const glm::mat4 camera = glm::ortho( 0.0f, float( WIDTH ), 0.0f, float( HEIGHT ) );
+    PerSpriteDraw perSprite;
+    odin::SpriteBatch batch( load_shaders( ODIN_SHADERS "vertexInstanced.glsl", ODIN_SHADERS "fragmentInstanced.glsl" ) );
+
+    std::printf( "\n%s, %dx%d. Per frame:\n", headless_gl_renderer(), WIDTH, HEIGHT );
+    std::printf( "%8s | %10s %8s %8s | %10s %8s %8s\n",
+                 "sprites", "per sprite", "draws", "uploads", "batch", "draws", "uploads" );
+
+    const size_t counts[] = { 1000, 10000, 50000 };
+    for ( size_t n : counts )
+    {
+        if ( quick )
+            n /= 10;
+
+        std::vector< Sprite > sprites = make_sprites( n );
+        size_t frames = quick ? 1 : 20;
+
+        Frames old = time_frames( frames, [&] {
+            perSprite.draw( camera, sprites );
+        } );
+
+        Frames batched = time_frames( frames, [&] {
+            batch.begin( camera );
+            for ( const Sprite& s : sprites )
+                batch.add( s.gfx, &s.anim, s.position, s.rotation );
+            batch.end();
+        } );
+
+        std::printf( "%8zu | %8.2fms %8.0f %8.0f | %8.2fms %8.0f %8.0f\n", n,
+                     old.ms, old.drawCalls, old.uploads,
+                     batched.ms, batched.drawCalls, batched.uploads );
+    }
+
+    return 0;
+}
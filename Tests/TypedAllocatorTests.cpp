@@ -0,0 +1,146 @@
+// Andrew Meckling
+// Checks TypedAllocator's free list and its occupancy bitmap: freed slots
+// are reused last in, first out, and for_each_live visits exactly the
+// occupied slots, in order, across the 64-slot words of the bitmap.
+
+#include "Check.hpp"
+
+#include <TypedAllocator.hpp>
+
+#include <memory>
+#include <vector>
+
+// Not a multiple of 64, so the last word of the bitmap is partly used.
+const size_t SLOTS = 200;
+
+using Slab = TypedAllocator< int, SLOTS >;
+
+size_t slot_of( Slab& slab, Blk blk )
+{
+    return (int*) blk.ptr - slab.slots;
+}
+
+// The most recently freed slot is handed out first; fresh slots come in
+// order.
+void lifo_reuse()
+{
+    std::unique_ptr< Slab > slab( new Slab );
+
+    for ( size_t i = 0; i < 5; ++i )
+        CHECK( slot_of( *slab, slab->allocate() ) == i );
+
+    slab->deallocate( slab->slots + 1 );
+    slab->deallocate( slab->slots + 3 );
+    slab->deallocate( slab->slots + 2 );
+
+    CHECK( slot_of( *slab, slab->allocate() ) == 2 );
+    CHECK( slot_of( *slab, slab->allocate() ) == 3 );
+    CHECK( slot_of( *slab, slab->allocate() ) == 1 );
+    CHECK( slot_of( *slab, slab->allocate() ) == 5 );
+
+    // Freeing null does nothing.
+    slab->deallocate( nullptr );
+    CHECK( slab->count() == 6 );
+}
+
+// count() and occupied() follow allocations and frees, and a full slab
+// returns null.
+void count_and_occupied()
+{
+    std::unique_ptr< Slab > slab( new Slab );
+    CHECK( slab->count() == 0 );
+
+    for ( size_t i = 0; i < SLOTS; ++i )
+    {
+        CHECK( !slab->occupied( i ) );
+        CHECK( slab->allocate().ptr != nullptr );
+        CHECK( slab->occupied( i ) );
+        CHECK( slab->count() == i + 1 );
+    }
+
+    CHECK( slab->allocate().ptr == nullptr );
+    CHECK( slab->count() == SLOTS );
+
+    slab->deallocate( slab->slots + 64 );
+    slab->deallocate( slab->slots + SLOTS - 1 );
+    CHECK( !slab->occupied( 64 ) );
+    CHECK( !slab->occupied( SLOTS - 1 ) );
+    CHECK( slab->occupied( 63 ) && slab->occupied( 65 ) );
+    CHECK( slab->count() == SLOTS - 2 );
+
+    CHECK( slot_of( *slab, slab->allocate() ) == SLOTS - 1 );
+    CHECK( slot_of( *slab, slab->allocate() ) == 64 );
+    CHECK( slab->allocate().ptr == nullptr );
+}
+
+// Returns the slots for_each_live visits, in the order it visits them.
+std::vector< size_t > visited( Slab& slab )
+{
+    std::vector< size_t > slots;
+    slab.for_each_live( [&]( int& slot ) { slots.push_back( &slot - slab.slots ); } );
+    return slots;
+}
+
+// Returns the occupied slots, in order, by asking occupied() of each.
+std::vector< size_t > occupied( const Slab& slab )
+{
+    std::vector< size_t > slots;
+    for ( size_t i = 0; i < SLOTS; ++i )
+        if ( slab.occupied( i ) )
+            slots.push_back( i );
+    return slots;
+}
+
+// for_each_live visits the occupied slots in order after frees which
+// empty a whole word, straddle word boundaries and reach into the last,
+// partly used word, and lets fn free the slot it's given.
+void for_each_live_in_order()
+{
+    std::unique_ptr< Slab > slab( new Slab );
+    CHECK( visited( *slab ).empty() );
+
+    for ( size_t i = 0; i < SLOTS; ++i )
+        slab->allocate();
+    CHECK( visited( *slab ) == occupied( *slab ) );
+    CHECK( visited( *slab ).size() == SLOTS );
+
+    // Empty the second word, and free around the other boundaries.
+    for ( size_t i = 64; i < 128; ++i )
+        slab->deallocate( slab->slots + i );
+    const size_t freed[] = { 0, 62, 63, 128, 129, 191, 192, 198 };
+    for ( size_t i : freed )
+        slab->deallocate( slab->slots + i );
+
+    std::vector< size_t > live = visited( *slab );
+    CHECK( live == occupied( *slab ) );
+    CHECK( live.size() == slab->count() );
+    CHECK( live.size() == SLOTS - 64 - 8 );
+    CHECK( live.front() == 1 && live.back() == SLOTS - 1 );
+
+    // Reallocated slots are visited in slot order, not allocation order.
+    slab->allocate();
+    slab->allocate();
+    slab->allocate();
+    CHECK( visited( *slab ) == occupied( *slab ) );
+    CHECK( slab->occupied( 192 ) && slab->occupied( 198 ) && slab->occupied( 191 ) );
+
+    // Free every other live slot from within the walk.
+    size_t calls = 0;
+    size_t before = slab->count();
+    slab->for_each_live( [&]( int& slot ) {
+        if ( calls++ % 2 == 0 )
+            slab->deallocate( &slot );
+    } );
+    CHECK( calls == before );
+    CHECK( slab->count() == before / 2 );
+    CHECK( visited( *slab ) == occupied( *slab ) );
+}
+
+int main()
+{
+    lifo_reuse();
+    count_and_occupied();
+    for_each_live_in_order();
+
+    return check_result();
+}